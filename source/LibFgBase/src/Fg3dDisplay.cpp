@@ -11,6 +11,7 @@
 #include "FgFileSystem.hpp"
 #include "FgTestUtils.hpp"
 #include "Fg3dMeshIo.hpp"
+#include "FgFileCache.hpp"
 #include "Fg3dTopology.hpp"
 #include "FgCommand.hpp"
 #include "FgStdSet.hpp"
@@ -720,7 +721,7 @@ linkLoadMesh(NPT<Ustring> pathBaseN)
             if (pathBase.empty())
                 return Mesh();                      // Deselected
             else
-                return loadTri(pathBase+".tri");
+                return *loadMeshCached(pathBase+".tri");    // Reselection need not parse the file again
             //else if (pathExists(pathBase+".fgMesh"))
             //    loadFgmesh(pathBase+".fgmesh",mesh);
         });
@@ -734,7 +735,7 @@ linkLoadImage(NPT<Ustring> filenameN)
         {
             img.clear();        // Ensure cleared in case load fails.
             if (!fn.empty())
-                loadImage_(fn,img);
+                img = *loadImageCached(fn);
         });
 }
 
@@ -30,6 +30,7 @@
 #include "FgParse.hpp"
 #include "Fg3dNormals.hpp"
 #include "FgTestUtils.hpp"
+#include "FgTextWriter.hpp"
 
 using namespace std;
 
@@ -75,7 +76,7 @@ cEffect(string const & id)
 string
 cGeometryVerts(string const & id,Vec3Fs const & verts,Vec3Fs const & norms,Vec2Fs const & uvs)
 {
-    ostringstream       ofs;
+    TextWriter          ofs;
     ofs.precision(7);
     ofs << "\n"
         "        <source id=\"" << id << "Coords\">\n"
@@ -129,7 +130,7 @@ cGeometryVerts(string const & id,Vec3Fs const & verts,Vec3Fs const & norms,Vec2F
 string
 cGeometrySurfs(Surfs const & surfs,string const & id,size_t mm)
 {
-    ostringstream       ofs;
+    TextWriter          ofs;
     for (size_t ss=0; ss<surfs.size(); ++ss) {
         Surf const &     surf = surfs[ss];
         bool        hasUVs = (surf.tris.hasUvs() && surf.quads.hasUvs());
@@ -312,7 +313,7 @@ saveDae(Ustring const & filename,Meshes const & meshes,string imgFormat,SpatialU
             }
         }
     }
-    Ofstream            ofs {dirBase+".dae"};
+    TextWriter          ofs {dirBase+".dae"};
     ofs << R"(<?xml version="1.0" encoding="UTF-8"?>
 <COLLADA xmlns="http://www.collada.org/2005/11/COLLADASchema" version="1.4.1">
   <asset>
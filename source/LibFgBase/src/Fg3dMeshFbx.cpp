@@ -21,6 +21,7 @@
 #include "Fg3dNormals.hpp"
 #include "FgCommand.hpp"
 #include "FgTestUtils.hpp"
+#include "FgTextWriter.hpp"
 
 using namespace std;
 
@@ -80,7 +81,7 @@ saveFbx(
     FGASSERT(!meshes.empty());
     Path      path(filename);
     path.ext = "fbx";
-    Ofstream  ofs(path.str());
+    TextWriter  ofs(path.str());
     ofs.precision(7);
     ofs <<
         "; FBX 7.4.0 project file\n"
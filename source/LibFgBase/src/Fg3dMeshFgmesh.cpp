@@ -9,13 +9,17 @@
 #include "stdafx.h"
 
 #include "Fg3dMeshIo.hpp"
+#include "Fg3dMeshStream.hpp"
 #include "FgException.hpp"
 #include "FgStdStream.hpp"
 #include "FgBounds.hpp"
 #include "FgFileSystem.hpp"
 #include "FgCommand.hpp"
 #include "Fg3dDisplay.hpp"
-#include "FgStdStream.hpp"
+#include "FgImageIo.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
+#include "FgRandom.hpp"
 
 using namespace std;
 
@@ -137,28 +141,982 @@ fgWritep(std::ostream & os,Mesh const & mesh)
     fgWritep(os,mesh.markedVerts);
 }
 
+namespace {
+
+// Version 2 layout: a header, then chunks each starting on a 'chunkAlign' boundary so uncompressed
+// arrays can be used in place from a mapping, then the directory of 'DirEntry' followed by the
+// UTF-8 chunk names:
+char const              fgmeshIdent2[] = "FgMesh02";
+uint64 const            chunkAlign = 16;
+
+struct  Header
+{
+    char                ident[8];
+    uint64              dirOffset;
+    uint32              numChunks;
+    uint32              reserved;
+};
+
+struct  DirEntry
+{
+    uint32              type;
+    uint32              flags;
+    uint32              index;
+    uint32              nameSize;
+    uint64              nameOffset;         // Relative to the start of the names
+    uint64              offset;
+    uint64              size;
+    uint64              rawSize;
+};
+
+enum struct ChunkType : uint32
+{
+    verts = 1,          // Vec3F
+    uvs,                // Vec2F
+    surfTris,           // Vec3UI, named by surface
+    surfTriUvs,         // Vec3UI
+    surfQuads,          // Vec4UI
+    surfQuadUvs,        // Vec4UI
+    surfPoints,         // Records of uint32 tri equiv index, Vec3F weights, label
+    deltaMorph,         // Vec3F, named by morph
+    targetMorphInds,    // uint32, named by morph
+    targetMorphVerts,   // Vec3F, immediately follows the indices of the same morph
+    markedVerts,        // Records of uint32 vertex index, label
+    quantVerts,         // Quantized record (see below) replacing 'verts'
+    quantDeltaMorphInds,    // uint32, named by morph
+    quantDeltaMorphVerts,   // Quantized record, immediately follows the indices of the same morph
+    quantTargetMorphVerts,  // Quantized record replacing 'targetMorphVerts'
+};
+
+// Quantized records are the QuantVerts offset, scale and maxErr followed by the Vec3S values:
+size_t const            quantHeaderSize = 28;
+
+uint32 const            flagZlib = 1;
+// A uint32 array stored as zigzag LEB128 varints of the differences between consecutive values, which
+// are small for facet and morph indices. Applied before compression:
+uint32 const            flagDeltaCoded = 2;
+
+String
+deltaEncode(uint const * vals,size_t num)
+{
+    String              ret;
+    ret.reserve(num*2);
+    uint32              prev = 0;
+    for (size_t ii=0; ii<num; ++ii) {
+        uint32              diff = vals[ii] - prev;
+        uint32              zz = (diff << 1) ^ uint32(-int32(diff >> 31));
+        prev = vals[ii];
+        while (zz >= 0x80) {
+            ret += char(zz | 0x80);
+            zz >>= 7;
+        }
+        ret += char(zz);
+    }
+    return ret;
+}
+
+Uints
+deltaDecode(uchar const * data,size_t size)
+{
+    Uints               ret;
+    uint32              prev = 0;
+    size_t              pos = 0;
+    while (pos < size) {
+        uint32              zz = 0;
+        for (uint shift=0;; shift+=7) {
+            if ((pos == size) || (shift > 28))
+                fgThrow("FGMESH delta coded chunk is corrupt");
+            uchar               byte = data[pos++];
+            zz |= uint32(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        prev += (zz >> 1) ^ uint32(-int32(zz & 1));
+        ret.push_back(prev);
+    }
+    return ret;
+}
+
+void
+appendRecord(String & str,void const * data,size_t size)
+{str.append(static_cast<char const *>(data),size); }
+
+struct  FileSeg
+{
+    uint64              offset;
+    uint64              size;
+};
+typedef Svec<FileSeg>   FileSegs;
+
+struct  FgmeshWriter
+{
+    Ofstream            ofs;
+    bool                compress;
+    bool                deltaCode;
+    uint64              pos = 0;
+    Svec<DirEntry>      dir;
+    String              names;
+
+    FgmeshWriter(Ustring const & fname,bool c,bool d) : ofs(fname), compress(c), deltaCode(d)
+    {
+        Header          hdr {};
+        write(&hdr,sizeof(hdr));            // Completed once the directory is written
+    }
+
+    void
+    write(void const * data,size_t size)
+    {
+        ofs.write(static_cast<char const *>(data),size);
+        pos += size;
+    }
+
+    void
+    align()
+    {
+        char            zeros[chunkAlign] = {};
+        write(zeros,size_t((chunkAlign - pos % chunkAlign) % chunkAlign));
+    }
+
+    void
+    chunk(ChunkType type,uint32 index,String const & name,void const * data,size_t size,uint32 flags=0)
+    {
+        align();
+        DirEntry        de {uint32(type),flags,index,uint32(name.size()),names.size(),pos,size,size};
+        names += name;
+        Uchars          zipped;
+        // Only keep compressed data if it is smaller:
+        if (compress && (size > 0)) {
+            zipped = zlibCompress(static_cast<uchar const *>(data),size);
+            if (zipped.size() < size) {
+                de.flags |= flagZlib;
+                de.size = zipped.size();
+                data = zipped.data();
+            }
+        }
+        write(data,size_t(de.size));
+        dir.push_back(de);
+    }
+
+    template<class T>
+    void
+    chunk(ChunkType type,uint32 index,String const & name,Svec<T> const & arr)
+    {chunk(type,index,name,arr.data(),arr.size()*sizeof(T)); }
+
+    // 'T' must be uint or a vector of uint:
+    template<class T>
+    void
+    indices(ChunkType type,uint32 index,String const & name,Svec<T> const & arr)
+    {
+        static_assert(sizeof(T) % sizeof(uint) == 0,"Not an index type");
+        if (deltaCode) {
+            String          coded = deltaEncode(reinterpret_cast<uint const *>(arr.data()),arr.size()*sizeof(T)/sizeof(uint));
+            chunk(type,index,name,coded.data(),coded.size(),flagDeltaCoded);
+        }
+        else
+            chunk(type,index,name,arr);
+    }
+
+    // Copies the chunk data from the given segments of a file in pieces so it need not fit in memory:
+    void
+    chunkFromFile(ChunkType type,uint32 index,String const & name,Ifstream & src,FileSegs const & segs)
+    {
+        uint64          size = 0;
+        for (FileSeg const & seg : segs)
+            size += seg.size;
+        align();
+        dir.push_back(DirEntry {uint32(type),0,index,uint32(name.size()),names.size(),pos,size,size});
+        names += name;
+        if (size == 0)
+            return;
+        String          buf(size_t(std::min(size,uint64(1) << 20)),'\0');
+        for (FileSeg const & seg : segs) {
+            src.seekg(seg.offset);
+            for (uint64 rem=seg.size; rem>0;) {
+                size_t          num = size_t(std::min(rem,uint64(buf.size())));
+                src.read(&buf[0],num);
+                if (size_t(src.gcount()) != num)
+                    fgThrow("Error reading FGMESH spool file");
+                write(buf.data(),num);
+                rem -= num;
+            }
+        }
+    }
+
+    void
+    quant(ChunkType type,uint32 index,String const & name,QuantVerts const & qv)
+    {
+        String          rec;
+        appendRecord(rec,&qv.offset[0],12);
+        appendRecord(rec,&qv.scale[0],12);
+        appendRecord(rec,&qv.maxErr,4);
+        appendRecord(rec,qv.vals.data(),qv.vals.size()*sizeof(Vec3S));
+        chunk(type,index,name,rec.data(),rec.size());
+    }
+
+    void
+    finish()
+    {
+        align();
+        Header          hdr {};
+        memcpy(hdr.ident,fgmeshIdent2,8);
+        hdr.dirOffset = pos;
+        hdr.numChunks = uint32(dir.size());
+        write(dir.data(),dir.size()*sizeof(DirEntry));
+        write(names.data(),names.size());
+        ofs.seekp(0);
+        ofs.write(reinterpret_cast<char const *>(&hdr),sizeof(hdr));
+        ofs.close();
+        if (ofs.fail())
+            fgThrow("Error writing FGMESH file");
+    }
+};
+
+void
+appendLabel(String & str,String const & label)
+{
+    uint32          size = uint32(label.size());
+    appendRecord(str,&size,4);
+    str += label;
+}
+
+// Reads variable-length records, throwing if they extend beyond the data:
+struct  RecordReader
+{
+    Uchars const &      data;
+    size_t              pos = 0;
+
+    explicit RecordReader(Uchars const & d) : data(d) {}
+
+    bool
+    more() const
+    {return (pos < data.size()); }
+
+    void
+    read(void * dst,size_t size)
+    {
+        if (size > data.size() - pos)
+            fgThrow("FGMESH record is truncated");
+        memcpy(dst,data.data()+pos,size);
+        pos += size;
+    }
+
+    String
+    label()
+    {
+        uint32          size;
+        read(&size,4);
+        String          ret(size,' ');
+        if (size > 0)
+            read(&ret[0],size);
+        return ret;
+    }
+};
+
 Mesh
-loadFgmesh(Ustring const & fname)
+loadFgmesh1(Ustring const & fname)
 {
-    Mesh        ret;
-    Ifstream      ifs(fname);
+    Mesh            ret;
+    Ifstream        ifs(fname);
     if (fgReadpT<string>(ifs) != "FgMesh01")
         fgThrow("Not a valid FGMESH file",fname);
     fgReadp(ifs,ret);
     return ret;
 }
 
-void
-saveFgmesh(Ustring const & fname,Mesh const & mesh)
+}
+
+FgmeshMapped::FgmeshMapped(Ustring const & fname) : m_file(std::make_shared<MappedFile>(fname))
 {
-    Ofstream          ofs(fname);
-    fgWritep(ofs,string("FgMesh01"));
-    fgWritep(ofs,mesh);
+    uchar const *       data = m_file->data();
+    uint64              fileSize = m_file->size();
+    Header              hdr;
+    if ((fileSize < sizeof(hdr)) || (memcmp(data,fgmeshIdent2,8) != 0))
+        fgThrow("Not a valid version 2 FGMESH file",fname);
+    memcpy(&hdr,data,sizeof(hdr));
+    uint64              dirSize = uint64(hdr.numChunks) * sizeof(DirEntry);
+    if ((hdr.dirOffset > fileSize) || (dirSize > fileSize - hdr.dirOffset))
+        fgThrow("FGMESH file directory is truncated",fname);
+    uint64              namesOffset = hdr.dirOffset + dirSize;
+    m_chunks.reserve(hdr.numChunks);
+    // Every surface has at least one chunk so valid surface indices are less than their number:
+    size_t              numSurfChunks = 0;
+    uint32              maxSurfIdx = 0;
+    for (uint32 ii=0; ii<hdr.numChunks; ++ii) {
+        DirEntry            de;
+        memcpy(&de,data+hdr.dirOffset+ii*sizeof(DirEntry),sizeof(de));
+        if ((de.offset > fileSize) || (de.size > fileSize - de.offset) ||
+            (de.nameOffset > fileSize - namesOffset) || (de.nameSize > fileSize - namesOffset - de.nameOffset))
+            fgThrow("FGMESH file chunk is truncated",fname);
+        if (((de.flags & flagZlib) == 0) && (de.size != de.rawSize))
+            fgThrow("FGMESH file chunk size is inconsistent",fname);
+        // Bound the decompressed size before it is allocated. Deflate can't exceed a ratio of 1032:1:
+        if ((de.flags & flagZlib) && (de.rawSize / 1032 > de.size + 1))
+            fgThrow("FGMESH file compressed chunk size is inconsistent",fname);
+        char const *        name = reinterpret_cast<char const *>(data + namesOffset + de.nameOffset);
+        Chunk               chunk {de.type,de.flags,de.index,String(name,de.nameSize),de.offset,de.size,de.rawSize};
+        ChunkType           type = ChunkType(de.type),
+                            prevType = m_chunks.empty() ? ChunkType(0) : ChunkType(m_chunks.back().type);
+        if ((type >= ChunkType::surfTris) && (type <= ChunkType::surfPoints)) {
+            ++numSurfChunks;
+            maxSurfIdx = cMax(maxSurfIdx,de.index);
+        }
+        if (type == ChunkType::verts)
+            m_numVerts = size_t(de.rawSize / sizeof(Vec3F));
+        else if (type == ChunkType::quantVerts)
+            m_numVerts = size_t((de.rawSize - std::min(de.rawSize,uint64(quantHeaderSize))) / sizeof(Vec3S));
+        else if ((type == ChunkType::deltaMorph) || (type == ChunkType::quantDeltaMorphInds))
+            m_deltaMorphs.insert(make_pair(chunk.name,m_chunks.size()));
+        else if (type == ChunkType::targetMorphInds)
+            m_targetMorphs.insert(make_pair(chunk.name,m_chunks.size()));
+        else if (((type == ChunkType::targetMorphVerts) || (type == ChunkType::quantTargetMorphVerts)) &&
+                 (prevType != ChunkType::targetMorphInds))
+            fgThrow("FGMESH file target morph vertices do not follow indices",fname);
+        else if ((type == ChunkType::quantDeltaMorphVerts) && (prevType != ChunkType::quantDeltaMorphInds))
+            fgThrow("FGMESH file delta morph vertices do not follow indices",fname);
+        if ((prevType == ChunkType::quantDeltaMorphInds) && (type != ChunkType::quantDeltaMorphVerts))
+            fgThrow("FGMESH file delta morph indices are not followed by vertices",fname);
+        m_chunks.push_back(chunk);
+    }
+    if (!m_chunks.empty() && (ChunkType(m_chunks.back().type) == ChunkType::quantDeltaMorphInds))
+        fgThrow("FGMESH file delta morph indices are not followed by vertices",fname);
+    if ((numSurfChunks > 0) && (maxSurfIdx >= numSurfChunks))
+        fgThrow("FGMESH file surface index is out of range",toStr(maxSurfIdx));
 }
 
-void
-saveFgmesh(Ustring const & fname,Meshes const & meshes)
-{saveFgmesh(fname,mergeMeshes(meshes)); }
+template<class T>
+Svec<T>
+FgmeshMapped::chunkArray(Chunk const & chunk) const
+{
+    if (chunk.flags & flagDeltaCoded)
+        fgThrow("FGMESH file chunk is delta coded but does not contain indices",toStr(chunk.type));
+    uchar const *       src = m_file->data() + chunk.offset;
+    if (chunk.rawSize % sizeof(T) != 0)
+        fgThrow("FGMESH file chunk size is not a whole number of elements",toStr(chunk.type));
+    Svec<T>             ret(size_t(chunk.rawSize / sizeof(T)));
+    uchar *             dst = reinterpret_cast<uchar *>(ret.data());
+    if (chunk.flags & flagZlib)
+        zlibDecompress(src,size_t(chunk.size),dst,size_t(chunk.rawSize));
+    else if (chunk.rawSize > 0)
+        memcpy(dst,src,size_t(chunk.rawSize));
+    return ret;
+}
+
+template<class T>
+Svec<T>
+FgmeshMapped::chunkIndices(Chunk const & chunk) const
+{
+    static_assert(sizeof(T) % sizeof(uint) == 0,"Not an index type");
+    if ((chunk.flags & flagDeltaCoded) == 0)
+        return chunkArray<T>(chunk);
+    uchar const *       src = m_file->data() + chunk.offset;
+    Uchars              unzipped;
+    if (chunk.flags & flagZlib) {
+        unzipped.resize(size_t(chunk.rawSize));
+        zlibDecompress(src,size_t(chunk.size),unzipped.data(),unzipped.size());
+        src = unzipped.data();
+    }
+    Uints               vals = deltaDecode(src,size_t(chunk.rawSize));
+    if ((vals.size() * sizeof(uint)) % sizeof(T) != 0)
+        fgThrow("FGMESH file chunk size is not a whole number of elements",toStr(chunk.type));
+    Svec<T>             ret(vals.size() * sizeof(uint) / sizeof(T));
+    if (!vals.empty())
+        memcpy(reinterpret_cast<uchar *>(ret.data()),vals.data(),vals.size()*sizeof(uint));
+    return ret;
+}
+
+QuantVerts
+FgmeshMapped::chunkQuant(Chunk const & chunk) const
+{
+    Uchars              rec = chunkArray<uchar>(chunk);
+    if ((rec.size() < quantHeaderSize) || ((rec.size() - quantHeaderSize) % sizeof(Vec3S) != 0))
+        fgThrow("FGMESH file quantized chunk size is inconsistent",toStr(chunk.type));
+    QuantVerts          ret;
+    memcpy(&ret.offset[0],rec.data(),12);
+    memcpy(&ret.scale[0],rec.data()+12,12);
+    memcpy(&ret.maxErr,rec.data()+24,4);
+    ret.vals.resize((rec.size() - quantHeaderSize) / sizeof(Vec3S));
+    if (!ret.vals.empty())
+        memcpy(ret.vals.data(),rec.data()+quantHeaderSize,ret.vals.size()*sizeof(Vec3S));
+    return ret;
+}
+
+Vec3Fs
+FgmeshMapped::verts() const
+{
+    for (Chunk const & chunk : m_chunks)
+        if (ChunkType(chunk.type) == ChunkType::verts)
+            return chunkArray<Vec3F>(chunk);
+        else if (ChunkType(chunk.type) == ChunkType::quantVerts)
+            return dequantize(chunkQuant(chunk));
+    return Vec3Fs();
+}
+
+Ustrings
+FgmeshMapped::deltaMorphNames() const
+{
+    Ustrings            ret;
+    for (Chunk const & chunk : m_chunks)
+        if ((ChunkType(chunk.type) == ChunkType::deltaMorph) || (ChunkType(chunk.type) == ChunkType::quantDeltaMorphInds))
+            ret.push_back(chunk.name);
+    return ret;
+}
+
+Ustrings
+FgmeshMapped::targetMorphNames() const
+{
+    Ustrings            ret;
+    for (Chunk const & chunk : m_chunks)
+        if (ChunkType(chunk.type) == ChunkType::targetMorphInds)
+            ret.push_back(chunk.name);
+    return ret;
+}
+
+Morph
+FgmeshMapped::deltaMorph(Ustring const & name) const
+{
+    auto                it = m_deltaMorphs.find(name);
+    if (it == m_deltaMorphs.end())
+        fgThrow("FGMESH delta morph not found",name);
+    Chunk const &       chunk = m_chunks[it->second];
+    if (ChunkType(chunk.type) == ChunkType::quantDeltaMorphInds)
+        return dequantizeDelta(quantDeltaMorph(name),m_numVerts);
+    Morph               ret {name,chunkArray<Vec3F>(chunk)};
+    if (ret.verts.size() != m_numVerts)
+        fgThrow("FGMESH delta morph vertex count inconsistent",name);
+    return ret;
+}
+
+QuantMorph
+FgmeshMapped::quantDeltaMorph(Ustring const & name) const
+{
+    auto                it = m_deltaMorphs.find(name);
+    if (it == m_deltaMorphs.end())
+        fgThrow("FGMESH delta morph not found",name);
+    Chunk const &       chunk = m_chunks[it->second];
+    if (ChunkType(chunk.type) != ChunkType::quantDeltaMorphInds)
+        return quantizeDelta(deltaMorph(name));
+    return quantDeltaMorphAt(it->second);
+}
+
+QuantMorph
+FgmeshMapped::quantDeltaMorphAt(size_t chunkIdx) const
+{
+    Chunk const &       chunk = m_chunks[chunkIdx];
+    QuantMorph          ret {chunk.name,chunkIndices<uint>(chunk),chunkQuant(m_chunks[chunkIdx+1])};
+    if (ret.verts.size() != ret.baseInds.size())
+        fgThrow("FGMESH delta morph vertex count inconsistent",chunk.name);
+    for (uint idx : ret.baseInds)
+        if (idx >= m_numVerts)
+            fgThrow("FGMESH delta morph vertex index out of range",chunk.name);
+    return ret;
+}
+
+IndexedMorph
+FgmeshMapped::targetMorph(Ustring const & name) const
+{
+    auto                it = m_targetMorphs.find(name);
+    if (it == m_targetMorphs.end())
+        fgThrow("FGMESH target morph not found",name);
+    IndexedMorph        ret;
+    ret.name = name;
+    ret.baseInds = chunkIndices<uint>(m_chunks[it->second]);
+    if (it->second+1 == m_chunks.size())
+        fgThrow("FGMESH target morph vertices missing",name);
+    Chunk const &       vertsChunk = m_chunks[it->second+1];
+    if (ChunkType(vertsChunk.type) == ChunkType::quantTargetMorphVerts)
+        ret.verts = dequantize(chunkQuant(vertsChunk));
+    else
+        ret.verts = chunkArray<Vec3F>(vertsChunk);
+    if (ret.verts.size() != ret.baseInds.size())
+        fgThrow("FGMESH target morph vertex count inconsistent",name);
+    return ret;
+}
+
+Mesh
+FgmeshMapped::toMesh() const
+{
+    Mesh                mesh;
+    auto                surf = [&](uint32 idx) -> Surf &
+    {
+        if (idx >= mesh.surfaces.size())
+            mesh.surfaces.resize(idx+1);
+        return mesh.surfaces[idx];
+    };
+    for (size_t ii=0; ii<m_chunks.size(); ++ii) {
+        Chunk const &       chunk = m_chunks[ii];
+        switch (ChunkType(chunk.type)) {
+        case ChunkType::verts:
+            mesh.verts = chunkArray<Vec3F>(chunk);
+            break;
+        case ChunkType::quantVerts:
+            mesh.verts = dequantize(chunkQuant(chunk));
+            break;
+        case ChunkType::uvs:
+            mesh.uvs = chunkArray<Vec2F>(chunk);
+            break;
+        case ChunkType::surfTris:
+            surf(chunk.index).name = chunk.name;
+            surf(chunk.index).tris.posInds = chunkIndices<Vec3UI>(chunk);
+            break;
+        case ChunkType::surfTriUvs:
+            surf(chunk.index).tris.uvInds = chunkIndices<Vec3UI>(chunk);
+            break;
+        case ChunkType::surfQuads:
+            surf(chunk.index).quads.posInds = chunkIndices<Vec4UI>(chunk);
+            break;
+        case ChunkType::surfQuadUvs:
+            surf(chunk.index).quads.uvInds = chunkIndices<Vec4UI>(chunk);
+            break;
+        case ChunkType::surfPoints: {
+            Uchars              recs = chunkArray<uchar>(chunk);
+            RecordReader        rr(recs);
+            SurfPoints &        sps = surf(chunk.index).surfPoints;
+            while (rr.more()) {
+                SurfPoint           sp;
+                uint32              triEquivIdx;
+                rr.read(&triEquivIdx,4);
+                sp.triEquivIdx = triEquivIdx;
+                rr.read(&sp.weights[0],12);
+                sp.label = rr.label();
+                sps.push_back(sp);
+            }
+            break;
+        }
+        case ChunkType::deltaMorph:
+            mesh.deltaMorphs.push_back(Morph {chunk.name,chunkArray<Vec3F>(chunk)});
+            if (mesh.deltaMorphs.back().verts.size() != m_numVerts)
+                fgThrow("FGMESH delta morph vertex count inconsistent",chunk.name);
+            break;
+        case ChunkType::quantDeltaMorphInds:
+            mesh.deltaMorphs.push_back(dequantizeDelta(quantDeltaMorphAt(ii),m_numVerts));
+            break;
+        case ChunkType::targetMorphInds: {
+            IndexedMorph        tm;
+            tm.name = chunk.name;
+            tm.baseInds = chunkIndices<uint>(chunk);
+            mesh.targetMorphs.push_back(tm);
+            break;
+        }
+        case ChunkType::targetMorphVerts:
+        case ChunkType::quantTargetMorphVerts:
+            if (ChunkType(chunk.type) == ChunkType::quantTargetMorphVerts)
+                mesh.targetMorphs.back().verts = dequantize(chunkQuant(chunk));
+            else
+                mesh.targetMorphs.back().verts = chunkArray<Vec3F>(chunk);
+            if (mesh.targetMorphs.back().verts.size() != mesh.targetMorphs.back().baseInds.size())
+                fgThrow("FGMESH target morph vertex count inconsistent",chunk.name);
+            break;
+        case ChunkType::markedVerts: {
+            Uchars              recs = chunkArray<uchar>(chunk);
+            RecordReader        rr(recs);
+            while (rr.more()) {
+                uint32              idx;
+                rr.read(&idx,4);
+                mesh.markedVerts.push_back(MarkedVert {idx,rr.label()});
+            }
+            break;
+        }
+        default:            // Chunks of types added by later versions are skipped
+            break;
+        }
+    }
+    return mesh;
+}
+
+Mesh
+loadFgmesh(Ustring const & fname)
+{
+    Ifstream        ifs(fname);
+    char            ident[8] = {};
+    ifs.read(ident,8);
+    ifs.close();
+    if (memcmp(ident,fgmeshIdent2,8) == 0)
+        return FgmeshMapped(fname).toMesh();
+    return loadFgmesh1(fname);
+}
+
+float
+saveFgmesh(Ustring const & fname,Mesh const & mesh,FgmeshOptions const & options)
+{
+    FgmeshWriter        fw(fname,options.compress,options.quantize);
+    float               maxErr = 0;
+    if (options.quantize) {
+        QuantVerts          qv = quantize(mesh.verts);
+        maxErr = qv.maxErr;
+        fw.quant(ChunkType::quantVerts,0,String(),qv);
+    }
+    else
+        fw.chunk(ChunkType::verts,0,String(),mesh.verts);
+    fw.chunk(ChunkType::uvs,0,String(),mesh.uvs);
+    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+        Surf const &        surf = mesh.surfaces[ss];
+        uint32              idx = uint32(ss);
+        fw.indices(ChunkType::surfTris,idx,surf.name.m_str,surf.tris.posInds);
+        fw.indices(ChunkType::surfTriUvs,idx,String(),surf.tris.uvInds);
+        fw.indices(ChunkType::surfQuads,idx,String(),surf.quads.posInds);
+        fw.indices(ChunkType::surfQuadUvs,idx,String(),surf.quads.uvInds);
+        String              recs;
+        for (SurfPoint const & sp : surf.surfPoints) {
+            uint32              triEquivIdx = sp.triEquivIdx;
+            appendRecord(recs,&triEquivIdx,4);
+            appendRecord(recs,&sp.weights[0],12);
+            appendLabel(recs,sp.label);
+        }
+        fw.chunk(ChunkType::surfPoints,idx,String(),recs.data(),recs.size());
+    }
+    for (size_t mm=0; mm<mesh.deltaMorphs.size(); ++mm) {
+        Morph const &       morph = mesh.deltaMorphs[mm];
+        FGASSERT(morph.verts.size() == mesh.verts.size());
+        if (options.quantize) {
+            QuantMorph          qm = quantizeDelta(morph,options.zeroTol);
+            maxErr = std::max(maxErr,qm.verts.maxErr);
+            fw.indices(ChunkType::quantDeltaMorphInds,uint32(mm),morph.name.m_str,qm.baseInds);
+            fw.quant(ChunkType::quantDeltaMorphVerts,uint32(mm),String(),qm.verts);
+        }
+        else
+            fw.chunk(ChunkType::deltaMorph,uint32(mm),morph.name.m_str,morph.verts);
+    }
+    for (size_t mm=0; mm<mesh.targetMorphs.size(); ++mm) {
+        IndexedMorph const & morph = mesh.targetMorphs[mm];
+        FGASSERT(morph.verts.size() == morph.baseInds.size());
+        fw.indices(ChunkType::targetMorphInds,uint32(mm),morph.name.m_str,morph.baseInds);
+        if (options.quantize) {
+            QuantVerts          qv = quantize(morph.verts);
+            maxErr = std::max(maxErr,qv.maxErr);
+            fw.quant(ChunkType::quantTargetMorphVerts,uint32(mm),String(),qv);
+        }
+        else
+            fw.chunk(ChunkType::targetMorphVerts,uint32(mm),String(),morph.verts);
+    }
+    String              recs;
+    for (MarkedVert const & mv : mesh.markedVerts) {
+        uint32              idx = uint32(mv.idx);
+        appendRecord(recs,&idx,4);
+        appendLabel(recs,mv.label);
+    }
+    fw.chunk(ChunkType::markedVerts,0,String(),recs.data(),recs.size());
+    fw.finish();
+    return maxErr;
+}
+
+float
+saveFgmesh(Ustring const & fname,Meshes const & meshes,FgmeshOptions const & options)
+{return saveFgmesh(fname,mergeMeshes(meshes),options); }
+
+// Streams the base shape in the order vertices, UVs, then the facets of each surface. Each of these is
+// read directly from the mapping if stored raw, otherwise decoded a whole chunk at a time:
+class   FgmeshStreamReader : public MeshReader
+{
+public:
+    FgmeshStreamReader(Ustring const & fname,size_t blockElems) : m_mesh(fname), m_blockElems(blockElems)
+    {
+        FGASSERT(blockElems > 0);
+        size_t const        none = numeric_limits<size_t>::max();
+        map<uint32,Array>   tris,
+                            quads;
+        bool                other = false;
+        for (size_t ii=0; ii<m_mesh.m_chunks.size(); ++ii) {
+            FgmeshMapped::Chunk const & chunk = m_mesh.m_chunks[ii];
+            switch (ChunkType(chunk.type)) {
+            case ChunkType::verts:
+            case ChunkType::quantVerts:
+                m_arrays.push_back(Array {Array::verts,ii,none,0,Ustring()});
+                break;
+            case ChunkType::uvs:
+                m_arrays.push_back(Array {Array::uvs,ii,none,0,Ustring()});
+                break;
+            case ChunkType::surfTris:
+                tris[chunk.index] = Array {Array::tris,ii,none,chunk.index,chunk.name};
+                break;
+            case ChunkType::surfQuads:
+                quads[chunk.index] = Array {Array::quads,ii,none,chunk.index,chunk.name};
+                break;
+            case ChunkType::surfTriUvs:
+                if (tris.find(chunk.index) != tris.end())
+                    tris[chunk.index].uvChunk = ii;
+                break;
+            case ChunkType::surfQuadUvs:
+                if (quads.find(chunk.index) != quads.end())
+                    quads[chunk.index].uvChunk = ii;
+                break;
+            case ChunkType::surfPoints:
+            case ChunkType::markedVerts:
+                other = other || (chunk.rawSize > 0);
+                break;
+            default:
+                other = true;
+                break;
+            }
+        }
+        for (auto const & it : tris) {
+            Array               q = quads[it.first];
+            q.name = it.second.name;
+            m_arrays.push_back(it.second);
+            if (q.type == Array::quads)
+                m_arrays.push_back(q);
+        }
+        if (other)
+            fgout << fgnl << "WARNING: Morphs, marked vertices and surface points are not streamed from " << fname;
+        rewind();
+    }
+
+    void
+    rewind() override
+    {
+        m_arrayIdx = 0;
+        m_elemIdx = 0;
+        m_decoded.clear();
+    }
+
+    bool
+    next(MeshBlock & block) override
+    {
+        block = MeshBlock();
+        for (; m_arrayIdx<m_arrays.size(); ++m_arrayIdx,m_elemIdx=0,m_decoded.clear()) {
+            Array const &       arr = m_arrays[m_arrayIdx];
+            if (arr.type == Array::verts)
+                block.verts = slice<Vec3F>(arr.chunk);
+            else if (arr.type == Array::uvs)
+                block.uvs = slice<Vec2F>(arr.chunk);
+            else {
+                block.surfIdx = arr.surfIdx;
+                block.surfName = arr.name;
+                if (arr.type == Array::tris)
+                    block.tris = facets<3>(arr);
+                else
+                    block.quads = facets<4>(arr);
+            }
+            if (!block.verts.empty() || !block.uvs.empty() || block.hasFacets())
+                return true;
+        }
+        return false;
+    }
+
+private:
+    struct  Array
+    {
+        enum Type {verts,uvs,tris,quads};
+        Type                type;
+        size_t              chunk;
+        size_t              uvChunk;        // Facet UV indices chunk if any
+        uint32              surfIdx;
+        Ustring             name;
+
+        Array() : type(verts), chunk(0), uvChunk(numeric_limits<size_t>::max()), surfIdx(0) {}
+        Array(Type t,size_t c,size_t u,uint32 s,Ustring const & n) : type(t), chunk(c), uvChunk(u), surfIdx(s), name(n) {}
+    };
+    FgmeshMapped            m_mesh;
+    size_t                  m_blockElems;
+    Svec<Array>             m_arrays;
+    size_t                  m_arrayIdx,
+                            m_elemIdx;      // Within the current array
+    map<size_t,Uchars>      m_decoded;      // Stored chunks of the current array which are not raw
+
+    // The (decoded) bytes of a chunk:
+    pair<uchar const *,size_t>
+    chunkData(size_t chunkIdx)
+    {
+        FgmeshMapped::Chunk const & chunk = m_mesh.m_chunks[chunkIdx];
+        if ((chunk.flags == 0) && (ChunkType(chunk.type) != ChunkType::quantVerts))
+            return make_pair(m_mesh.m_file->data()+chunk.offset,size_t(chunk.rawSize));
+        auto                it = m_decoded.find(chunkIdx);
+        if (it == m_decoded.end()) {
+            Uchars              bytes;
+            if (ChunkType(chunk.type) == ChunkType::quantVerts) {
+                Vec3Fs              verts = dequantize(m_mesh.chunkQuant(chunk));
+                uchar const *       ptr = reinterpret_cast<uchar const *>(verts.data());
+                bytes.assign(ptr,ptr+verts.size()*sizeof(Vec3F));
+            }
+            else if (chunk.flags & flagDeltaCoded) {
+                Uints               inds = m_mesh.chunkIndices<uint>(chunk);
+                uchar const *       ptr = reinterpret_cast<uchar const *>(inds.data());
+                bytes.assign(ptr,ptr+inds.size()*sizeof(uint));
+            }
+            else
+                bytes = m_mesh.chunkArray<uchar>(chunk);
+            it = m_decoded.insert(make_pair(chunkIdx,bytes)).first;
+        }
+        return make_pair(it->second.data(),it->second.size());
+    }
+
+    // The next block of elements of the current array, after which 'm_elemIdx' must be advanced:
+    template<class T>
+    Svec<T>
+    slice(size_t chunkIdx,bool advance=true)
+    {
+        FgmeshMapped::Chunk const & chunk = m_mesh.m_chunks[chunkIdx];
+        uchar const *       data;
+        size_t              size;
+        std::tie(data,size) = chunkData(chunkIdx);
+        if (size % sizeof(T) != 0)
+            fgThrow("FGMESH file chunk size is not a whole number of elements",toStr(chunk.type));
+        size_t              num = size / sizeof(T),
+                            beg = std::min(m_elemIdx,num),
+                            end = std::min(beg+m_blockElems,num);
+        Svec<T>             ret(end-beg);
+        if (!ret.empty())
+            memcpy(ret.data(),data+beg*sizeof(T),ret.size()*sizeof(T));
+        if (advance)
+            m_elemIdx = end;
+        return ret;
+    }
+
+    template<uint dim>
+    FacetInds<dim>
+    facets(Array const & arr)
+    {
+        FacetInds<dim>      ret;
+        // Checked when first reached since compressed arrays are only decoded then:
+        if ((arr.uvChunk != numeric_limits<size_t>::max()) && (chunkData(arr.uvChunk).second > 0)) {
+            if ((m_elemIdx == 0) && (chunkData(arr.uvChunk).second != chunkData(arr.chunk).second))
+                fgThrow("FGMESH surface UV indices are inconsistent",arr.name);
+            ret.uvInds = slice<Mat<uint,dim,1> >(arr.uvChunk,false);
+        }
+        ret.posInds = slice<Mat<uint,dim,1> >(arr.chunk);
+        return ret;
+    }
+};
+
+Sptr<MeshReader>
+fgmeshReader(Ustring const & fname,size_t blockElems)
+{return make_shared<FgmeshStreamReader>(fname,blockElems); }
+
+namespace {
+
+// All arrays are appended to a single temporary spool file as blocks arrive, recording the segments
+// of each array, which are then gathered into contiguous chunks:
+struct  FgmeshStreamWriter : MeshWriter
+{
+    struct  Spool
+    {
+        FileSegs            segs;
+        uint64              size = 0;
+    };
+    struct  SurfSpools
+    {
+        String              name;
+        Spool               tris,
+                            triUvs,
+                            quads,
+                            quadUvs;
+    };
+    Ustring             fname,
+                        spoolName;
+    Ofstream            spoolOfs;       // Kept open until 'finish'
+    uint64              spoolPos = 0;
+    Spool               verts,
+                        uvs;
+    Svec<SurfSpools>    surfs;
+    size_t              numVerts = 0,
+                        numUvs = 0;
+
+    explicit FgmeshStreamWriter(Ustring const & f) : fname(f), spoolName(f+".tmp") {}
+
+    ~FgmeshStreamWriter()
+    {
+        if (spoolPos > 0) {
+            spoolOfs.close();
+            try {pathRemove(spoolName); }
+            catch (...) {}
+        }
+    }
+
+    template<class T>
+    void
+    append(Spool & spool,Svec<T> const & arr)
+    {
+        if (arr.empty())
+            return;
+        if (spoolPos == 0)
+            spoolOfs.open(spoolName);
+        uint64              size = arr.size()*sizeof(T);
+        spoolOfs.write(reinterpret_cast<char const *>(arr.data()),size_t(size));
+        if (spoolOfs.fail())
+            fgThrow("Error writing FGMESH spool file",spoolName);
+        // Consecutive appends to the same array are merged:
+        if (!spool.segs.empty() && (spool.segs.back().offset + spool.segs.back().size == spoolPos))
+            spool.segs.back().size += size;
+        else
+            spool.segs.push_back(FileSeg {spoolPos,size});
+        spool.size += size;
+        spoolPos += size;
+    }
+
+    template<uint dim>
+    void
+    checkInds(Svec<Mat<uint,dim,1> > const & inds,size_t num)
+    {
+        for (Mat<uint,dim,1> const & ind : inds)
+            for (uint ii=0; ii<dim; ++ii)
+                FGASSERT(ind[ii] < num);
+    }
+
+    void
+    write(MeshBlock const & block) override
+    {
+        append(verts,block.verts);
+        append(uvs,block.uvs);
+        numVerts += block.verts.size();
+        numUvs += block.uvs.size();
+        if (!block.hasFacets())
+            return;
+        checkInds(block.tris.posInds,numVerts);
+        checkInds(block.tris.uvInds,numUvs);
+        checkInds(block.quads.posInds,numVerts);
+        checkInds(block.quads.uvInds,numUvs);
+        if (block.surfIdx >= surfs.size())
+            surfs.resize(block.surfIdx+1);
+        SurfSpools &        ss = surfs[block.surfIdx];
+        if (ss.tris.size + ss.quads.size == 0)
+            ss.name = block.surfName.m_str;
+        append(ss.tris,block.tris.posInds);
+        append(ss.triUvs,block.tris.uvInds);
+        append(ss.quads,block.quads.posInds);
+        append(ss.quadUvs,block.quads.uvInds);
+    }
+
+    void
+    finish() override
+    {
+        Ifstream            ifs;
+        if (spoolPos > 0) {
+            spoolOfs.close();
+            if (spoolOfs.fail())
+                fgThrow("Error writing FGMESH spool file",spoolName);
+            ifs.open(spoolName);
+        }
+        FgmeshWriter        fw(fname,false,false);
+        fw.chunkFromFile(ChunkType::verts,0,String(),ifs,verts.segs);
+        fw.chunkFromFile(ChunkType::uvs,0,String(),ifs,uvs.segs);
+        for (size_t ss=0; ss<surfs.size(); ++ss) {
+            SurfSpools &        sp = surfs[ss];
+            uint32              idx = uint32(ss);
+            for (Spool * uvSpool : {&sp.triUvs,&sp.quadUvs}) {
+                Spool &             posSpool = (uvSpool == &sp.triUvs) ? sp.tris : sp.quads;
+                if ((uvSpool->size > 0) && (uvSpool->size != posSpool.size)) {
+                    fgout << fgnl << "WARNING: Partial UV indices ignored in " << fname << " surface " << sp.name;
+                    *uvSpool = Spool();
+                }
+            }
+            fw.chunkFromFile(ChunkType::surfTris,idx,sp.name,ifs,sp.tris.segs);
+            fw.chunkFromFile(ChunkType::surfTriUvs,idx,String(),ifs,sp.triUvs.segs);
+            fw.chunkFromFile(ChunkType::surfQuads,idx,String(),ifs,sp.quads.segs);
+            fw.chunkFromFile(ChunkType::surfQuadUvs,idx,String(),ifs,sp.quadUvs.segs);
+        }
+        fw.finish();
+        if (spoolPos > 0) {
+            ifs.close();
+            pathRemove(spoolName);
+            spoolPos = 0;
+        }
+    }
+};
+
+}
+
+Sptr<MeshWriter>
+fgmeshWriter(Ustring const & fname)
+{return make_shared<FgmeshStreamWriter>(fname); }
 
 void
 fgSaveFgmeshTest(CLArgs const & args)
@@ -168,4 +1126,235 @@ fgSaveFgmeshTest(CLArgs const & args)
     viewMesh(loadFgmesh("Mouth.tri"));
 }
 
+static
+String
+serializeV1(Mesh const & mesh)
+{
+    ostringstream       oss;
+    fgWritep(oss,string("FgMesh01"));
+    fgWritep(oss,mesh);
+    return oss.str();
+}
+
+// Multiple surfaces with names and surface points, delta and target morphs and marked verts:
+static
+Mesh
+cFgmeshTestMesh()
+{
+    Ustring             dd = dataDir() + "base/";
+    Mesh                mesh = mergeMeshes(svec(loadTri(dd+"Jane.tri"),loadTri(dd+"Mouth.tri")));
+    mesh.surfaces[0].name = "Face";
+    mesh.markedVerts = {MarkedVert{1,"one"},MarkedVert{22,""}};
+    return mesh;
+}
+
+static
+float
+maxDist(Vec3Fs const & lhs,Vec3Fs const & rhs)
+{
+    FGASSERT(lhs.size() == rhs.size());
+    float               ret = 0;
+    for (size_t ii=0; ii<lhs.size(); ++ii)
+        ret = std::max(ret,cLen(lhs[ii]-rhs[ii]));
+    return ret;
+}
+
+// Decoded values must lie within the reported error bounds, including when morphs are combined:
+static
+void
+testFgmeshQuant(Mesh const & mesh)
+{
+    // Allow for the rounding of the error computation itself:
+    auto                within = [](float dist,float bound) {return (dist <= bound * 1.001f + 1e-6f); };
+    float               meshMag = cMaxElem(cDims(mesh.verts));
+    for (float zeroTol : {0.0f,meshMag*1e-4f}) {
+        FgmeshOptions       opts;
+        opts.quantize = true;
+        opts.zeroTol = zeroTol;
+        float               maxErr = saveFgmesh("q.fgmesh",mesh,opts);
+        Mesh                qmesh = loadFgmesh("q.fgmesh");
+        FGASSERT(qmesh.uvs == mesh.uvs);
+        FGASSERT(qmesh.surfaces.size() == mesh.surfaces.size());
+        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+            FGASSERT(qmesh.surfaces[ss].tris.posInds == mesh.surfaces[ss].tris.posInds);
+            FGASSERT(qmesh.surfaces[ss].tris.uvInds == mesh.surfaces[ss].tris.uvInds);
+            FGASSERT(qmesh.surfaces[ss].quads.posInds == mesh.surfaces[ss].quads.posInds);
+            FGASSERT(qmesh.surfaces[ss].quads.uvInds == mesh.surfaces[ss].quads.uvInds);
+        }
+        FGASSERT(qmesh.markedVerts.size() == mesh.markedVerts.size());
+        FGASSERT(within(maxDist(qmesh.verts,mesh.verts),maxErr));
+        // Quantization is much finer than the mesh:
+        FGASSERT(maxErr < meshMag * 1e-3f);
+        FgmeshMapped        fm("q.fgmesh");
+        QuantMorphs         qms;
+        for (size_t mm=0; mm<mesh.deltaMorphs.size(); ++mm) {
+            Morph const &       morph = mesh.deltaMorphs[mm];
+            QuantMorph          qm = quantizeDelta(morph,zeroTol);
+            FGASSERT(within(maxDist(qmesh.deltaMorphs[mm].verts,morph.verts),qm.verts.maxErr));
+            FGASSERT(within(maxDist(dequantizeDelta(qm,mesh.verts.size()).verts,morph.verts),qm.verts.maxErr));
+            FGASSERT(qm.verts.maxErr <= maxErr);
+            qms.push_back(qm);
+        }
+        for (size_t mm=0; mm<mesh.targetMorphs.size(); ++mm) {
+            IndexedMorph const & morph = mesh.targetMorphs[mm];
+            FGASSERT(qmesh.targetMorphs[mm].baseInds == morph.baseInds);
+            FGASSERT(within(maxDist(qmesh.targetMorphs[mm].verts,morph.verts),maxErr));
+        }
+        Ustring             name = mesh.deltaMorphs.back().name;
+        FGASSERT(fm.quantDeltaMorph(name).baseInds == quantizeDelta(mesh.deltaMorphs.back(),zeroTol).baseInds);
+        Floats              coord(qms.size());
+        for (float & c : coord)
+            c = float(randUniform(-1,1));
+        Vec3Fs              acc(mesh.verts.size(),Vec3F(0)),
+                            qacc = acc;
+        accDeltaMorphs(mesh.deltaMorphs,coord,acc);
+        accDeltaMorphs(qms,coord,qacc);
+        float               bound = 0;
+        for (size_t mm=0; mm<qms.size(); ++mm)
+            bound += std::abs(coord[mm]) * qms[mm].verts.maxErr;
+        FGASSERT(within(maxDist(qacc,acc),bound));
+        FGASSERT(loadRawString("q.fgmesh").size() < loadRawString("v2.fgmesh").size() / 2);
+    }
+}
+
+void
+testFgmesh(CLArgs const & args)
+{
+    FGTESTDIR
+    Mesh                mesh = cFgmeshTestMesh();
+    String              v1 = serializeV1(mesh);
+    saveRaw(v1,"v1.fgmesh",false);
+    FGASSERT(serializeV1(loadFgmesh("v1.fgmesh")) == v1);
+    saveFgmesh("v2.fgmesh",mesh);
+    FGASSERT(serializeV1(loadFgmesh("v2.fgmesh")) == v1);
+    FgmeshOptions       zip;
+    zip.compress = true;
+    saveFgmesh("v2z.fgmesh",mesh,zip);
+    FGASSERT(serializeV1(loadFgmesh("v2z.fgmesh")) == v1);
+    FGASSERT(loadRawString("v2z.fgmesh").size() < loadRawString("v2.fgmesh").size());
+    for (String fname : {"v2.fgmesh","v2z.fgmesh"}) {
+        FgmeshMapped        fm(fname);
+        FGASSERT(fm.verts() == mesh.verts);
+        FGASSERT(fm.deltaMorphNames().size() == mesh.deltaMorphs.size());
+        // The first of any morphs with the same name is returned:
+        for (Morph const & morph : mesh.deltaMorphs) {
+            auto                first = find_if(mesh.deltaMorphs.begin(),mesh.deltaMorphs.end(),
+                                    [&](Morph const & m){return (m.name == morph.name); });
+            FGASSERT(fm.deltaMorph(morph.name).verts == first->verts);
+        }
+        for (IndexedMorph const & morph : mesh.targetMorphs) {
+            auto                first = find_if(mesh.targetMorphs.begin(),mesh.targetMorphs.end(),
+                                    [&](IndexedMorph const & m){return (m.name == morph.name); });
+            FGASSERT(fm.targetMorph(morph.name) == *first);
+        }
+        FGASSERT(!fm.hasDeltaMorph("no such morph"));
+    }
+    // Corruption must be detected rather than read beyond the mapping:
+    String              data = loadRawString("v2.fgmesh");
+    for (size_t len : {size_t(0),size_t(20),data.size()/2,data.size()-1}) {
+        saveRaw(data.substr(0,len),"truncated.fgmesh",false);
+        bool                threw = false;
+        try {loadFgmesh("truncated.fgmesh"); }
+        catch (FgException const &) {threw = true; }
+        FGASSERT(threw);
+    }
+    // Alter the directory entries of the given chunk type:
+    auto                alterChunks = [](String const & src,ChunkType type,function<void(DirEntry &)> const & fn)
+    {
+        String              bad = src;
+        Header              hdr;
+        memcpy(&hdr,&bad[0],sizeof(hdr));
+        for (uint32 ii=0; ii<hdr.numChunks; ++ii) {
+            char *              entry = &bad[size_t(hdr.dirOffset)+ii*sizeof(DirEntry)];
+            DirEntry            de;
+            memcpy(&de,entry,sizeof(de));
+            if (ChunkType(de.type) == type) {
+                fn(de);
+                memcpy(entry,&de,sizeof(de));
+            }
+        }
+        return bad;
+    };
+    auto                loadThrows = [](String const & bad)
+    {
+        saveRaw(bad,"bad.fgmesh",false);
+        bool                threw = false;
+        try {loadFgmesh("bad.fgmesh"); }
+        catch (FgException const &) {threw = true; }
+        return threw;
+    };
+    // A surface index far beyond the number of surfaces must not cause a huge allocation:
+    FGASSERT(loadThrows(alterChunks(data,ChunkType::surfTris,[](DirEntry & de){de.index = 0xFFFFFFF0U; })));
+    // Nor must a compressed chunk claiming a huge decompressed size:
+    FGASSERT(loadThrows(alterChunks(loadRawString("v2z.fgmesh"),ChunkType::verts,
+        [](DirEntry & de){de.rawSize = uint64(1) << 40; })));
+    // Delta morphs must have a delta for every vertex:
+    FGASSERT(loadThrows(alterChunks(data,ChunkType::deltaMorph,[](DirEntry & de){de.size -= 12; de.rawSize -= 12; })));
+    testFgmeshQuant(mesh);
+}
+
+void
+testmFgmesh(CLArgs const & args)
+{
+    FGTESTDIR
+    Mesh                mesh = cFgmeshTestMesh();
+    Ustring             name = mesh.deltaMorphs.back().name;
+    saveRaw(serializeV1(mesh),"v1.fgmesh",false);
+    Timer               timer;
+    saveFgmesh("v2.fgmesh",mesh);
+    uint64              saveMs = timer.readMs();
+    FgmeshOptions       opts;
+    opts.compress = true;
+    timer.start();
+    saveFgmesh("v2z.fgmesh",mesh,opts);
+    uint64              saveZMs = timer.readMs();
+    opts.compress = false;
+    opts.quantize = true;
+    float               maxErr = saveFgmesh("v2q.fgmesh",mesh,opts);
+    opts.compress = true;
+    saveFgmesh("v2qz.fgmesh",mesh,opts);
+    fgout << fgnl << mesh.verts.size() << " verts, " << mesh.numMorphs() << " morphs"
+        << fgnl << "save ms: v2 " << saveMs << ", v2 compressed " << saveZMs
+        << fgnl << "quantized max error: " << maxErr << " (mesh size " << cMaxElem(cDims(mesh.verts)) << ")"
+        << fgnl << "file,MB,loadMs,oneMorphMs";
+    size_t const        reps = 20;
+    for (String fname : {"v1.fgmesh","v2.fgmesh","v2z.fgmesh","v2q.fgmesh","v2qz.fgmesh"}) {
+        double              mb = double(loadRawString(fname).size()) / double(1 << 20);
+        timer.start();
+        for (size_t ii=0; ii<reps; ++ii)
+            loadFgmesh(fname);
+        double              loadMs = double(timer.readMs()) / reps;
+        double              morphMs = 0.0;
+        if (fname != "v1.fgmesh") {
+            timer.start();
+            for (size_t ii=0; ii<reps; ++ii)
+                FgmeshMapped(fname).deltaMorph(name);
+            morphMs = double(timer.readMs()) / reps;
+        }
+        fgout << fgnl << fname << "," << mb << "," << loadMs << "," << morphMs;
+    }
+    // Morph evaluation over all delta morphs, from floats and directly from the quantized values:
+    QuantMorphs         qms;
+    size_t              qbytes = 0,
+                        fbytes = 0;
+    for (Morph const & morph : mesh.deltaMorphs) {
+        qms.push_back(quantizeDelta(morph));
+        qbytes += qms.back().baseInds.size() * (sizeof(uint) + sizeof(Vec3S));
+        fbytes += morph.verts.size() * sizeof(Vec3F);
+    }
+    Floats              coord(qms.size(),0.5f);
+    Vec3Fs              acc(mesh.verts.size());
+    timer.start();
+    for (size_t ii=0; ii<reps; ++ii)
+        accDeltaMorphs(mesh.deltaMorphs,coord,acc);
+    double              floatMs = double(timer.readMs()) / reps;
+    timer.start();
+    for (size_t ii=0; ii<reps; ++ii)
+        accDeltaMorphs(qms,coord,acc);
+    double              quantMs = double(timer.readMs()) / reps;
+    fgout << fgnl << "delta morphs,MB,evalMs"
+        << fgnl << "float," << double(fbytes) / double(1 << 20) << "," << floatMs
+        << fgnl << "quantized," << double(qbytes) / double(1 << 20) << "," << quantMs;
+}
+
 }
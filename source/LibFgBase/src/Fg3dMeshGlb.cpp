@@ -0,0 +1,600 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// glTF 2.0 binary (GLB): a JSON chunk describing the scene followed by a single binary chunk
+// holding all vertex, index, morph and image data in the layout the GPU consumes.
+//
+
+#include "stdafx.h"
+
+#include "Fg3dMeshIo.hpp"
+#include "FgFileSystem.hpp"
+#include "FgImageIo.hpp"
+#include "FgBounds.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include <unordered_map>
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+uint32 const        glbMagic = 0x46546C67,          // "glTF"
+                    glbChunkJson = 0x4E4F534A,      // "JSON"
+                    glbChunkBin = 0x004E4942,       // "BIN\0"
+                    glbArrayBuffer = 34962,
+                    glbElementArrayBuffer = 34963,
+                    glbFloat = 5126,
+                    glbUint = 5125;
+
+String
+jsonStr(String const & str)
+{
+    String              ret = "\"";
+    for (char ch : str) {
+        if ((ch == '"') || (ch == '\\')) {
+            ret += '\\';
+            ret += ch;
+        }
+        else if (uchar(ch) < 0x20) {
+            char                buff[8];
+            snprintf(buff,sizeof(buff),"\\u%04x",uint(uchar(ch)));
+            ret += buff;
+        }
+        else
+            ret += ch;
+    }
+    return ret + "\"";
+}
+
+// Accessor bounds are checked by validators so must round-trip exactly:
+String
+jsonFloat(float val)
+{
+    ostringstream       oss;
+    oss.imbue(locale::classic());
+    oss << setprecision(9) << val;
+    return oss.str();
+}
+
+template<uint dim>
+String
+jsonVec(Mat<float,dim,1> const & vec)
+{
+    String              ret = "[";
+    for (uint ii=0; ii<dim; ++ii)
+        ret += (ii > 0 ? "," : "") + jsonFloat(vec[ii]);
+    return ret + "]";
+}
+
+String
+jsonArray(Strings const & elems)
+{return "[" + cat(elems,",") + "]"; }
+
+// glTF requires arrays to be non-empty so empty properties are omitted:
+String
+jsonProp(String const & name,Strings const & elems)
+{return elems.empty() ? String() : (",\"" + name + "\":" + jsonArray(elems)); }
+
+// Accumulates the binary chunk along with the JSON buffer views and accessors describing it:
+struct  GlbBuilder
+{
+    String              bin;
+    Strings             bufferViews;
+    Strings             accessors;
+
+    // Views are 4-byte aligned as required for float and uint32 data. 'target' of zero indicates
+    // data which is not a vertex attribute or index array:
+    size_t
+    addView(void const * data,size_t size,uint target=0)
+    {
+        bin.append((4 - bin.size() % 4) % 4,'\0');
+        String              json = "{\"buffer\":0,\"byteOffset\":" + toStr(bin.size()) +
+            ",\"byteLength\":" + toStr(size);
+        if (target != 0)
+            json += ",\"target\":" + toStr(target);
+        bufferViews.push_back(json + "}");
+        bin.append(static_cast<char const *>(data),size);
+        return bufferViews.size() - 1;
+    }
+
+    size_t
+    addAccessor(String const & json)
+    {
+        accessors.push_back(json);
+        return accessors.size() - 1;
+    }
+
+    template<uint dim>
+    size_t
+    addVecs(Svec<Mat<float,dim,1> > const & vecs)
+    {
+        Mat<float,dim,2>    bounds = cBounds(vecs);
+        size_t              view = addView(vecs.data(),vecs.size()*sizeof(vecs[0]),glbArrayBuffer);
+        return addAccessor("{\"bufferView\":" + toStr(view) + ",\"componentType\":" + toStr(glbFloat) +
+            ",\"count\":" + toStr(vecs.size()) + ",\"type\":\"VEC" + toStr(dim) + "\"" +
+            ",\"min\":" + jsonVec(bounds.colVec(0)) + ",\"max\":" + jsonVec(bounds.colVec(1)) + "}");
+    }
+
+    size_t
+    addIndices(Uints const & inds)
+    {
+        size_t              view = addView(inds.data(),inds.size()*sizeof(uint),glbElementArrayBuffer);
+        return addAccessor("{\"bufferView\":" + toStr(view) + ",\"componentType\":" + toStr(glbUint) +
+            ",\"count\":" + toStr(inds.size()) + ",\"type\":\"SCALAR\"}");
+    }
+
+    // Morph target deltas of which only those at 'inds' (strictly increasing) are non-zero:
+    size_t
+    addSparse(size_t count,Uints const & inds,Vec3Fs const & vals)
+    {
+        String              json = "{\"componentType\":" + toStr(glbFloat) + ",\"count\":" + toStr(count) +
+            ",\"type\":\"VEC3\"";
+        Mat32F              bounds(0);
+        if (!vals.empty()) {
+            bounds = cBounds(vals);
+            if (vals.size() < count)        // The implicit zeros are part of the bounds
+                bounds = cBoundsUnion(bounds,Mat32F(0));
+            size_t              indView = addView(inds.data(),inds.size()*sizeof(uint)),
+                                valView = addView(vals.data(),vals.size()*sizeof(Vec3F));
+            json += ",\"sparse\":{\"count\":" + toStr(inds.size()) +
+                ",\"indices\":{\"bufferView\":" + toStr(indView) + ",\"componentType\":" + toStr(glbUint) + "}" +
+                ",\"values\":{\"bufferView\":" + toStr(valView) + "}}";
+        }
+        return addAccessor(json + ",\"min\":" + jsonVec(bounds.colVec(0)) +
+            ",\"max\":" + jsonVec(bounds.colVec(1)) + "}");
+    }
+};
+
+}
+
+void
+saveGlb(Ustring const & fname,Meshes const & meshes,String imgFormat,SpatialUnit unit)
+{
+    FGASSERT(!meshes.empty());
+    String              ext = toLower(imgFormat);
+    bool                jpeg = ((ext == "jpg") || (ext == "jpeg"));
+    GlbBuilder          glb;
+    Strings             nodes,
+                        gltfMeshes,
+                        materials,
+                        textures,
+                        images;
+    map<ImgC4UC const *,size_t> imageInds;      // Shared maps are only stored once
+    for (Mesh const & mesh : meshes) {
+        bool                hasUvs = !mesh.uvs.empty();
+        // glTF vertices are unique (position,UV) pairs so UV seams split vertices:
+        unordered_map<uint64,uint>  vertInds;
+        Uints               vertPosInds;
+        Vec3Fs              positions;
+        Vec2Fs              uvs;
+        Svec<Uints>         surfInds(mesh.surfaces.size());
+        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+            Tris                tris = mesh.surfaces[ss].getTriEquivs();
+            bool                surfUvs = hasUvs && !tris.uvInds.empty();
+            Uints &             inds = surfInds[ss];
+            inds.reserve(tris.size()*3);
+            for (size_t ii=0; ii<tris.size(); ++ii) {
+                for (uint vv=0; vv<3; ++vv) {
+                    uint                posIdx = tris.posInds[ii][vv],
+                                        uvIdx = surfUvs ? tris.uvInds[ii][vv] : numeric_limits<uint>::max();
+                    FGASSERT(posIdx < mesh.verts.size());
+                    auto                it = vertInds.emplace((uint64(posIdx) << 32) | uvIdx,uint(positions.size()));
+                    if (it.second) {
+                        vertPosInds.push_back(posIdx);
+                        positions.push_back(mesh.verts[posIdx]);
+                        if (hasUvs) {
+                            Vec2F               uv = surfUvs ? mesh.uvs.at(uvIdx) : Vec2F(0);
+                            uvs.push_back(Vec2F(uv[0],1.0f-uv[1]));     // glTF UV origin is top left
+                        }
+                    }
+                    inds.push_back(it.first->second);
+                }
+            }
+        }
+        if (positions.empty())
+            continue;
+        size_t              numVerts = positions.size();
+        String              attribs = "{\"POSITION\":" + toStr(glb.addVecs(positions));
+        if (hasUvs)
+            attribs += ",\"TEXCOORD_0\":" + toStr(glb.addVecs(uvs));
+        attribs += "}";
+        // All primitives of a glTF mesh must have the same morph targets so they share accessors:
+        Strings             targets,
+                            targetNames;
+        for (Morph const & morph : mesh.deltaMorphs) {
+            FGASSERT(morph.verts.size() == mesh.verts.size());
+            Vec3Fs              deltas(numVerts);
+            for (size_t vv=0; vv<numVerts; ++vv)
+                deltas[vv] = morph.verts[vertPosInds[vv]];
+            targets.push_back("{\"POSITION\":" + toStr(glb.addVecs(deltas)) + "}");
+            targetNames.push_back(jsonStr(morph.name.m_str));
+        }
+        if (!mesh.targetMorphs.empty()) {
+            Svec<Uints>         vertsOfPos(mesh.verts.size());
+            for (size_t vv=0; vv<numVerts; ++vv)
+                vertsOfPos[vertPosInds[vv]].push_back(uint(vv));
+            for (IndexedMorph const & morph : mesh.targetMorphs) {
+                FGASSERT(morph.baseInds.size() == morph.verts.size());
+                Vec3Fs              deltas(numVerts);
+                Bools               isSet(numVerts,false);
+                for (size_t ii=0; ii<morph.baseInds.size(); ++ii) {
+                    uint                posIdx = morph.baseInds[ii];
+                    FGASSERT(posIdx < mesh.verts.size());
+                    for (uint vv : vertsOfPos[posIdx]) {
+                        deltas[vv] = morph.verts[ii] - mesh.verts[posIdx];
+                        isSet[vv] = true;
+                    }
+                }
+                Uints               inds;
+                Vec3Fs              vals;
+                for (size_t vv=0; vv<numVerts; ++vv) {
+                    if (isSet[vv]) {
+                        inds.push_back(uint(vv));
+                        vals.push_back(deltas[vv]);
+                    }
+                }
+                targets.push_back("{\"POSITION\":" + toStr(glb.addSparse(numVerts,inds,vals)) + "}");
+                targetNames.push_back(jsonStr(morph.name.m_str));
+            }
+        }
+        Strings             primitives;
+        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+            if (surfInds[ss].empty())
+                continue;
+            Surf const &        surf = mesh.surfaces[ss];
+            String              name = surf.name.empty() ? mesh.name.m_str + toStr(ss) : surf.name.m_str,
+                                pbr = "\"metallicFactor\":0";
+            if (hasUvs && surf.hasUvIndices() && surf.material.albedoMap) {
+                ImgC4UC const *     imgPtr = surf.material.albedoMap.get();
+                auto                it = imageInds.find(imgPtr);
+                if (it == imageInds.end()) {
+                    Uchars              data = jpeg ? imgEncodeJpeg(*imgPtr) : imgEncodePng(*imgPtr);
+                    size_t              view = glb.addView(data.data(),data.size());
+                    images.push_back("{\"bufferView\":" + toStr(view) + ",\"mimeType\":" +
+                        (jpeg ? "\"image/jpeg\"" : "\"image/png\"") + "}");
+                    textures.push_back("{\"source\":" + toStr(images.size()-1) + "}");
+                    it = imageInds.insert(make_pair(imgPtr,textures.size()-1)).first;
+                }
+                pbr += ",\"baseColorTexture\":{\"index\":" + toStr(it->second) + "}";
+            }
+            materials.push_back("{\"name\":" + jsonStr(name) + ",\"pbrMetallicRoughness\":{" + pbr + "}}");
+            primitives.push_back("{\"attributes\":" + attribs + ",\"indices\":" +
+                toStr(glb.addIndices(surfInds[ss])) + ",\"material\":" + toStr(materials.size()-1) +
+                jsonProp("targets",targets) + "}");
+        }
+        String              json = "{\"name\":" + jsonStr(mesh.name.m_str) + ",\"primitives\":" + jsonArray(primitives);
+        if (!targets.empty())
+            json += ",\"weights\":" + jsonArray(Strings(targets.size(),"0")) +
+                ",\"extras\":{\"targetNames\":" + jsonArray(targetNames) + "}";
+        gltfMeshes.push_back(json + "}");
+        nodes.push_back("{\"name\":" + jsonStr(mesh.name.m_str) + ",\"mesh\":" + toStr(gltfMeshes.size()-1) + "}");
+    }
+    if (nodes.empty())
+        fgThrow("saveGlb no facets to save",fname);
+    Strings             sceneNodes;
+    for (size_t ii=0; ii<nodes.size(); ++ii)
+        sceneNodes.push_back(toStr(ii));
+    // glTF units are metres so the scene is scaled by a root node rather than modifying the data:
+    String              scale = inMetresStr(unit);
+    String              json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"FaceGen\"},\"scene\":0,"
+        "\"scenes\":[{\"nodes\":[" + toStr(nodes.size()) + "]}]";
+    nodes.push_back("{\"name\":\"root\",\"children\":" + jsonArray(sceneNodes) +
+        ((scale == "1") ? String() : (",\"scale\":[" + scale + "," + scale + "," + scale + "]")) + "}");
+    json += jsonProp("nodes",nodes) + jsonProp("meshes",gltfMeshes) + jsonProp("materials",materials) +
+        jsonProp("textures",textures) + jsonProp("images",images) + jsonProp("accessors",glb.accessors) +
+        jsonProp("bufferViews",glb.bufferViews) + ",\"buffers\":[{\"byteLength\":" + toStr(glb.bin.size()) + "}]}";
+    // Chunks must be 4-byte aligned, padded with spaces for JSON and zeros for binary:
+    json.append((4 - json.size() % 4) % 4,' ');
+    glb.bin.append((4 - glb.bin.size() % 4) % 4,'\0');
+    Path                path {fname};
+    path.ext = "glb";
+    Ofstream            ofs {path.str()};
+    ofs.writeb(glbMagic);
+    ofs.writeb(uint32(2));
+    ofs.writeb(uint32(12 + 8 + json.size() + 8 + glb.bin.size()));
+    ofs.writeb(uint32(json.size()));
+    ofs.writeb(glbChunkJson);
+    ofs.write(json.data(),json.size());
+    ofs.writeb(uint32(glb.bin.size()));
+    ofs.writeb(glbChunkBin);
+    ofs.write(glb.bin.data(),glb.bin.size());
+}
+
+namespace {
+
+// Minimal JSON reader, sufficient to check the structure written above:
+struct  Json
+{
+    enum Type {null,boolean,number,string,array,object};
+    Type                type = null;
+    double              num = 0;
+    String              str;
+    Svec<Json>          elems;              // array
+    Svec<pair<String,Json> > members;       // object
+
+    bool
+    has(String const & key) const
+    {
+        for (auto const & m : members)
+            if (m.first == key)
+                return true;
+        return false;
+    }
+
+    Json const &
+    operator[](String const & key) const
+    {
+        for (auto const & m : members)
+            if (m.first == key)
+                return m.second;
+        fgThrow("JSON key not found",key);
+        return *this;
+    }
+
+    Json const &
+    operator[](size_t idx) const
+    {return elems.at(idx); }
+
+    size_t
+    idx() const
+    {return size_t(num); }
+};
+
+struct  JsonParser
+{
+    char const *        pos;
+    char const *        end;
+
+    void
+    skipWs()
+    {
+        while ((pos < end) && isspace(uchar(*pos)))
+            ++pos;
+    }
+
+    char
+    expect(char ch)
+    {
+        skipWs();
+        if ((pos == end) || (*pos != ch))
+            fgThrow("JSON expected",String(1,ch));
+        return *pos++;
+    }
+
+    String
+    parseStr()
+    {
+        expect('"');
+        String              ret;
+        while ((pos < end) && (*pos != '"')) {
+            if (*pos == '\\') {
+                ++pos;
+                if ((pos < end) && (*pos == 'u')) {
+                    ret += char(strtol(String(pos+1,pos+5).c_str(),nullptr,16));
+                    pos += 5;
+                    continue;
+                }
+            }
+            ret += *pos++;
+        }
+        expect('"');
+        return ret;
+    }
+
+    Json
+    parse()
+    {
+        Json                ret;
+        skipWs();
+        if (pos == end)
+            fgThrow("JSON truncated");
+        if (*pos == '{') {
+            ret.type = Json::object;
+            ++pos;
+            skipWs();
+            if (*pos == '}')
+                ++pos;
+            else do {
+                String              key = parseStr();
+                expect(':');
+                ret.members.push_back(make_pair(key,parse()));
+                skipWs();
+            } while (*pos++ == ',');
+        }
+        else if (*pos == '[') {
+            ret.type = Json::array;
+            ++pos;
+            skipWs();
+            if (*pos == ']')
+                ++pos;
+            else do {
+                ret.elems.push_back(parse());
+                skipWs();
+            } while (*pos++ == ',');
+        }
+        else if (*pos == '"') {
+            ret.type = Json::string;
+            ret.str = parseStr();
+        }
+        else if ((end - pos >= 4) && (String(pos,pos+4) == "true")) {
+            ret.type = Json::boolean;
+            ret.num = 1;
+            pos += 4;
+        }
+        else if ((end - pos >= 5) && (String(pos,pos+5) == "false")) {
+            ret.type = Json::boolean;
+            pos += 5;
+        }
+        else if ((end - pos >= 4) && (String(pos,pos+4) == "null"))
+            pos += 4;
+        else {
+            char *              after;
+            ret.type = Json::number;
+            ret.num = strtod(pos,&after);
+            if (after == pos)
+                fgThrow("JSON invalid value");
+            pos = after;
+        }
+        return ret;
+    }
+};
+
+struct  Glb
+{
+    Json                json;
+    String              bin;
+
+    explicit
+    Glb(Ustring const & fname)
+    {
+        String              data = loadRawString(fname);
+        auto                u32 = [&](size_t offset)
+        {
+            uint32              ret;
+            FGASSERT(offset+4 <= data.size());
+            memcpy(&ret,&data[offset],4);
+            return ret;
+        };
+        FGASSERT(u32(0) == glbMagic);
+        FGASSERT(u32(4) == 2);
+        FGASSERT(u32(8) == data.size());
+        size_t              jsonSize = u32(12);
+        FGASSERT((jsonSize % 4 == 0) && (u32(16) == glbChunkJson));
+        JsonParser          parser {&data[20],&data[20]+jsonSize};
+        json = parser.parse();
+        size_t              binPos = 20 + jsonSize;
+        FGASSERT(u32(binPos+4) == glbChunkBin);
+        bin = data.substr(binPos+8,u32(binPos));
+        FGASSERT(bin.size() % 4 == 0);
+        FGASSERT(json["buffers"][0]["byteLength"].idx() <= bin.size());
+    }
+
+    char const *
+    viewData(size_t viewIdx) const
+    {
+        Json const &        view = json["bufferViews"][viewIdx];
+        size_t              offset = view["byteOffset"].idx();
+        FGASSERT(offset % 4 == 0);
+        FGASSERT(offset + view["byteLength"].idx() <= bin.size());
+        return bin.data() + offset;
+    }
+
+    // Returns the elements of an accessor with sparse substitution applied:
+    template<class T>
+    Svec<T>
+    accessor(size_t accIdx,uint componentType) const
+    {
+        Json const &        acc = json["accessors"][accIdx];
+        FGASSERT(acc["componentType"].idx() == componentType);
+        Svec<T>             ret(acc["count"].idx(),T(0));
+        if (acc.has("bufferView"))
+            memcpy(ret.data(),viewData(acc["bufferView"].idx()),ret.size()*sizeof(T));
+        if (acc.has("sparse")) {
+            Json const &        sparse = acc["sparse"];
+            size_t              num = sparse["count"].idx();
+            FGASSERT(sparse["indices"]["componentType"].idx() == glbUint);
+            uint const *        inds = reinterpret_cast<uint const *>(viewData(sparse["indices"]["bufferView"].idx()));
+            T const *           vals = reinterpret_cast<T const *>(viewData(sparse["values"]["bufferView"].idx()));
+            for (size_t ii=0; ii<num; ++ii) {
+                FGASSERT((ii == 0) || (inds[ii] > inds[ii-1]));
+                ret.at(inds[ii]) = vals[ii];
+            }
+        }
+        return ret;
+    }
+};
+
+Vec3F
+jsonToVec3F(Json const & json)
+{return Vec3F(float(json[0].num),float(json[1].num),float(json[2].num)); }
+
+}
+
+void
+testSaveGlb(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    Mesh                jane = loadTri(dd+"Jane.tri"),
+                        glasses = loadTri(dd+"Glasses.tri");
+    jane.surfaces[0].setAlbedoMap(loadImage(dd+"Jane.jpg"));
+    glasses.surfaces[0].setAlbedoMap(loadImage(dd+"Glasses.tga"));
+    FGASSERT(!jane.deltaMorphs.empty() && !jane.targetMorphs.empty());
+    Meshes              meshes {jane,glasses};
+    saveMesh(meshes,"test.glb");
+    Glb                 glb("test.glb");
+    Json const &        json = glb.json;
+    FGASSERT(json["asset"]["version"].str == "2.0");
+    // The root node scales from millimetres to metres:
+    Json const &        root = json["nodes"][json["scenes"][0]["nodes"][0].idx()];
+    FGASSERT(root["scale"][0].num == 0.001);
+    FGASSERT(root["children"].elems.size() == meshes.size());
+    for (size_t mm=0; mm<meshes.size(); ++mm) {
+        Mesh const &        mesh = meshes[mm];
+        Json const &        gm = json["meshes"][json["nodes"][root["children"][mm].idx()]["mesh"].idx()];
+        FGASSERT(gm["name"].str == mesh.name.m_str);
+        size_t              numMorphs = mesh.deltaMorphs.size() + mesh.targetMorphs.size();
+        if (numMorphs > 0) {
+            Json const &        names = gm["extras"]["targetNames"];
+            FGASSERT(names.elems.size() == numMorphs);
+            for (size_t ii=0; ii<numMorphs; ++ii)
+                FGASSERT(names[ii].str == mesh.morphName(ii).m_str);
+        }
+        // Expected morph deltas for each original vertex:
+        Svec<Vec3Fs>        deltas;
+        for (Morph const & morph : mesh.deltaMorphs)
+            deltas.push_back(morph.verts);
+        for (IndexedMorph const & morph : mesh.targetMorphs) {
+            Vec3Fs              delta(mesh.verts.size(),Vec3F(0));
+            for (size_t ii=0; ii<morph.baseInds.size(); ++ii)
+                delta[morph.baseInds[ii]] = morph.verts[ii] - mesh.verts[morph.baseInds[ii]];
+            deltas.push_back(delta);
+        }
+        FGASSERT(gm["primitives"].elems.size() == mesh.surfaces.size());
+        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+            Json const &        prim = gm["primitives"][ss];
+            Json const &        attribs = prim["attributes"];
+            Json const &        posAcc = json["accessors"][attribs["POSITION"].idx()];
+            Vec3Fs              positions = glb.accessor<Vec3F>(attribs["POSITION"].idx(),glbFloat);
+            Mat32F              bounds = cBounds(positions);
+            FGASSERT(jsonToVec3F(posAcc["min"]) == bounds.colVec(0));
+            FGASSERT(jsonToVec3F(posAcc["max"]) == bounds.colVec(1));
+            Vec2Fs              uvs = glb.accessor<Vec2F>(attribs["TEXCOORD_0"].idx(),glbFloat);
+            Uints               inds = glb.accessor<uint>(prim["indices"].idx(),glbUint);
+            Svec<Vec3Fs>        targets;
+            for (size_t ii=0; ii<numMorphs; ++ii)
+                targets.push_back(glb.accessor<Vec3F>(prim["targets"][ii]["POSITION"].idx(),glbFloat));
+            Tris                tris = mesh.surfaces[ss].getTriEquivs();
+            FGASSERT(inds.size() == tris.size()*3);
+            for (size_t ii=0; ii<tris.size(); ++ii) {
+                for (uint vv=0; vv<3; ++vv) {
+                    uint                idx = inds[ii*3+vv],
+                                        posIdx = tris.posInds[ii][vv];
+                    Vec2F               uv = mesh.uvs[tris.uvInds[ii][vv]];
+                    FGASSERT(positions.at(idx) == mesh.verts[posIdx]);
+                    FGASSERT(uvs.at(idx) == Vec2F(uv[0],1.0f-uv[1]));
+                    for (size_t kk=0; kk<numMorphs; ++kk)
+                        FGASSERT(targets[kk][idx] == deltas[kk][posIdx]);
+                }
+            }
+            // Embedded PNG maps are lossless:
+            Json const &        mat = json["materials"][prim["material"].idx()];
+            size_t              texIdx = mat["pbrMetallicRoughness"]["baseColorTexture"]["index"].idx();
+            Json const &        img = json["images"][json["textures"][texIdx]["source"].idx()];
+            FGASSERT(img["mimeType"].str == "image/png");
+            Json const &        view = json["bufferViews"][img["bufferView"].idx()];
+            char const *        data = glb.viewData(img["bufferView"].idx());
+            Uchars              blob(data,data+view["byteLength"].idx());
+            FGASSERT(imgDecode(blob) == *mesh.surfaces[ss].material.albedoMap);
+        }
+    }
+}
+
+}
+
+// */
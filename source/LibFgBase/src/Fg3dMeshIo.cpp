@@ -12,6 +12,9 @@
 #include "FgSyntax.hpp"
 #include "FgCommand.hpp"
 #include "FgImageIo.hpp"
+#include "FgParallel.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
 
 using namespace std;
 
@@ -32,6 +35,7 @@ meshFormatExtension(MeshFormat mf)
         {MeshFormat::stl,"stl"},
         {MeshFormat::a3ds,"3ds"},
         {MeshFormat::xsi,"xsi"},
+        {MeshFormat::glb,"glb"},
     };
     auto            it = mfs.find(mf);
     FGASSERT(it != mfs.end());
@@ -53,6 +57,7 @@ meshFormatSpecifier(MeshFormat mf)
         {MeshFormat::stl,"3D Systems STL Binary"},
         {MeshFormat::a3ds,"Autodesk 3DS"},
         {MeshFormat::xsi,"Softimage XSI"},
+        {MeshFormat::glb,"glTF Binary"},
     };
     auto            it = mfs.find(mf);
     FGASSERT(it != mfs.end());
@@ -72,6 +77,7 @@ meshExportFormats()
         MeshFormat::ma,
         MeshFormat::lwo,
         MeshFormat::xsi,
+        MeshFormat::glb,
     };
 }
 
@@ -91,6 +97,10 @@ loadMesh(
             path.ext = "obj";
         else if (pathExists(fname + ".fgmesh"))
             path.ext = "fgmesh";
+        else if (pathExists(fname + ".ply"))
+            path.ext = "ply";
+        else if (pathExists(fname + ".stl"))
+            path.ext = "stl";
         else
             return false;
     }
@@ -101,6 +111,10 @@ loadMesh(
         mesh = loadWObj(path.str(),"usemtl");       // Split by material to remain 1-1 with any color map arguments
     else if (ext == "fgmesh")
         mesh = loadFgmesh(path.str());
+    else if (ext == "ply")
+        mesh = loadPly(path.str());
+    else if (ext == "stl")
+        mesh = loadStl(path.str());
     else
         fgThrow("Not a readable 3D mesh format",fname);
     return true;
@@ -131,13 +145,72 @@ loadMeshMaps(Ustring const & baseName)
     return ret;
 }
 
+namespace {
+
+Mesh
+loadMeshOrMaps(Ustring const & fname,bool maps)
+{return maps ? loadMeshMaps(fname) : loadMesh(fname); }
+
+// The loaders' warnings to 'fgout' are captured per file then output in input order after all
+// loading is done, since 'fgout' is not thread-safe:
+void
+loadConcurrently(size_t num,Sfun<void(size_t)> const & load,uint numThreads)
+{
+    Svec<ostringstream> outputs(num);
+    exception_ptr       error;
+    try {
+        parallelFor(num,[&](size_t ii)
+        {
+            FgOutCapture        capture(outputs[ii]);
+            load(ii);
+        },numThreads);
+    }
+    catch (...) {
+        error = current_exception();
+    }
+    for (ostringstream const & output : outputs)
+        fgout.writeCaptured(output.str());
+    if (error)
+        rethrow_exception(error);
+}
+
+}
+
+MeshLoadResults
+tryLoadMeshes(Ustrings const & fnames,bool maps,uint numThreads)
+{
+    MeshLoadResults     ret(fnames.size());
+    loadConcurrently(fnames.size(),[&](size_t ii)
+    {
+        MeshLoadResult &    res = ret[ii];
+        try {
+            res.mesh = loadMeshOrMaps(fnames[ii],maps);
+        }
+        catch (FgException const & e) {
+            res.error = e.no_tr_message();
+        }
+        catch (std::exception const & e) {
+            res.error = fnames[ii].m_str + ": " + e.what();
+        }
+    },numThreads);
+    return ret;
+}
+
+Meshes
+loadMeshes(Ustrings const & fnames,bool maps,uint numThreads)
+{
+    Meshes              ret(fnames.size());
+    loadConcurrently(fnames.size(),[&](size_t ii){ret[ii] = loadMeshOrMaps(fnames[ii],maps); },numThreads);
+    return ret;
+}
+
 Strings
 meshLoadFormats()
-{return svec<string>("fgmesh","obj","wobj","tri"); }
+{return svec<string>("fgmesh","obj","wobj","tri","ply","stl"); }
 
 string
 meshLoadFormatsCLDescription()
-{return string("(fgmesh | [w]obj | tri)"); }
+{return string("(fgmesh | [w]obj | tri | ply | stl)"); }
 
 void
 saveMesh(Meshes const & meshes,Ustring const & fname,string const & imgFormat)
@@ -165,6 +238,8 @@ saveMesh(Meshes const & meshes,Ustring const & fname,string const & imgFormat)
         save3ds(fname,meshes,imgFormat);
     else if (ext == "ply")
         savePly(fname,meshes,imgFormat);
+    else if (ext == "glb")
+        saveGlb(fname,meshes,imgFormat);
     else if (ext == "fgmesh")
         saveFgmesh(fname,meshes);
     else
@@ -184,6 +259,7 @@ meshExportFormatExtDescs()
         {"ma","Maya ASCII"},
         {"lwo","Lightwave Object"},
         {"xsi","Softimage"},
+        {"glb","glTF Binary"},
     };
     return ret;
 }
@@ -204,12 +280,12 @@ meshExportFormatDescriptions()
 
 std::string
 meshSaveFormatsCLDescription()
-{return string("(tri | [w]obj | dae | wrl | fbx | stl | lwo | ma | xsi | 3ds | ply)"); }
+{return string("(tri | [w]obj | dae | wrl | fbx | stl | lwo | ma | xsi | 3ds | ply | glb)"); }
 
 Strings const &
 meshExportFormatsWithMorphs()
 {
-    static Strings ret = svec<string>("dae","fbx","ma","lwo","xsi");
+    static Strings ret = svec<string>("dae","fbx","ma","lwo","xsi","glb");
     return ret;
 }
 
@@ -285,4 +361,71 @@ Cmd
 getTriExportCmd()
 {return Cmd(triexport,"triexport","Export meshes from FaceGen TRI format to other formats"); }
 
+void
+testLoadMeshes(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    Ustrings            fnames {dd+"Jane.tri",dd+"NoSuchMesh.tri",dd+"Mouth.tri",dd+"Glasses.tri"};
+    MeshLoadResults     results = tryLoadMeshes(fnames,false,3);
+    FGASSERT(results.size() == fnames.size());
+    for (size_t ii=0; ii<fnames.size(); ++ii) {
+        if (ii == 1) {
+            FGASSERT(!results[ii].error.empty());
+            continue;
+        }
+        Mesh                mesh = loadMesh(fnames[ii]);
+        FGASSERT(results[ii].error.empty());
+        FGASSERT(results[ii].mesh.verts == mesh.verts);
+        FGASSERT(results[ii].mesh.numFacets() == mesh.numFacets());
+        FGASSERT(results[ii].mesh.numMorphs() == mesh.numMorphs());
+    }
+    bool                threw = false;
+    try {loadMeshes(fnames); }
+    catch (FgException const &) {threw = true; }
+    FGASSERT(threw);
+    Meshes              meshes = loadMeshes({dd+"Jane",dd+"Glasses"},true);
+    for (size_t ii=0; ii<meshes.size(); ++ii) {
+        FGASSERT(meshes[ii].surfaces[0].material.albedoMap);
+        FGASSERT(*meshes[ii].surfaces[0].material.albedoMap == loadImage(dd+(ii==0 ? "Jane.jpg" : "Glasses.tga")));
+    }
+    // Loader warnings are output whole and in input order:
+    Ustrings            objs;
+    for (size_t ii=0; ii<8; ++ii) {
+        objs.push_back("warn"+toStr(ii)+".obj");
+        saveRaw("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\nf 1 2 9\n",objs.back(),false);
+    }
+    ostringstream       os;
+    {
+        FgOutCapture        capture(os);
+        tryLoadMeshes(objs,false,4);
+    }
+    String              output = os.str();
+    size_t              pos = 0;
+    for (Ustring const & obj : objs) {
+        String              warning = "WARNING: Error in line 5 of " + obj.m_str;
+        FGASSERT(output.find(warning,pos) != String::npos);
+        pos = output.find(warning,pos) + warning.size();
+    }
+}
+
+void
+testmLoadMeshes(CLArgs const &)
+{
+    Ustring             dd = dataDir() + "base/";
+    Ustrings            bases;
+    for (size_t ii=0; ii<4; ++ii)
+        for (String base : {"Jane","Glasses","JaneLoresFace","MouthSmall"})
+            bases.push_back(dd+base);
+    Timer               timer;
+    for (Ustring const & base : bases)
+        loadMeshMaps(base);
+    uint64              serialMs = timer.readMs();
+    timer.start();
+    loadMeshes(bases,true);
+    uint64              batchMs = timer.readMs();
+    fgout << fgnl << bases.size() << " meshes with maps, ms: serial " << serialMs
+        << ", batch on " << cNumThreads(0) << " threads " << batchMs;
+}
+
 }
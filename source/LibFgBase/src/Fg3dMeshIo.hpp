@@ -64,6 +64,7 @@ enum struct     MeshFormat
     stl,
     a3ds,
     xsi,
+    glb,
 };
 typedef Svec<MeshFormat>    MeshFormats;
 
@@ -89,6 +90,23 @@ Mesh    loadMesh(Ustring const & fname);
 // Loads both mesh and albedo map (if present) and specular map (if present):
 Mesh    loadMeshMaps(Ustring const & baseName);
 
+struct  MeshLoadResult
+{
+    Mesh                mesh;
+    String              error;          // Empty if the file was loaded, otherwise why it was not
+};
+typedef Svec<MeshLoadResult>    MeshLoadResults;
+
+// Loads each file as for 'loadMesh', or as for 'loadMeshMaps' if 'maps' is true, concurrently on up to
+// 'numThreads' threads (0 - all hardware threads). Results are in the order of 'fnames'. Failure to
+// load a file does not prevent the others from being loaded:
+MeshLoadResults
+tryLoadMeshes(Ustrings const & fnames,bool maps=false,uint numThreads=0);
+
+// As above but throws if any file fails to load:
+Meshes
+loadMeshes(Ustrings const & fnames,bool maps=false,uint numThreads=0);
+
 // Returns lower case list of supported extensions:
 Strings
 meshLoadFormats();
@@ -121,14 +139,89 @@ meshExportFormatsWithMorphs();
 std::string
 meshSaveFormatsCLDescription();
 
-// FaceGen mesh format load / save:
+class   MappedFile;
+
+// FaceGen mesh format load / save. Version 2 is saved, which stores each array, surface and morph as
+// an aligned, typed chunk listed in a directory, optionally compressed. Version 1 can still be loaded:
+
+struct  FgmeshOptions
+{
+    bool                compress = false;   // Zlib compress each chunk where that makes it smaller
+    // Lossy. Store base, delta morph and target morph vertices quantized to 16 bits (see QuantVerts),
+    // delta morphs with only the vertices moved by more than 'zeroTol' on some axis, and index arrays
+    // delta coded:
+    bool                quantize = false;
+    float               zeroTol = 0;
+};
 
 Mesh
 loadFgmesh(Ustring const & fname);
-void
-saveFgmesh(Ustring const & fname,Mesh const & mesh);
-void
-saveFgmesh(Ustring const & fname,Meshes const & meshes);
+// Returns the greatest quantization error of any vertex or morph delta (zero if not quantized):
+float
+saveFgmesh(Ustring const & fname,Mesh const & mesh,FgmeshOptions const & options=FgmeshOptions());
+float
+saveFgmesh(Ustring const & fname,Meshes const & meshes,FgmeshOptions const & options=FgmeshOptions());
+
+// Random access to the chunks of a version 2 FGMESH file through a read-only memory mapping, so
+// individual morphs can be read without reading the rest of the file. Morph names are not required
+// to be unique, in which case the first is used. Throws if the file is not a valid version 2 file:
+class   FgmeshMapped
+{
+public:
+    explicit
+    FgmeshMapped(Ustring const & fname);
+
+    size_t              numVerts() const {return m_numVerts; }
+    Vec3Fs              verts() const;
+    Ustrings            deltaMorphNames() const;
+    Ustrings            targetMorphNames() const;
+    bool                hasDeltaMorph(Ustring const & name) const {return (m_deltaMorphs.find(name) != m_deltaMorphs.end()); }
+    bool                hasTargetMorph(Ustring const & name) const {return (m_targetMorphs.find(name) != m_targetMorphs.end()); }
+    // Throw if there is no morph of the given name:
+    Morph               deltaMorph(Ustring const & name) const;
+    IndexedMorph        targetMorph(Ustring const & name) const;
+    // Returned without decoding if stored quantized, otherwise quantized with zero tolerance:
+    QuantMorph          quantDeltaMorph(Ustring const & name) const;
+
+    Mesh
+    toMesh() const;
+
+private:
+    struct  Chunk
+    {
+        uint32              type;
+        uint32              flags;
+        uint32              index;              // Of the surface or morph
+        Ustring             name;
+        uint64              offset;
+        uint64              size;               // Stored
+        uint64              rawSize;            // Decompressed
+    };
+    Sptr<MappedFile const>  m_file;
+    Svec<Chunk>             m_chunks;
+    size_t                  m_numVerts = 0;
+    // Chunk indices, with the vertex chunk of each target or quantized delta morph following its indices chunk:
+    std::map<Ustring,size_t> m_deltaMorphs;
+    std::map<Ustring,size_t> m_targetMorphs;
+
+    // Delta coded chunks are rejected since only index arrays are delta coded:
+    template<class T>
+    Svec<T>
+    chunkArray(Chunk const & chunk) const;
+
+    // 'T' must be uint or a vector of uint. Delta coded or not:
+    template<class T>
+    Svec<T>
+    chunkIndices(Chunk const & chunk) const;
+
+    QuantVerts
+    chunkQuant(Chunk const & chunk) const;
+
+    QuantMorph
+    quantDeltaMorphAt(size_t chunkIdx) const;   // Index of the quantized delta morph indices chunk
+
+    friend class FgmeshStreamReader;
+};
 
 // FaceGen legacy mesh format load / save:
 
@@ -136,6 +229,93 @@ Mesh        loadTri(std::istream & is);
 Mesh        loadTri(Ustring const & fname);
 Mesh        loadTri(Ustring const & meshFile,Ustring const & texFile);
 
+// Zero-copy access to a TRI file through a read-only memory mapping, for services that load the same
+// large files repeatedly. The header and layout are validated on construction. Arrays are views into
+// the mapping, valid for the lifetime of this object. The exception is an array left misaligned by a
+// preceding variable-length label, which is copied once on construction. Labels and names are only
+// decoded when requested:
+class   TriMapped
+{
+public:
+    explicit
+    TriMapped(Ustring const & fname);
+
+    // Views refer to the mapping and any aligned copies, so can be moved but not copied:
+    TriMapped(TriMapped &&) = default;
+    TriMapped(TriMapped const &) = delete;
+    TriMapped &
+    operator=(TriMapped const &) = delete;
+
+    ArrayView<Vec3F>    verts() const {return m_verts; }
+    ArrayView<Vec3UI>   tris() const {return m_tris; }
+    ArrayView<Vec4UI>   quads() const {return m_quads; }
+    // Empty if there are no UVs. Per-vertex UVs have no UV indices:
+    ArrayView<Vec2F>    uvs() const {return m_uvs; }
+    bool                perVertexUvs() const {return m_perVertexUvs; }
+    ArrayView<Vec3UI>   triUvInds() const {return m_triUvInds; }
+    ArrayView<Vec4UI>   quadUvInds() const {return m_quadUvInds; }
+
+    size_t              numMarkedVerts() const {return m_markedVerts.size(); }
+    MarkedVert          markedVert(size_t idx) const;
+    size_t              numSurfPoints() const {return m_surfPoints.size(); }
+    SurfPoint           surfPoint(size_t idx) const;
+
+    size_t              numDeltaMorphs() const {return m_deltaMorphs.size(); }
+    String              deltaMorphName(size_t idx) const;
+    // One quantized delta per vertex, which multiplied by the scale gives the morph delta:
+    ArrayView<Vec3S>    deltaMorphVals(size_t idx) const {return m_deltaMorphs[idx].vals; }
+    float               deltaMorphScale(size_t idx) const {return m_deltaMorphs[idx].scale; }
+
+    // Target morphs with no vertices are omitted, as by 'loadTri':
+    size_t              numTargetMorphs() const {return m_targetMorphs.size(); }
+    String              targetMorphName(size_t idx) const;
+    ArrayView<uint>     targetMorphBaseInds(size_t idx) const {return m_targetMorphs[idx].baseInds; }
+    ArrayView<Vec3F>    targetMorphVerts(size_t idx) const {return m_targetMorphs[idx].verts; }
+
+    // The same as 'loadTri' but with a single copy of each array (and no name):
+    Mesh
+    toMesh() const;
+
+private:
+    struct  DeltaMorph
+    {
+        size_t              namePos;
+        float               scale;
+        ArrayView<Vec3S>    vals;
+    };
+    struct  TargetMorph
+    {
+        size_t              namePos;
+        ArrayView<uint>     baseInds;
+        ArrayView<Vec3F>    verts;
+    };
+    Sptr<MappedFile const>  m_file;
+    bool                    m_wchar = false;        // Labels are stored as 'wchar_t'
+    ArrayView<Vec3F>        m_verts;
+    ArrayView<Vec3UI>       m_tris,
+                            m_triUvInds;
+    ArrayView<Vec4UI>       m_quads,
+                            m_quadUvInds;
+    ArrayView<Vec2F>        m_uvs;
+    bool                    m_perVertexUvs = false;
+    Sizes                   m_markedVerts;          // File position of each record
+    Sizes                   m_surfPoints;           // "
+    Svec<DeltaMorph>        m_deltaMorphs;
+    Svec<TargetMorph>       m_targetMorphs;
+    Svec<Uints>             m_copies;               // Aligned copies of misaligned arrays
+
+    void const *
+    alignedPtr(size_t pos,size_t bytes,size_t align);
+
+    template<class T>
+    ArrayView<T>
+    viewAt(size_t pos,size_t num)
+    {return ArrayView<T>(static_cast<T const *>(alignedPtr(pos,num*sizeof(T),alignof(T))),num); }
+
+    String
+    labelAt(size_t pos) const;
+};
+
 // Merges all surfaces:
 void
 saveTri(Ustring const & fname,Mesh const & mesh);
@@ -177,6 +357,42 @@ saveFbx(Ustring const & filename,Meshes const & meshes,String imgFormat = "png")
 void
 saveStl(Ustring const & fname,Meshes const & meshes);
 
+// Binary STL only. Vertices at exactly the same position are welded and facets left degenerate by
+// welding are removed. Returns a single surface of tris:
+Mesh
+loadStl(Ustring const & fname);
+
+// Exact vertex position matching is done on the bit patterns since float comparisons are not
+// reliable under -ffast-math, which assumes there are no NaNs and ignores the sign of zero:
+inline bool
+isNanBits(uint bits)
+{return ((bits & 0x7F800000U) == 0x7F800000U) && ((bits & 0x007FFFFFU) != 0); }
+
+// The bit patterns of a position with -0 replaced by +0, so that equal positions have equal bits
+// except for NaNs:
+inline Vec3UI
+cPosBits(Vec3F pos)
+{
+    Vec3UI              ret;
+    memcpy(&ret[0],&pos[0],sizeof(ret));
+    for (uint dd=0; dd<3; ++dd)
+        if ((ret[dd] & 0x7FFFFFFFU) == 0)
+            ret[dd] = 0;
+    return ret;
+}
+
+struct  PosBitsHash
+{
+    size_t
+    operator()(Vec3UI const & v) const
+    {
+        uint64          h = (uint64(v[0]) << 32) ^ v[1];
+        h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        h ^= uint64(v[2]) * 0x94D049BB133111EBULL;
+        return size_t(h ^ (h >> 31));
+    }
+};
+
 // Morph targets are also saved:
 void
 saveLwo(Ustring const & fname,Meshes const & meshes,String imgFormat = "png");
@@ -203,10 +419,23 @@ save3ds(Ustring const & fname,Meshes meshes,String imgFormat = "png");
 void
 savePly(Ustring const & fname,Meshes const & meshes,String imgFormat = "png");
 
+// ASCII, binary little-endian and binary big-endian PLY. Reads vertex positions, per-vertex UVs
+// (u,v or s,t), facets with 3 or more vertices (larger polygons are fan triangulated) and per-facet
+// 'texcoord' UVs. Other elements and properties are skipped. Returns a single surface:
+Mesh
+loadPly(Ustring const & fname);
+
 // Collada. Does not yet support morphs.
 void
 saveDae(Ustring const & fname,Meshes const & meshes,String imgFormat = "png",SpatialUnit unit=SpatialUnit::millimetre);
 
+// glTF 2.0 binary. Each mesh is a glTF mesh with one primitive per surface, quads are triangulated and
+// vertices are split at UV seams. Albedo maps are embedded as PNG or, if 'imgFormat' is "jpg", JPEG.
+// Delta morphs are saved as dense morph targets and target morphs as sparse morph targets, named by
+// 'extras.targetNames'. Positions are unscaled with the scene scaled to metres by the root node:
+void
+saveGlb(Ustring const & fname,Meshes const & meshes,String imgFormat = "png",SpatialUnit unit=SpatialUnit::millimetre);
+
 }
 
 #endif
@@ -7,6 +7,7 @@
 #include "stdafx.h"
 #include "Fg3dMeshLegacy.hpp"
 #include "FgStdStream.hpp"
+#include "FgTextWriter.hpp"
 #include "FgImage.hpp"
 #include "FgFileSystem.hpp"
 #include "Fg3dMeshOps.hpp"
@@ -125,11 +126,11 @@ static string getObjectTexFileName(
 static string getObjectTexPlaceName(
         const FffMultiObjectC &model, unsigned long mm);
 
-static void writeTexCoord(ofstream &ofs, const vector<Vec2F> &texCoord);
-static void writeVertices(ofstream &ofs, const vector<Vec3F> &vtxList);
-static void writeEdges(ofstream &ofs, const vector<Vec2UI> &edgeList);
+static void writeTexCoord(TextWriter &ofs, const vector<Vec2F> &texCoord);
+static void writeVertices(TextWriter &ofs, const vector<Vec3F> &vtxList);
+static void writeEdges(TextWriter &ofs, const vector<Vec2UI> &edgeList);
 static void writeFacets(
-        ofstream                    &ofs,
+        TextWriter                  &ofs,
         const vector<Vec3F>    &vtxList,
         Vec3UIs const    &triList,
         const vector<Vec4UI>    &quadList,
@@ -138,26 +139,26 @@ static void writeFacets(
         Vec3UIs const    &texTriList,
         const vector<Vec4UI>    &texQuadList);
 static void writeObjects(
-        ofstream                        &ofs,
+        TextWriter                      &ofs,
         const FffMultiObjectC           &model,
         const vector<FffMultiObjectC>   *morphTargets,
         Strings const            *morphNames,
         vector<int>                     &edgeSizeList);
 static int writeShadingMaterialPhong(
-        ofstream                        &ofs,
+        TextWriter                      &ofs,
         const FffMultiObjectC           &model,
         Strings const            *morphNames);
 static void writeBlendShapes(
-        ofstream                        &ofs, 
+        TextWriter                      &ofs, 
         const FffMultiObjectC           &model,
         Strings const            *morphNames);
 static void writePolySoftEdge(
-        ofstream                        &ofs, 
+        TextWriter                      &ofs, 
         const FffMultiObjectC           &model,
         Strings const            *morphNames,
         const vector<int>               &edgeSizeList);
 static void connectAttributes(
-        ofstream                        &ofs,
+        TextWriter                      &ofs,
         const FffMultiObjectC           &model,
         Strings const            *morphNames);
 
@@ -218,7 +219,7 @@ static bool saveMayaAsciiFile(
 
     Path      path(fname);
     path.ext = "ma";
-    Ofstream ofs(path.str());
+    TextWriter ofs(path.str());
     if (!ofs)
     {
         return false;
@@ -837,7 +838,7 @@ static string getObjectTexPlaceName(
 //****************************************************************************
 //                              writeTexCoord
 //****************************************************************************
-static void writeTexCoord(ofstream &ofs, const vector<Vec2F> &texCoord)
+static void writeTexCoord(TextWriter &ofs, const vector<Vec2F> &texCoord)
 {
     if (texCoord.size())
     {
@@ -865,7 +866,7 @@ static void writeTexCoord(ofstream &ofs, const vector<Vec2F> &texCoord)
 //****************************************************************************
 //                              writeVertices
 //****************************************************************************
-static void writeVertices(ofstream &ofs, const vector<Vec3F> &vtxList)
+static void writeVertices(TextWriter &ofs, const vector<Vec3F> &vtxList)
 {
     ofs << "\tsetAttr -s " << vtxList.size() 
                 << " \".vt[0:" << vtxList.size()-1 << "]\"\n";
@@ -890,7 +891,7 @@ static void writeVertices(ofstream &ofs, const vector<Vec3F> &vtxList)
 //****************************************************************************
 //                              writeEdges
 //****************************************************************************
-static void writeEdges(ofstream &ofs, const vector<Vec2UI> &edgeList)
+static void writeEdges(TextWriter &ofs, const vector<Vec2UI> &edgeList)
 {
     ofs << "\tsetAttr -s " << edgeList.size() 
                 << " \".ed[0:" << edgeList.size()-1 << "]\"\n";
@@ -916,7 +917,7 @@ static void writeEdges(ofstream &ofs, const vector<Vec2UI> &edgeList)
 //****************************************************************************
 static void writeFacets(
 
-    ofstream                    &ofs,
+    TextWriter                  &ofs,
     const vector<Vec3F>    &vtxList,
     Vec3UIs const    &triList,
     const vector<Vec4UI>    &quadList,
@@ -1014,7 +1015,7 @@ static void writeFacets(
 //****************************************************************************
 static void writeObjects(
 
-    ofstream                        &ofs,
+    TextWriter                      &ofs,
     const FffMultiObjectC           &model,
     const vector<FffMultiObjectC>   *morphTargets,
     Strings const            *morphNames,
@@ -1192,7 +1193,7 @@ static void writeObjects(
 //****************************************************************************
 static int writeShadingMaterialPhong(
 
-    ofstream                    &ofs,
+    TextWriter                  &ofs,
     const FffMultiObjectC       &model,
     Strings const        *morphNames)
 {
@@ -1259,7 +1260,7 @@ static int writeShadingMaterialPhong(
 //****************************************************************************
 static void writeBlendShapes(
 
-    ofstream                    &ofs, 
+    TextWriter                  &ofs, 
     const FffMultiObjectC       &model,
     Strings const        *morphNames)
 {
@@ -1366,7 +1367,7 @@ static void writeBlendShapes(
 //****************************************************************************
 static void writePolySoftEdge(
 
-    ofstream                    &ofs, 
+    TextWriter                  &ofs, 
     const FffMultiObjectC       &model,
     Strings const        *morphNames,
     const vector<int>           &edgeSizeList)
@@ -1410,7 +1411,7 @@ static void writePolySoftEdge(
 //****************************************************************************
 static void connectAttributes(
 
-    ofstream                        &ofs,
+    TextWriter                      &ofs,
     const FffMultiObjectC           &model,
     Strings const            *morphNames)
 {
@@ -9,14 +9,32 @@
 //
 
 #include "stdafx.h"
+
+// 'parseFloatFast' relies on a correctly rounded divide, which fast math may replace by a multiply with
+// the reciprocal, so fast math is disabled here:
+#if defined(_MSC_VER) || defined(__INTEL_COMPILER)
+#pragma float_control(precise,on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma float_control(precise,on)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("no-fast-math","fp-contract=off")
+#endif
+
 #include "FgStdStream.hpp"
 #include "FgImage.hpp"
 #include "FgFileSystem.hpp"
 #include "Fg3dMeshIo.hpp"
+#include "Fg3dMeshStream.hpp"
 #include "Fg3dMeshOps.hpp"
 #include "FgParse.hpp"
 #include "Fg3dNormals.hpp"
 #include "FgTestUtils.hpp"
+#include "FgParallel.hpp"
+#include "FgSyntax.hpp"
+#include "FgTime.hpp"
+#include "FgTextWriter.hpp"
 
 using namespace std;
 
@@ -42,24 +60,191 @@ namespace Fg {
 //    ofs.close();
 //}
 
+// Characters of a line or token within the file buffer, so that no string is allocated for each:
+struct  ObjChars
+{
+    char const *        beg;
+    char const *        end;
+
+    size_t
+    size() const
+    {return size_t(end - beg); }
+
+    bool
+    empty() const
+    {return (beg == end); }
+
+    char
+    operator[](size_t idx) const
+    {return beg[idx]; }
+
+    String
+    str() const
+    {return String(beg,end); }
+};
+
+static
+ObjChars
+objLine(char const * beg,char const * end)      // Returns the line starting at 'beg'
+{
+    char const *        ptr = beg;
+    while ((ptr != end) && (*ptr != '\n') && (*ptr != '\r'))
+        ++ptr;
+    return ObjChars {beg,ptr};
+}
+
+// As 'splitChar' but into the given storage to avoid allocation:
+static
+void
+splitObj(ObjChars str,char ch,bool incEmpty,Svec<ObjChars> & ret)
+{
+    ret.clear();
+    char const *        beg = str.beg;
+    for (char const * ptr=str.beg; ptr!=str.end; ++ptr) {
+        if (*ptr == ch) {
+            if ((ptr != beg) || incEmpty)
+                ret.push_back(ObjChars{beg,ptr});
+            beg = ptr + 1;
+        }
+    }
+    if ((beg != str.end) || incEmpty)
+        ret.push_back(ObjChars{beg,str.end});
+}
+
+// The C library parsers give the same values as a stream extraction (which uses them) but without
+// constructing a stream. They require null termination so the token is copied to the stack:
+static const size_t objMaxToken = 64;
+
+// Powers of ten exactly representable as floats:
+static float const objPow10[] = {1e0f,1e1f,1e2f,1e3f,1e4f,1e5f,1e6f,1e7f,1e8f,1e9f,1e10f};
+
+// Plain decimals (as written by most exporters) whose significant digits and power of ten are both exactly
+// representable are converted with a single correctly rounded multiply or divide, so give exactly the
+// value of 'strtof' much faster. Returns false if the token is not of this form:
+static
+bool
+parseFloatFast(ObjChars tok,float & ret)
+{
+    char const *        ptr = tok.beg;
+    bool                neg = false;
+    if ((ptr != tok.end) && ((*ptr == '-') || (*ptr == '+')))
+        neg = (*ptr++ == '-');
+    uint64              mant = 0;
+    int                 exp10 = 0;
+    uint                numDigits = 0;
+    for (; (ptr != tok.end) && (uint(*ptr-'0') < 10); ++ptr) {
+        if (++numDigits > 18)
+            return false;
+        mant = mant * 10 + uint(*ptr-'0');
+    }
+    if ((ptr != tok.end) && (*ptr == '.')) {
+        for (++ptr; (ptr != tok.end) && (uint(*ptr-'0') < 10); ++ptr) {
+            if (++numDigits > 18)
+                return false;
+            mant = mant * 10 + uint(*ptr-'0');
+            --exp10;
+        }
+    }
+    if (numDigits == 0)
+        return false;
+    if ((ptr != tok.end) && ((*ptr | 0x20) == 'e')) {
+        ++ptr;
+        bool                expNeg = false;
+        if ((ptr != tok.end) && ((*ptr == '-') || (*ptr == '+')))
+            expNeg = (*ptr++ == '-');
+        int                 exp = 0;
+        uint                numExpDigits = 0;
+        for (; (ptr != tok.end) && (uint(*ptr-'0') < 10); ++ptr) {
+            if (++numExpDigits > 4)
+                return false;
+            exp = exp * 10 + (*ptr-'0');
+        }
+        if (numExpDigits == 0)
+            return false;
+        exp10 += expNeg ? -exp : exp;
+    }
+    // Zero is left to the library to preserve its sign, which fast math may not:
+    if ((ptr != tok.end) || (mant == 0) || (mant > (uint64(1) << 24)) || (exp10 < -10) || (exp10 > 10))
+        return false;
+    float               val = float(mant);
+    val = (exp10 < 0) ? val / objPow10[-exp10] : val * objPow10[exp10];
+    ret = neg ? -val : val;
+    return true;
+}
+
 static
 float
-parseFloat(string const & str)
+parseFloat(ObjChars tok)
 {
-    istringstream   iss(str);
-    float           ret;
-    iss >> ret;
+    float               fast;
+    if (parseFloatFast(tok,fast))
+        return fast;
+    bool                plain = (tok.size() < objMaxToken);
+    // Stream extraction does not accept hexadecimal, infinity or NaN so leave those to a stream:
+    for (char const * ptr=tok.beg; plain && (ptr!=tok.end); ++ptr) {
+        char                lc = *ptr | 0x20;
+        plain = (lc != 'x') && (lc != 'i') && (lc != 'n');
+    }
+    if (!plain) {
+        istringstream       iss(tok.str());
+        float               ret;
+        iss >> ret;
+        return ret;
+    }
+    char                buf[objMaxToken];
+    memcpy(buf,tok.beg,tok.size());
+    buf[tok.size()] = 0;
+    errno = 0;
+    float               ret = strtof(buf,nullptr);
+    // Stream extraction clamps overflow to the largest value rather than infinity:
+    if ((errno == ERANGE) && ((ret > 1.0f) || (ret < -1.0f)))
+        ret = (ret > 0.0f) ? numeric_limits<float>::max() : -numeric_limits<float>::max();
     return ret;
 }
 
+static
+int
+parseInt(ObjChars tok)
+{
+    // Plain integers short enough not to overflow are converted directly:
+    if (tok.size() < 10) {
+        char const *        ptr = tok.beg;
+        bool                neg = false;
+        if ((ptr != tok.end) && ((*ptr == '-') || (*ptr == '+')))
+            neg = (*ptr++ == '-');
+        int                 ret = 0;
+        char const *        digitsBeg = ptr;
+        for (; (ptr != tok.end) && (uint(*ptr-'0') < 10); ++ptr)
+            ret = ret * 10 + (*ptr-'0');
+        if ((ptr == tok.end) && (ptr != digitsBeg))
+            return neg ? -ret : ret;
+    }
+    if (tok.size() >= objMaxToken) {
+        istringstream       iss(tok.str());
+        int                 ret;
+        iss >> ret;
+        return ret;
+    }
+    char                buf[objMaxToken];
+    memcpy(buf,tok.beg,tok.size());
+    buf[tok.size()] = 0;
+    char *              end;
+    long                ret = strtol(buf,&end,10);
+    if (end == buf)                                 // No number, as for a failed extraction
+        return 0;
+    // Stream extraction clamps to the 'int' range:
+    return int(clampBounds(ret,long(numeric_limits<int>::min()),long(numeric_limits<int>::max())));
+}
+
 static
 Vec3F
 parseVert(
-    string const &  str,
-    bool &          homogeneous, // Set to true if there is a homogeneous coord (which is ignored)
-    bool &          vertColors) // Set to true if there is a vertex color specified (which is ignored)
+    ObjChars            str,
+    bool &              homogeneous, // Set to true if there is a homogeneous coord (which is ignored)
+    bool &              vertColors,  // Set to true if there is a vertex color specified (which is ignored)
+    Svec<ObjChars> &    nums)        // Working storage
 {
-    Strings         nums = splitChar(str,' ');
+    splitObj(str,' ',false,nums);
     if (nums.size() < 3)
         fgThrow("Too few values specifying vertex");
     else if (nums.size() == 4)
@@ -78,9 +263,9 @@ parseVert(
 
 static
 Vec2F
-parseUv(string const & str)
+parseUv(ObjChars str,Svec<ObjChars> & nums)
 {
-    Strings  nums = splitChar(str,' ');
+    splitObj(str,' ',false,nums);
     // A third homogeneous coord value can also be specified but is only used for rational
     // cureves so we ignore:
     FGASSERT((nums.size() > 1) && (nums.size() < 4));
@@ -90,159 +275,471 @@ parseUv(string const & str)
     return ret;
 }
 
+// The indices of a facet corner as given in the file. Indices are resolved once all the chunks are parsed
+// since they depend on the number of vertices and UVs before them:
+struct  ObjCorner
+{
+    int                 vals[2];
+    bool                isUv[2];
+    uint                num;                // Indices given of the (position,UV) pair. Normal indices are ignored
+};
+
+struct  ObjFacet
+{
+    char const *        lineBeg;
+    size_t              line;               // Non-empty line index within the chunk
+    uint                numVerts;           // Number of vertices in the chunk before this facet
+    uint                numUvs;             // Number of UVs "
+    uint                cornersEnd;         // Corners are [previous facet's 'cornersEnd','cornersEnd')
+};
+
+// Lines other than vertices, UVs and facets which affect the result:
+struct  ObjEvent
+{
+    enum class Type { separator, badSeparator, error };
+    Type                type;
+    size_t              line;               // Non-empty line index within the chunk
+    size_t              numFacets;          // Number of facets in the chunk before this line
+    String              msg;                // Separator name or error message
+    ObjChars            lineChars;
+};
+
+struct  ObjChunk
+{
+    ObjChars            chars;              // A whole number of lines of the file
+    size_t              numLines = 0;       // Non-empty lines parsed
+    Vec3Fs              verts;
+    Vec2Fs              uvs;
+    Svec<ObjCorner>     corners;
+    Svec<ObjFacet>      facets;
+    Svec<ObjEvent>      events;
+    bool                vertexHomog = false,
+                        vertexColors = false,
+                        stopped = false;    // An invalid separator stopped parsing
+};
+
 static
-bool
-parseFacet(
-    string const &      str,
-    size_t              numVerts,
-    size_t              numUvs,
-    FacetInds<3> &    tris,
-    FacetInds<4> &    quads)
+void
+parseFacet(ObjChars str,Svec<ObjChars> & strs,Svec<ObjChars> & ns,Svec<ObjCorner> & corners)
 {
-    bool            ret = false;
-    Strings  strs = splitChar(str,' ');
+    splitObj(str,' ',false,strs);
     FGASSERT(strs.size() > 2);
-    vector<Uints >   nums;
-    for (size_t ii=0; ii<strs.size(); ++ii) {
-        Strings  ns = splitChar(strs[ii],'/',true);
-        size_t          sz = cMin(ns.size(),size_t(2));    // Ignore normal indices
-        Uints    nms;
+    for (ObjChars s : strs) {
+        splitObj(s,'/',true,ns);
+        size_t              sz = cMin(ns.size(),size_t(2));    // Ignore normal indices
+        ObjCorner           corner;
+        corner.num = 0;
         for (size_t jj=0; jj<sz; ++jj) {
-            size_t      numLim = ((jj == 0) ? numVerts : numUvs);
             if (!ns[jj].empty()) {
-                istringstream   iss(ns[jj]);
-                int             num;
-                iss >> num;
-                --num;                              // WOBJ indexing starts at 1
-                FGASSERT(num < int(numLim));
-                // Indices can be negative in which case -1 refers to last index and so on backward:
-                if (num < 0) {
-                    FGASSERT(size_t(-num) <= numLim);
-                    nms.push_back(uint(int(numLim)+num));
-                }
-                else
-                    nms.push_back(uint(num));
+                corner.vals[corner.num] = parseInt(ns[jj]);
+                corner.isUv[corner.num] = (jj == 1);
+                ++corner.num;
             }
         }
-        nums.push_back(nms);
-    }
-    for (size_t ii=1; ii<nums.size(); ++ii)
-        FGASSERT(nums[ii].size() == nums[ii-1].size());
-    if (nums.size() == 3) {
-        tris.posInds.push_back(Vec3UI(nums[0][0],nums[1][0],nums[2][0]));
-        if (nums[0].size() > 1)
-            tris.uvInds.push_back(Vec3UI(nums[0][1],nums[1][1],nums[2][1]));
-    }
-    if (nums.size() == 4) {
-        quads.posInds.push_back(Vec4UI(nums[0][0],nums[1][0],nums[2][0],nums[3][0]));
-        if (nums[0].size() > 1)
-            quads.uvInds.push_back(Vec4UI(nums[0][1],nums[1][1],nums[2][1],nums[3][1]));
-    }
-    if (nums.size() > 4) {          // N-gon
-        for (size_t ii=0; ii<nums.size()-2; ++ii) {
-            tris.posInds.push_back(Vec3UI(nums[0][0],nums[ii+1][0],nums[ii+2][0]));
-            if (nums[ii].size() > 1)
-                tris.uvInds.push_back(Vec3UI(nums[0][1],nums[ii+1][1],nums[ii+2][1]));
-        }
-        ret = true;
+        corners.push_back(corner);
     }
-    return ret;
 }
 
-Mesh
-loadWObj(
-    Ustring const &     fname,
-    string              surfSeparator)
+static
+void
+parseChunk(ObjChunk & chunk,String const & surfSeparator)
 {
-    Mesh                mesh;
-    string              currName;
-    map<string,Surf>    surfs;
-    Strings             lines = splitLines(loadRawString(fname));   // Removes empty lines
-    Surf                surf;
-    size_t              numNgons = 0;
-    bool                vertexColors = false,
-                        vertexHomog = false;
-    for (size_t ii=0; ii<lines.size(); ++ii) {
+    Svec<ObjChars>      toks,
+                        subToks;
+    char const *        ptr = chunk.chars.beg,
+               *        end = chunk.chars.end;
+    for (;;) {
+        while ((ptr != end) && ((*ptr == '\n') || (*ptr == '\r')))
+            ++ptr;
+        if (ptr == end)
+            break;
+        ObjChars            line = objLine(ptr,end);
+        ptr = line.end;
+        size_t              ll = chunk.numLines++,
+                            sz = line.size();
         try {
-            string const &  line = lines[ii];
             if (line[0] == 'v') {
-                if (line.at(1) == ' ')
-                    mesh.verts.push_back(parseVert(line.substr(2),vertexHomog,vertexColors));
-                if (line.at(1) == 't')
-                    if (line.at(2) == ' ')
-                        mesh.uvs.push_back(parseUv(line.substr(3)));
+                if ((sz > 1) && (line[1] == ' '))
+                    chunk.verts.push_back(parseVert(ObjChars{line.beg+2,line.end},
+                        chunk.vertexHomog,chunk.vertexColors,toks));
+                if ((sz > 2) && (line[1] == 't') && (line[2] == ' '))
+                    chunk.uvs.push_back(parseUv(ObjChars{line.beg+3,line.end},toks));
             }
-            if (line[0] == 'f') {
-                if (line.at(1) == ' ') {
-                    if (parseFacet(line.substr(2),mesh.verts.size(),mesh.uvs.size(),surf.tris,surf.quads))
-                        ++numNgons;
-                }
+            if ((line[0] == 'f') && (sz > 1) && (line[1] == ' ')) {
+                parseFacet(ObjChars{line.beg+2,line.end},toks,subToks,chunk.corners);
+                chunk.facets.push_back(ObjFacet{line.beg,ll,uint(chunk.verts.size()),uint(chunk.uvs.size()),
+                    uint(chunk.corners.size())});
             }
-            if (!surfSeparator.empty() && beginsWith(line,surfSeparator)) {
-                Strings  words = splitAtSeparators(line,' ');
-                if (words.size() != 2) {
-                    fgout << "WARNING: Invalid " << surfSeparator << " name on line " << ii << " of " << fname;
+            if (!surfSeparator.empty() && (sz >= surfSeparator.size()) &&
+                equal(surfSeparator.begin(),surfSeparator.end(),line.beg)) {
+                // As 'splitAtSeparators', which keeps empty words except at the end:
+                splitObj(line,' ',true,toks);
+                if (!toks.empty() && toks.back().empty())
+                    toks.pop_back();
+                if (toks.size() != 2) {
+                    chunk.events.push_back(ObjEvent{ObjEvent::Type::badSeparator,ll,chunk.facets.size(),{},line});
+                    chunk.stopped = true;
                     break;
                 }
-                string          name = words[1];
-                if (currName != name) {
-                    if (!surf.empty()) {
-                        if (surfs.find(currName) == surfs.end())
-                            surfs[currName] = surf;
-                        else
-                            surfs[currName].merge(surf);
-                    }
-                    currName = name;
-                    surf = Surf();
-                }
+                chunk.events.push_back(ObjEvent{ObjEvent::Type::separator,ll,chunk.facets.size(),
+                    toks[1].str(),line});
             }
-            if (line[0] == '#')
-                continue;
         }
         catch(const FgException & e) {
-            fgout << fgnl << "WARNING: Error in line " << ii+1 << " of " << fname << ": " << e.tr_message() << fgpush
-                << fgnl << lines[ii] << fgpop;
+            chunk.events.push_back(ObjEvent{ObjEvent::Type::error,ll,chunk.facets.size(),e.tr_message(),line});
+        }
+    }
+}
+
+// Returns true if the facet was an N-gon broken into tris:
+static
+bool
+addFacet(
+    ObjCorner const *   corners,
+    size_t              num,
+    size_t              numVerts,
+    size_t              numUvs,
+    Svec<Vec2UI> &      inds,               // Working storage
+    Surf &              surf)
+{
+    inds.resize(num);
+    for (size_t ii=0; ii<num; ++ii) {
+        ObjCorner const &   corner = corners[ii];
+        for (uint jj=0; jj<corner.num; ++jj) {
+            size_t              numLim = (corner.isUv[jj] ? numUvs : numVerts);
+            int64               val = corner.vals[jj];
+            // Indices can be negative in which case -1 refers to last index and so on backward:
+            if (val < 0) {
+                FGASSERT(uint64(-val) <= numLim);
+                inds[ii][jj] = uint(int64(numLim)+val);
+            }
+            else {
+                FGASSERT((val > 0) && (uint64(val) <= numLim));
+                inds[ii][jj] = uint(val-1);                     // WOBJ indexing starts at 1
+            }
         }
     }
-    if (numNgons > 0)
-        fgout << fgnl << "WARNING: " << numNgons << " N-gons broken into tris in " << fname;
-    if (vertexHomog)
-        fgout << fgnl << "WARNING: Vertex homogeneous coordinates ignored.";
-    if (vertexColors)
-        fgout << fgnl << "WARNING: Vertex color values ignored.";
+    for (size_t ii=1; ii<num; ++ii)
+        FGASSERT(corners[ii].num == corners[ii-1].num);
+    FGASSERT(corners[0].num > 0);
+    bool                uvs = (corners[0].num > 1);
+    if (num == 3) {
+        surf.tris.posInds.push_back(Vec3UI(inds[0][0],inds[1][0],inds[2][0]));
+        if (uvs)
+            surf.tris.uvInds.push_back(Vec3UI(inds[0][1],inds[1][1],inds[2][1]));
+    }
+    if (num == 4) {
+        surf.quads.posInds.push_back(Vec4UI(inds[0][0],inds[1][0],inds[2][0],inds[3][0]));
+        if (uvs)
+            surf.quads.uvInds.push_back(Vec4UI(inds[0][1],inds[1][1],inds[2][1],inds[3][1]));
+    }
+    if (num > 4) {          // N-gon
+        for (size_t ii=0; ii<num-2; ++ii) {
+            surf.tris.posInds.push_back(Vec3UI(inds[0][0],inds[ii+1][0],inds[ii+2][0]));
+            if (uvs)
+                surf.tris.uvInds.push_back(Vec3UI(inds[0][1],inds[ii+1][1],inds[ii+2][1]));
+        }
+        return true;
+    }
+    return false;
+}
+
+static
+void
+addSurf(map<string,Surf> & surfs,string const & name,Surf const & surf)
+{
     if (!surf.empty()) {
-        if (surfs.find(currName) == surfs.end())
-            surfs[currName] = surf;
+        if (surfs.find(name) == surfs.end())
+            surfs[name] = surf;
         else
-            surfs[currName].merge(surf);
+            surfs[name].merge(surf);
+    }
+}
+
+static
+void
+clearPartialUvs(Surf & surf,Ustring const & fname,string const & name)
+{
+    if (!surf.tris.valid() || !surf.quads.valid()) {
+        surf.tris.uvInds.clear();
+        surf.quads.uvInds.clear();
+        fgout << fgnl << "WARNING: Partial UV indices ignored in " << fname << " surface " << name;
     }
+}
+
+// Resolves the facets of parsed chunks in file order into runs of facets between separator name changes,
+// warning of errors. Used by both whole file and streaming loads so they behave identically:
+struct  ObjAssembler
+{
+    Ustring             fname;
+    string              surfSeparator;
+    string              currName;           // Of the separator in effect
+    size_t              lineBase = 0,       // Totals of the chunks added so far:
+                        numVerts = 0,
+                        numUvs = 0,
+                        numNgons = 0;
+    bool                vertexHomog = false,
+                        vertexColors = false,
+                        uvsWrapped = false;
+    Svec<Vec2UI>        inds;               // Working storage
+
+    ObjAssembler(Ustring const & f,string const & s) : fname(f), surfSeparator(s) {}
+
+    // Calls 'addRun(name,surf)' for each run of facets in the chunk, the last of which may be empty:
+    void
+    add(ObjChunk const & chunk,Sfun<void(string const &,Surf &)> const & addRun)
+    {
+        Surf                surf;
+        size_t              facetIdx = 0;
+        auto                addFacets = [&](size_t facetEnd)
+        {
+            for (; facetIdx<facetEnd; ++facetIdx) {
+                ObjFacet const &    facet = chunk.facets[facetIdx];
+                uint                cornersBeg = (facetIdx == 0) ? 0 : chunk.facets[facetIdx-1].cornersEnd;
+                try {
+                    if (addFacet(chunk.corners.data()+cornersBeg,facet.cornersEnd-cornersBeg,
+                            numVerts+facet.numVerts,numUvs+facet.numUvs,inds,surf))
+                        ++numNgons;
+                }
+                catch(const FgException & e) {
+                    fgout << fgnl << "WARNING: Error in line " << lineBase+facet.line+1 << " of " << fname << ": "
+                        << e.tr_message() << fgpush << fgnl << objLine(facet.lineBeg,chunk.chars.end).str() << fgpop;
+                }
+            }
+        };
+        for (ObjEvent const & event : chunk.events) {
+            addFacets(event.numFacets);
+            size_t              ii = lineBase + event.line;
+            if (event.type == ObjEvent::Type::error)
+                fgout << fgnl << "WARNING: Error in line " << ii+1 << " of " << fname << ": " << event.msg
+                    << fgpush << fgnl << event.lineChars.str() << fgpop;
+            else if (event.type == ObjEvent::Type::badSeparator)
+                fgout << "WARNING: Invalid " << surfSeparator << " name on line " << ii << " of " << fname;
+            else if (currName != event.msg) {
+                addRun(currName,surf);
+                currName = event.msg;
+                surf = Surf();
+            }
+        }
+        addFacets(chunk.facets.size());
+        addRun(currName,surf);
+        lineBase += chunk.numLines;
+        numVerts += chunk.verts.size();
+        numUvs += chunk.uvs.size();
+        vertexHomog = vertexHomog || chunk.vertexHomog;
+        vertexColors = vertexColors || chunk.vertexColors;
+    }
+
+    // Some OBJ meshes make use of wrap aliasing in their UVs (eg. Daz Gen 3):
+    void
+    unwrapUvs(Vec2Fs & uvs)
+    {
+        bool                wrapped = false;
+        for (Vec2F & uv : uvs) {
+            for (uint xx=0; xx<2; ++xx) {
+                if ((uv[xx] < 0.0f) || (uv[xx] > 1.0f)) {
+                    wrapped = true;
+                    uv[xx] = uv[xx] - floor(uv[xx]);
+                }
+            }
+        }
+        if (wrapped && !uvsWrapped)
+            fgout << fgnl << "WARNING: UV indices unwrapped.";
+        uvsWrapped = uvsWrapped || wrapped;
+    }
+
+    // Warnings for the totals once all chunks are added:
+    void
+    finish() const
+    {
+        if (numNgons > 0)
+            fgout << fgnl << "WARNING: " << numNgons << " N-gons broken into tris in " << fname;
+        if (vertexHomog)
+            fgout << fgnl << "WARNING: Vertex homogeneous coordinates ignored.";
+        if (vertexColors)
+            fgout << fgnl << "WARNING: Vertex color values ignored.";
+    }
+};
+
+// The file is split into chunks of whole lines which are parsed concurrently. Facet indices are resolved
+// and surfaces assembled serially in file order, so the result is independent of 'chunkBytes':
+static
+Mesh
+parseWObj(
+    string const &      data,
+    Ustring const &     fname,
+    string const &      surfSeparator,
+    size_t              chunkBytes)
+{
+    size_t              numChunks = cMax(data.size() / chunkBytes,size_t(1));
+    Svec<ObjChunk>      chunks(numChunks);
+    char const *        dataEnd = data.data() + data.size();
+    char const *        beg = data.data();
+    for (size_t cc=0; cc<numChunks; ++cc) {
+        char const *        end = dataEnd;
+        if (cc+1 < numChunks) {
+            end = max(beg,data.data() + (cc+1) * (data.size() / numChunks));
+            end = objLine(end,dataEnd).end;         // Chunks end after a line break
+        }
+        chunks[cc].chars = ObjChars{beg,end};
+        beg = end;
+    }
+    if (numChunks == 1)
+        parseChunk(chunks[0],surfSeparator);
+    else
+        parallelFor(numChunks,[&](size_t cc){parseChunk(chunks[cc],surfSeparator); });
+    // Nothing after an invalid separator is used:
+    size_t              numUsed = 0;
+    while ((numUsed < numChunks) && !chunks[numUsed++].stopped)
+        ;
+    Mesh                mesh;
+    size_t              numVerts = 0,
+                        numUvs = 0;
+    for (size_t cc=0; cc<numUsed; ++cc) {
+        numVerts += chunks[cc].verts.size();
+        numUvs += chunks[cc].uvs.size();
+    }
+    mesh.verts.reserve(numVerts);
+    mesh.uvs.reserve(numUvs);
+    map<string,Surf>    surfs;
+    ObjAssembler        assembler {fname,surfSeparator};
+    for (size_t cc=0; cc<numUsed; ++cc) {
+        cat_(mesh.verts,chunks[cc].verts);
+        cat_(mesh.uvs,chunks[cc].uvs);
+        assembler.add(chunks[cc],[&](string const & name,Surf & surf){addSurf(surfs,name,surf); });
+    }
+    assembler.finish();
     mesh.name = pathToBase(fname);
     for (map<string,Surf>::iterator it = surfs.begin(); it != surfs.end(); ++it) {
         Surf &   srf = it->second;
-        if (!srf.tris.valid() || !srf.quads.valid()) {
-            srf.tris.uvInds.clear();
-            srf.quads.uvInds.clear();
-            fgout << fgnl << "WARNING: Partial UV indices ignored in " << fname << " surface " << it->first;
-        }
+        clearPartialUvs(srf,fname,it->first);
         srf.name = it->first;
         mesh.surfaces.push_back(srf);
     }
-    // Some OBJ meshes make use of wrap aliasing in their UVs (eg. Daz Gen 3):
-    bool        uvsWrapped = false;
-    for (size_t ii=0; ii<mesh.uvs.size(); ++ii) {
-        Vec2F &  uv = mesh.uvs[ii];
-        for (uint xx=0; xx<2; ++xx) {
-            if ((uv[xx] < 0.0f) || (uv[xx] > 1.0f)) {
-                uvsWrapped = true;
-                uv[xx] = uv[xx] - floor(uv[xx]);
+    assembler.unwrapUvs(mesh.uvs);
+    return mesh;
+}
+
+Mesh
+loadWObj(
+    Ustring const &     fname,
+    string              surfSeparator)
+{
+    // Chunks large enough that the per-chunk overhead is negligible, so small files are parsed serially:
+    return parseWObj(loadRawString(fname),fname,surfSeparator,size_t(1) << 22);
+}
+
+namespace {
+
+// Parses 'blockBytes' of whole lines at a time, queuing a block for the vertices, UVs and facets up
+// to the first separator then one for the facets following each separator:
+struct  ObjStreamReader : MeshReader
+{
+    Ustring             fname;
+    String              surfSeparator;
+    size_t              blockBytes;
+    Ifstream            ifs;
+    String              data;               // The partial line from the previous read then the next read
+    ObjAssembler        assembler;
+    bool                done;
+    map<String,uint>    surfInds;           // In order of first facet
+    Svec<MeshBlock>     queue;
+    size_t              queuePos;
+
+    ObjStreamReader(Ustring const & f,String const & s,size_t b) :
+        fname(f), surfSeparator(s), blockBytes(b), assembler(f,s)
+    {rewind(); }
+
+    void
+    rewind() override
+    {
+        ifs.close();
+        ifs.clear();
+        ifs.open(fname);
+        data.clear();
+        assembler = ObjAssembler(fname,surfSeparator);
+        done = false;
+        surfInds.clear();
+        queue.clear();
+        queuePos = 0;
+    }
+
+    uint
+    surface(String const & name)
+    {
+        auto                it = surfInds.find(name);
+        if (it == surfInds.end())
+            it = surfInds.insert(make_pair(name,uint(surfInds.size()))).first;
+        return it->second;
+    }
+
+    void
+    parseNext()
+    {
+        size_t              carry = data.size();
+        data.resize(carry + blockBytes);
+        ifs.read(&data[carry],blockBytes);
+        data.resize(carry + size_t(ifs.gcount()));
+        bool                eof = !ifs;
+        size_t              end = data.size();
+        if (!eof) {
+            size_t              nl = data.find_last_of("\n\r");
+            if (nl == String::npos)
+                return;                             // No complete line yet
+            end = nl + 1;
+        }
+        ObjChunk            chunk;
+        chunk.chars = ObjChars{data.data(),data.data()+end};
+        parseChunk(chunk,surfSeparator);
+        queue.clear();
+        queuePos = 0;
+        queue.push_back(MeshBlock());
+        queue.back().verts = chunk.verts;
+        queue.back().uvs = chunk.uvs;
+        assembler.unwrapUvs(queue.back().uvs);
+        bool                first = true;       // The first run goes in the block with the vertices and UVs
+        assembler.add(chunk,[&](string const & name,Surf & surf)
+        {
+            if (!first) {
+                if (surf.empty())
+                    return;
+                queue.push_back(MeshBlock());
             }
+            first = false;
+            MeshBlock &         block = queue.back();
+            clearPartialUvs(surf,fname,name);
+            block.surfName = name;
+            if (!surf.empty())
+                block.surfIdx = surface(name);
+            block.tris = surf.tris;
+            block.quads = surf.quads;
+        });
+        // Nothing after an invalid separator is used:
+        done = eof || chunk.stopped;
+        if (done)
+            assembler.finish();
+        data.erase(0,end);
+    }
+
+    bool
+    next(MeshBlock & block) override
+    {
+        while (queuePos == queue.size()) {
+            if (done)
+                return false;
+            parseNext();
         }
+        block = queue[queuePos++];
+        return true;
     }
-    if (uvsWrapped)
-        fgout << fgnl << "WARNING: UV indices unwrapped.";
-    return mesh;
+};
+
 }
 
+Sptr<MeshReader>
+objReader(Ustring const & fname,String const & surfSeparator,size_t blockBytes)
+{return make_shared<ObjStreamReader>(fname,surfSeparator,blockBytes); }
+
 struct  Offsets
 {
     uint    vert;
@@ -257,7 +754,7 @@ struct  Offsets
 template<uint dim>
 void
 writeFacets(
-    Ofstream &    ofs,
+    TextWriter &  ofs,
     const vector<Mat<uint,dim,1> > &  vertInds,
     const vector<Mat<uint,dim,1> > &  uvInds,
     Offsets         offsets)
@@ -303,7 +800,7 @@ writeMtlBase(
 static
 Offsets
 writeMesh(
-    Ofstream &          ofs,
+    TextWriter &        ofs,
     Ofstream &          ofsMtl,
     Mesh const &        mesh,
     Path const &        fpath,
@@ -365,7 +862,7 @@ saveWObj(
     for (size_t ii=0; ii<meshes.size(); ++ii)
         if (meshes[ii].numValidAlbedoMaps() > 0)
             texImage = true;
-    Ofstream        ofs(filename);
+    TextWriter      ofs(filename);
     Ofstream        ofsMtl;
     ofs.precision(7);
     ofs <<
@@ -390,6 +887,80 @@ saveWObj(
     }
 }
 
+namespace {
+
+// Positions are written with enough digits to be read back exactly:
+struct  ObjStreamWriter : MeshWriter
+{
+    TextWriter          ofs;
+    size_t              numVerts = 0,
+                        numUvs = 0;
+    uint                currSurf = numeric_limits<uint>::max();
+
+    explicit
+    ObjStreamWriter(Ustring const & fname) : ofs(fname)
+    {
+        ofs.precision(9);
+        ofs <<
+            "# Wavefront OBJ format.\n"
+            "# Generated by FaceGen, for more information visit https://facegen.com\n";
+    }
+
+    template<uint dim>
+    void
+    facets(FacetInds<dim> const & fis)
+    {
+        bool                uvs = !fis.uvInds.empty();
+        for (size_t ii=0; ii<fis.size(); ++ii) {
+            ofs << "f";
+            for (uint kk=0; kk<dim; ++kk) {
+                uint                vi = fis.posInds[ii][kk];
+                FGASSERT(vi < numVerts);
+                ofs << " " << vi+1;
+                if (uvs) {
+                    uint                ui = fis.uvInds[ii][kk];
+                    FGASSERT(ui < numUvs);
+                    ofs << "/" << ui+1;
+                }
+            }
+            ofs << "\n";
+        }
+    }
+
+    void
+    write(MeshBlock const & block) override
+    {
+        for (Vec3F v : block.verts)
+            ofs << "v " << v[0] << " " << v[1] << " " << v[2] << "\n";
+        for (Vec2F uv : block.uvs)
+            ofs << "vt " << uv[0] << " " << uv[1] << "\n";
+        numVerts += block.verts.size();
+        numUvs += block.uvs.size();
+        if (block.hasFacets() && (block.surfIdx != currSurf)) {
+            currSurf = block.surfIdx;
+            // Some OBJ parsers can't handle spaces in names:
+            Ustring             name = block.surfName.empty() ? Ustring("Surf")+toStr(currSurf) : block.surfName;
+            ofs << "g " << name.replace(' ','_') << "\n";
+        }
+        facets(block.tris);
+        facets(block.quads);
+    }
+
+    void
+    finish() override
+    {
+        ofs.close();
+        if (ofs.fail())
+            fgThrow("Error writing OBJ file");
+    }
+};
+
+}
+
+Sptr<MeshWriter>
+objWriter(Ustring const & fname)
+{return make_shared<ObjStreamWriter>(fname); }
+
 void
 fgSaveObjTest(CLArgs const & args)
 {
@@ -409,6 +980,295 @@ fgSaveObjTest(CLArgs const & args)
     regressFileRel("meshExportObj2.png","base/test/");
 }
 
+// A grid of quads with UVs split into groups by row, with some facets as tris, N-gons and with
+// negative (relative) indices. No normals are given so the facet format varies:
+static
+string
+synthObj(uint dim)
+{
+    ostringstream       oss;
+    oss.precision(7);
+    for (uint yy=0; yy<dim; ++yy) {
+        for (uint xx=0; xx<dim; ++xx) {
+            float           u = float(xx) / float(dim-1),
+                            v = float(yy) / float(dim-1);
+            oss << "v " << u*2.0f-1.0f << " " << v*3.0f << " " << u*v*0.1f << "\n"
+                << "vt " << u << " " << v << "\n";
+        }
+    }
+    for (uint yy=0; yy+1<dim; ++yy) {
+        oss << "g row" << yy%4 << "\n";
+        for (uint xx=0; xx+1<dim; ++xx) {
+            uint            v0 = yy*dim+xx+1,
+                            v1 = v0 + 1,
+                            v2 = v1 + dim,
+                            v3 = v0 + dim;
+            if (xx%7 == 3)
+                oss << "f " << v0 << "/" << v0 << " " << v1 << "/" << v1 << " " << v2 << "/" << v2 << "\n";
+            else if (xx%11 == 5)    // Degenerate pentagon
+                oss << "f " << v0 << "/" << v0 << " " << v1 << "/" << v1 << " " << v2 << "/" << v2 << " "
+                    << v2 << "/" << v2 << " " << v3 << "/" << v3 << "\n";
+            else if (xx%13 == 7) {
+                int             n0 = int(v0) - int(dim*dim) - 1,
+                                n3 = int(v3) - int(dim*dim) - 1;
+                oss << "f " << n0 << "/" << n0 << " " << n0+1 << "/" << n0+1 << " " << n3+1 << "/" << n3+1
+                    << " " << n3 << "/" << n3 << "\n";
+            }
+            else
+                oss << "f " << v0 << "/" << v0 << "/1 " << v1 << "/" << v1 << "/1 " << v2 << "/" << v2 << "/1 "
+                    << v3 << "/" << v3 << "/1\n";
+        }
+    }
+    return oss.str();
+}
+
+static
+void
+checkEqual(Mesh const & lhs,Mesh const & rhs)
+{
+    FGASSERT(lhs.verts == rhs.verts);
+    FGASSERT(lhs.uvs == rhs.uvs);
+    FGASSERT(lhs.surfaces.size() == rhs.surfaces.size());
+    for (size_t ss=0; ss<lhs.surfaces.size(); ++ss) {
+        Surf const &        l = lhs.surfaces[ss];
+        Surf const &        r = rhs.surfaces[ss];
+        FGASSERT(l.name == r.name);
+        FGASSERT((l.tris.posInds == r.tris.posInds) && (l.tris.uvInds == r.tris.uvInds));
+        FGASSERT((l.quads.posInds == r.quads.posInds) && (l.quads.uvInds == r.quads.uvInds));
+    }
+}
+
+void
+testLoadObj(CLArgs const &)
+{
+    string              obj =
+        "# Comment\r\n"
+        "v 0 0 0\r\n"
+        "v 1 0 0 1\r\n"
+        "\r\n"
+        "v 1 1 0\r\n"
+        "v 0 1 0\r\n"
+        "vn 0 0 1\r\n"
+        "vt 0 0\r\n"
+        "vt 1 0\r\n"
+        "vt 1 1\r\n"
+        "vt 1.5 -0.25\r\n"
+        "g b\r\n"
+        "f 1/1/1 2/2/1 3/3/1\r\n"
+        "f -4/-4 -3/-3 -2/-2 -1/-1\r\n"
+        "g a\r\n"
+        "f 1 2 3 4 1\r\n"
+        "f 1 2 9\r\n"                   // Invalid index
+        "v 0.5 0.5 1e60\r\n"            // Out of range value
+        "g b\r\n"
+        "f 1/1 3/3 5/4\r\n";
+    Mesh                mesh = parseWObj(obj,"test.obj","g",size_t(1) << 22);
+    FGASSERT(mesh.verts.size() == 5);
+    FGASSERT(mesh.verts[4] == Vec3F(0.5f,0.5f,numeric_limits<float>::max()));
+    FGASSERT(mesh.uvs.size() == 4);
+    FGASSERT(mesh.uvs[3] == Vec2F(0.5f,0.75f));             // Unwrapped
+    FGASSERT(mesh.surfaces.size() == 2);
+    Surf const &        sa = mesh.surfaces[0];
+    Surf const &        sb = mesh.surfaces[1];
+    FGASSERT((sa.name == "a") && (sb.name == "b"));
+    FGASSERT(sa.tris.posInds == Vec3UIs({{0,1,2},{0,2,3},{0,3,0}}));
+    FGASSERT(sa.tris.uvInds.empty() && sa.quads.empty());
+    FGASSERT(sb.tris.posInds == Vec3UIs({{0,1,2},{0,2,4}}));
+    FGASSERT(sb.tris.uvInds == Vec3UIs({{0,1,2},{0,2,3}}));
+    FGASSERT(sb.quads.posInds == Vec4UIs({{0,1,2,3}}));
+    FGASSERT(sb.quads.uvInds == Vec4UIs({{0,1,2,3}}));
+    // The fast float parsing must give exactly the same values as the C library:
+    mt19937             rng(42);
+    char                buf[32];
+    for (size_t ii=0; ii<100000; ++ii) {
+        uint            digits = rng() % (1 << 25);
+        int             point = int(rng() % 12),
+                        exp = int(rng() % 9) - 4;
+        String          num = toStr(digits);
+        if (point < int(num.size()))
+            num.insert(num.size()-point,".");
+        if (ii % 2)
+            num = "-" + num;
+        if (ii % 3)
+            num += "e" + toStr(exp);
+        float           fast;
+        if (parseFloatFast(ObjChars{num.data(),num.data()+num.size()},fast)) {
+            strcpy(buf,num.c_str());
+            float           ref = strtof(buf,nullptr);
+            FGASSERT(memcmp(&fast,&ref,sizeof(float)) == 0);
+        }
+    }
+    // The result must not depend on how the file is split into concurrently parsed chunks:
+    string              grid = synthObj(97);
+    Mesh                whole = parseWObj(grid,"grid.obj","g",grid.size());
+    FGASSERT(whole.verts.size() == 97*97);
+    FGASSERT(whole.surfaces.size() == 4);
+    for (size_t chunkBytes : {size_t(64),size_t(4096),grid.size()/3})
+        checkEqual(parseWObj(grid,"grid.obj","g",chunkBytes),whole);
+    // And it must be the same as saving and re-loading the mesh:
+    TestDir             td("objLoad");
+    saveRaw(grid,"grid.obj");
+    checkEqual(loadWObj("grid.obj","g"),whole);
+}
+
+// The original line-at-a-time loader, kept only to compare performance against in 'testmLoadObj':
+namespace objOrig {
+
+float
+parseFloat(string const & str)
+{
+    istringstream   iss(str);
+    float           ret;
+    iss >> ret;
+    return ret;
+}
+
+Vec3F
+parseVert(string const & str,bool & homogeneous,bool & vertColors)
+{
+    Strings         nums = splitChar(str,' ');
+    if (nums.size() < 3)
+        fgThrow("Too few values specifying vertex");
+    else if (nums.size() == 4)
+        homogeneous = true;
+    else if (nums.size() == 6)
+        vertColors = true;
+    else if (nums.size() != 3)
+        fgThrow("Invalid number of arguments for vertex");
+    Vec3F           ret;
+    for (uint ii=0; ii<3; ++ii)
+        ret[ii] = parseFloat(nums[ii]);
+    return ret;
+}
+
+Vec2F
+parseUv(string const & str)
+{
+    Strings         nums = splitChar(str,' ');
+    FGASSERT((nums.size() > 1) && (nums.size() < 4));
+    Vec2F           ret;
+    for (uint ii=0; ii<2; ++ii)
+        ret[ii] = parseFloat(nums[ii]);
+    return ret;
+}
+
+bool
+parseFacet(string const & str,size_t numVerts,size_t numUvs,FacetInds<3> & tris,FacetInds<4> & quads)
+{
+    bool            ret = false;
+    Strings         strs = splitChar(str,' ');
+    FGASSERT(strs.size() > 2);
+    vector<Uints>   nums;
+    for (size_t ii=0; ii<strs.size(); ++ii) {
+        Strings         ns = splitChar(strs[ii],'/',true);
+        size_t          sz = cMin(ns.size(),size_t(2));
+        Uints           nms;
+        for (size_t jj=0; jj<sz; ++jj) {
+            size_t          numLim = ((jj == 0) ? numVerts : numUvs);
+            if (!ns[jj].empty()) {
+                istringstream   iss(ns[jj]);
+                int             num;
+                iss >> num;
+                --num;
+                FGASSERT(num < int(numLim));
+                if (num < 0) {
+                    FGASSERT(size_t(-num) <= numLim);
+                    nms.push_back(uint(int(numLim)+num));
+                }
+                else
+                    nms.push_back(uint(num));
+            }
+        }
+        nums.push_back(nms);
+    }
+    for (size_t ii=1; ii<nums.size(); ++ii)
+        FGASSERT(nums[ii].size() == nums[ii-1].size());
+    if (nums.size() == 3) {
+        tris.posInds.push_back(Vec3UI(nums[0][0],nums[1][0],nums[2][0]));
+        if (nums[0].size() > 1)
+            tris.uvInds.push_back(Vec3UI(nums[0][1],nums[1][1],nums[2][1]));
+    }
+    if (nums.size() == 4) {
+        quads.posInds.push_back(Vec4UI(nums[0][0],nums[1][0],nums[2][0],nums[3][0]));
+        if (nums[0].size() > 1)
+            quads.uvInds.push_back(Vec4UI(nums[0][1],nums[1][1],nums[2][1],nums[3][1]));
+    }
+    if (nums.size() > 4) {
+        for (size_t ii=0; ii<nums.size()-2; ++ii) {
+            tris.posInds.push_back(Vec3UI(nums[0][0],nums[ii+1][0],nums[ii+2][0]));
+            if (nums[ii].size() > 1)
+                tris.uvInds.push_back(Vec3UI(nums[0][1],nums[ii+1][1],nums[ii+2][1]));
+        }
+        ret = true;
+    }
+    return ret;
+}
+
+// As the original without the warnings and surface separation, which don't affect the timing:
+Mesh
+loadWObj(Ustring const & fname)
+{
+    Mesh                mesh;
+    Strings             lines = splitLines(loadRawString(fname));
+    Surf                surf;
+    bool                vertexColors = false,
+                        vertexHomog = false;
+    for (size_t ii=0; ii<lines.size(); ++ii) {
+        try {
+            string const &  line = lines[ii];
+            if (line[0] == 'v') {
+                if (line.at(1) == ' ')
+                    mesh.verts.push_back(parseVert(line.substr(2),vertexHomog,vertexColors));
+                if (line.at(1) == 't')
+                    if (line.at(2) == ' ')
+                        mesh.uvs.push_back(parseUv(line.substr(3)));
+            }
+            if (line[0] == 'f') {
+                if (line.at(1) == ' ')
+                    parseFacet(line.substr(2),mesh.verts.size(),mesh.uvs.size(),surf.tris,surf.quads);
+            }
+        }
+        catch(const FgException &) {}
+    }
+    mesh.surfaces.push_back(surf);
+    return mesh;
+}
+
+}
+
+void
+testmLoadObj(CLArgs const & args)
+{
+    Uints               dims {256,1024,1448};
+    if (args.size() > 1) {
+        Syntax              syn(args,"<dim>+\n"
+            "    <dim> - grid vertices along each side of a synthetic mesh (default 256 1024 1448)");
+        dims.clear();
+        while (syn.more())
+            dims.push_back(syn.nextAs<uint>());
+    }
+    FGTESTDIR
+    fgout << fgnl << "verts,MB,origMs,serialMs,loadMs,MB/s";
+    for (uint dim : dims) {
+        string              obj = synthObj(dim);
+        saveRaw(obj,"synth.obj",false);
+        double              mb = double(obj.size()) / double(1 << 20);
+        Timer               timer;
+        Mesh                orig = objOrig::loadWObj("synth.obj");
+        uint64              origMs = timer.readMs();
+        timer.start();
+        Mesh                serial = parseWObj(obj,"synth.obj",String(),obj.size());
+        uint64              serialMs = timer.readMs();
+        timer.start();
+        Mesh                mesh = loadWObj("synth.obj");
+        uint64              loadMs = timer.readMs();
+        checkEqual(mesh,serial);
+        FGASSERT(orig.verts == mesh.verts);
+        fgout << fgnl << mesh.verts.size() << "," << mb << "," << origMs << "," << serialMs << "," << loadMs << ","
+            << mb * 1000.0 / double(cMax(loadMs,uint64(1)));
+    }
+}
+
 }
 
 // */
@@ -11,8 +11,13 @@
 #include "Fg3dNormals.hpp"
 #include "FgStdStream.hpp"
 #include "FgFileSystem.hpp"
+#include "FgParse.hpp"
 #include "FgCommand.hpp"
 #include "FgTestUtils.hpp"
+#include "FgTextWriter.hpp"
+#include "FgApproxEqual.hpp"
+#include "FgSyntax.hpp"
+#include "FgTime.hpp"
 
 using namespace std;
 
@@ -27,7 +32,7 @@ savePly(
     Mesh    mesh = mergeMeshes(meshes);
     Path      path(fname);
     path.ext = "ply";
-    Ofstream  ofs(path.str());
+    TextWriter  ofs(path.str());
     ofs <<
         "ply\n"
         "format ascii 1.0\n"
@@ -81,6 +86,321 @@ savePly(
     }
 }
 
+namespace {
+
+enum struct PlyType {int8,uint8,int16,uint16,int32,uint32,float32,float64};
+
+PlyType
+plyType(String const & name)
+{
+    static map<String,PlyType>  types = {
+        {"char",PlyType::int8},{"int8",PlyType::int8},{"uchar",PlyType::uint8},{"uint8",PlyType::uint8},
+        {"short",PlyType::int16},{"int16",PlyType::int16},{"ushort",PlyType::uint16},{"uint16",PlyType::uint16},
+        {"int",PlyType::int32},{"int32",PlyType::int32},{"uint",PlyType::uint32},{"uint32",PlyType::uint32},
+        {"float",PlyType::float32},{"float32",PlyType::float32},{"double",PlyType::float64},{"float64",PlyType::float64},
+    };
+    auto                it = types.find(name);
+    if (it == types.end())
+        fgThrow("Unknown PLY property type",name);
+    return it->second;
+}
+
+size_t
+plySize(PlyType type)
+{
+    static size_t const sizes[] = {1,1,2,2,4,4,4,8};
+    return sizes[uint(type)];
+}
+
+struct  PlyProperty
+{
+    String              name;
+    PlyType             type;
+    bool                isList;
+    PlyType             countType;          // Only used if 'isList'
+};
+
+struct  PlyElement
+{
+    String              name;
+    size_t              count;
+    Svec<PlyProperty>   props;
+
+    // Returns the index of the first property with any of the given names, or props.size() if none:
+    size_t
+    findProp(Strings const & names) const
+    {
+        for (size_t ii=0; ii<props.size(); ++ii)
+            if (contains(names,props[ii].name))
+                return ii;
+        return props.size();
+    }
+};
+
+enum struct PlyFormat {ascii,binaryLe,binaryBe};
+
+// Reads values from the body of the file, throwing if it ends early:
+struct  PlyBody
+{
+    char const *        pos;
+    char const *        end;                // If ASCII, must be null terminated here
+    PlyFormat           format;
+
+    template<class T>
+    double
+    readBinary()
+    {
+        if (sizeof(T) > size_t(end - pos))
+            fgThrow("PLY file is truncated");
+        T                   val;
+        if (format == PlyFormat::binaryBe)
+            reverse_copy(pos,pos+sizeof(T),reinterpret_cast<char *>(&val));
+        else
+            memcpy(&val,pos,sizeof(T));
+        pos += sizeof(T);
+        return double(val);
+    }
+
+    double
+    readAscii()
+    {
+        while ((pos < end) && isspace(uchar(*pos)))
+            ++pos;
+        if (pos == end)
+            fgThrow("PLY file is truncated");
+        char *              after;
+        double              ret = strtod(pos,&after);
+        if (after == pos)
+            fgThrow("Invalid PLY ASCII value",String(pos,min(size_t(end-pos),size_t(16))));
+        pos = after;
+        return ret;
+    }
+
+    double
+    read(PlyType type)
+    {
+        switch (type) {
+        case PlyType::int8:     return (format == PlyFormat::ascii) ? readAscii() : readBinary<int8>();
+        case PlyType::uint8:    return (format == PlyFormat::ascii) ? readAscii() : readBinary<uchar>();
+        case PlyType::int16:    return (format == PlyFormat::ascii) ? readAscii() : readBinary<int16>();
+        case PlyType::uint16:   return (format == PlyFormat::ascii) ? readAscii() : readBinary<uint16>();
+        case PlyType::int32:    return (format == PlyFormat::ascii) ? readAscii() : readBinary<int32>();
+        case PlyType::uint32:   return (format == PlyFormat::ascii) ? readAscii() : readBinary<uint32>();
+        case PlyType::float32:  return (format == PlyFormat::ascii) ? readAscii() : readBinary<float>();
+        case PlyType::float64:  return (format == PlyFormat::ascii) ? readAscii() : readBinary<double>();
+        }
+        return 0;
+    }
+
+    size_t
+    readCount(PlyType type)
+    {
+        double              val = read(type);
+        if ((val < 0) || (val != std::floor(val)))
+            fgThrow("Invalid PLY list count",toStr(val));
+        return size_t(val);
+    }
+
+    // Checked before allocating for the elements so that a bad header count can't cause an
+    // unbounded allocation. ASCII values take at least one character each:
+    void
+    checkCount(PlyElement const & elem) const
+    {
+        size_t              minBytes = 0;
+        for (PlyProperty const & prop : elem.props)
+            minBytes += (format == PlyFormat::ascii) ? 1 : plySize(prop.isList ? prop.countType : prop.type);
+        if ((minBytes > 0) && (elem.count > size_t(end - pos) / minBytes))
+            fgThrow("PLY file is truncated",elem.name);
+    }
+
+    void
+    skip(PlyProperty const & prop)
+    {
+        size_t              num = prop.isList ? readCount(prop.countType) : 1;
+        if (format == PlyFormat::ascii) {
+            for (size_t ii=0; ii<num; ++ii)
+                readAscii();
+        }
+        else {
+            size_t              size = num * plySize(prop.type);
+            if (size > size_t(end - pos))
+                fgThrow("PLY file is truncated");
+            pos += size;
+        }
+    }
+};
+
+}
+
+Mesh
+loadPly(Ustring const & fname)
+{
+    MappedFile          file(fname);
+    char const *        data = reinterpret_cast<char const *>(file.data());
+    char const *        dataEnd = data + file.size();
+    // Header:
+    auto                nextLine = [&](char const * & pos) -> String
+    {
+        char const *        eol = find(pos,dataEnd,'\n');
+        if (eol == dataEnd)
+            fgThrow("PLY header is not terminated",fname);
+        String              ret(pos,eol);
+        if (!ret.empty() && (ret.back() == '\r'))
+            ret.pop_back();
+        pos = eol + 1;
+        return ret;
+    };
+    char const *        pos = data;
+    if ((file.size() < 4) || (nextLine(pos) != "ply"))
+        fgThrow("Not a PLY file",fname);
+    PlyFormat           format = PlyFormat::ascii;
+    Svec<PlyElement>    elems;
+    for (;;) {
+        Strings             toks = splitWhitespace(nextLine(pos));
+        if (toks.empty() || (toks[0] == "comment") || (toks[0] == "obj_info"))
+            continue;
+        if (toks[0] == "end_header")
+            break;
+        if ((toks[0] == "format") && (toks.size() == 3)) {
+            if (toks[1] == "ascii")
+                format = PlyFormat::ascii;
+            else if (toks[1] == "binary_little_endian")
+                format = PlyFormat::binaryLe;
+            else if (toks[1] == "binary_big_endian")
+                format = PlyFormat::binaryBe;
+            else
+                fgThrow("Unknown PLY format",toks[1]);
+        }
+        else if ((toks[0] == "element") && (toks.size() == 3))
+            elems.push_back(PlyElement {toks[1],fromStrThrow<size_t>(toks[2]),{}});
+        else if ((toks[0] == "property") && !elems.empty()) {
+            if ((toks.size() == 5) && (toks[1] == "list"))
+                elems.back().props.push_back(PlyProperty {toks[4],plyType(toks[3]),true,plyType(toks[2])});
+            else if (toks.size() == 3)
+                elems.back().props.push_back(PlyProperty {toks[2],plyType(toks[1]),false,PlyType::uint8});
+            else
+                fgThrow("Invalid PLY property",fname);
+        }
+        else
+            fgThrow("Invalid PLY header line",cat(toks," "));
+    }
+    // strtod requires null termination:
+    String              ascii;
+    PlyBody             body {pos,dataEnd,format};
+    if (format == PlyFormat::ascii) {
+        ascii.assign(pos,dataEnd);
+        body.pos = ascii.c_str();
+        body.end = body.pos + ascii.size();
+    }
+    size_t              numVerts = 0;
+    for (PlyElement const & elem : elems)
+        if (elem.name == "vertex")
+            numVerts = elem.count;
+    Mesh                mesh;
+    mesh.name = pathToBase(fname);
+    Surf                surf;
+    bool                perVertUvs = false;
+    for (PlyElement const & elem : elems) {
+        size_t              numProps = elem.props.size();
+        body.checkCount(elem);
+        if (elem.name == "vertex") {
+            size_t              ix = elem.findProp({"x"}),
+                                iy = elem.findProp({"y"}),
+                                iz = elem.findProp({"z"}),
+                                iu = elem.findProp({"u","s","texture_u"}),
+                                iv = elem.findProp({"v","t","texture_v"});
+            if ((ix == numProps) || (iy == numProps) || (iz == numProps))
+                fgThrow("PLY vertex element does not have x,y,z properties",fname);
+            perVertUvs = ((iu < numProps) && (iv < numProps));
+            mesh.verts.resize(elem.count);
+            if (perVertUvs)
+                mesh.uvs.resize(elem.count);
+            for (size_t ee=0; ee<elem.count; ++ee) {
+                for (size_t pp=0; pp<numProps; ++pp) {
+                    PlyProperty const & prop = elem.props[pp];
+                    if (prop.isList)
+                        body.skip(prop);
+                    else if (pp == ix)
+                        mesh.verts[ee][0] = float(body.read(prop.type));
+                    else if (pp == iy)
+                        mesh.verts[ee][1] = float(body.read(prop.type));
+                    else if (pp == iz)
+                        mesh.verts[ee][2] = float(body.read(prop.type));
+                    else if (perVertUvs && (pp == iu))
+                        mesh.uvs[ee][0] = float(body.read(prop.type));
+                    else if (perVertUvs && (pp == iv))
+                        mesh.uvs[ee][1] = float(body.read(prop.type));
+                    else
+                        body.skip(prop);
+                }
+            }
+        }
+        else if (elem.name == "face") {
+            size_t              ii = elem.findProp({"vertex_indices","vertex_index"}),
+                                it = elem.findProp({"texcoord"});
+            if ((ii == numProps) || !elem.props[ii].isList)
+                fgThrow("PLY face element does not have a vertex index list",fname);
+            bool                facetUvs = ((it < numProps) && elem.props[it].isList);
+            Uints               poly,
+                                polyUvs;
+            surf.tris.posInds.reserve(elem.count);
+            for (size_t ee=0; ee<elem.count; ++ee) {
+                poly.clear();
+                polyUvs.clear();
+                for (size_t pp=0; pp<numProps; ++pp) {
+                    PlyProperty const & prop = elem.props[pp];
+                    if (pp == ii) {
+                        size_t              num = body.readCount(prop.countType);
+                        for (size_t vv=0; vv<num; ++vv) {
+                            double              idx = body.read(prop.type);
+                            if (!(idx >= 0) || (idx >= double(numVerts)))
+                                fgThrow("PLY vertex index out of range",toStr(idx));
+                            poly.push_back(uint(idx));
+                        }
+                    }
+                    else if (facetUvs && (pp == it)) {
+                        size_t              num = body.readCount(prop.countType);
+                        for (size_t vv=0; vv+1<num; vv+=2) {
+                            polyUvs.push_back(uint(mesh.uvs.size()));
+                            float               u = float(body.read(prop.type));
+                            mesh.uvs.push_back(Vec2F(u,float(body.read(prop.type))));
+                        }
+                        if (num % 2 == 1)
+                            body.read(prop.type);
+                    }
+                    else
+                        body.skip(prop);
+                }
+                if (poly.size() < 3)
+                    continue;                       // Degenerate
+                if (facetUvs && (polyUvs.size() != poly.size()))
+                    fgThrow("PLY face texcoord count does not match its vertex count",fname);
+                Uints const &       uvInds = facetUvs ? polyUvs : poly;
+                bool                hasUvs = facetUvs || perVertUvs;
+                if (poly.size() == 4) {
+                    surf.quads.posInds.push_back(Vec4UI(poly[0],poly[1],poly[2],poly[3]));
+                    if (hasUvs)
+                        surf.quads.uvInds.push_back(Vec4UI(uvInds[0],uvInds[1],uvInds[2],uvInds[3]));
+                }
+                else {
+                    for (size_t vv=2; vv<poly.size(); ++vv) {
+                        surf.tris.posInds.push_back(Vec3UI(poly[0],poly[vv-1],poly[vv]));
+                        if (hasUvs)
+                            surf.tris.uvInds.push_back(Vec3UI(uvInds[0],uvInds[vv-1],uvInds[vv]));
+                    }
+                }
+            }
+        }
+        else {
+            for (size_t ee=0; ee<elem.count; ++ee)
+                for (PlyProperty const & prop : elem.props)
+                    body.skip(prop);
+        }
+    }
+    mesh.surfaces.push_back(surf);
+    return mesh;
+}
+
 void
 fgSavePlyTest(CLArgs const & args)
 {
@@ -97,6 +417,152 @@ fgSavePlyTest(CLArgs const & args)
     regressFileRel("meshExportPly1.png","base/test/");
 }
 
+namespace {
+
+template<class T>
+void
+putPly(String & data,bool bigEndian,T val)
+{
+    char                bytes[sizeof(T)];
+    memcpy(bytes,&val,sizeof(T));
+    if (bigEndian)
+        reverse(bytes,bytes+sizeof(T));
+    data.append(bytes,sizeof(T));
+}
+
+}
+
+void
+testPlyLoad(CLArgs const & args)
+{
+    FGTESTDIR
+    // Binary files with property types, polygons and elements that must be converted or skipped:
+    Vec3Fs              verts {{0,0,0},{1,0,0},{1,1,0},{0,1,0},{2,0,0},{2,1,1}};
+    Svec<Uints>         polys {{0,1,2},{0,1,2,3},{1,4,5,2,3},{0,1}};
+    for (bool bigEndian : {false,true}) {
+        String              data = String("ply\r\nformat ") +
+            (bigEndian ? "binary_big_endian" : "binary_little_endian") + " 1.0\r\n"
+            "comment test\r\n"
+            "element vertex 6\r\n"
+            "property float x\r\nproperty uchar red\r\nproperty float y\r\nproperty double z\r\n"
+            "element face 4\r\n"
+            "property list uchar int vertex_indices\r\nproperty list ushort float texcoord\r\n"
+            "property short flags\r\n"
+            "element edge 1\r\n"
+            "property int vertex1\r\nproperty int vertex2\r\n"
+            "end_header\r\n";
+        for (Vec3F v : verts) {
+            putPly(data,bigEndian,v[0]);
+            putPly(data,bigEndian,uchar(255));
+            putPly(data,bigEndian,v[1]);
+            putPly(data,bigEndian,double(v[2]));
+        }
+        for (Uints const & poly : polys) {
+            putPly(data,bigEndian,uchar(poly.size()));
+            for (uint idx : poly)
+                putPly(data,bigEndian,int32(idx));
+            putPly(data,bigEndian,uint16(poly.size()*2));
+            for (uint idx : poly) {
+                putPly(data,bigEndian,verts[idx][0]);
+                putPly(data,bigEndian,verts[idx][1]);
+            }
+            putPly(data,bigEndian,int16(-1));
+        }
+        putPly(data,bigEndian,int32(0));
+        putPly(data,bigEndian,int32(5));
+        saveRaw(data,"binary.ply",false);
+        Mesh                mesh = loadPly("binary.ply");
+        FGASSERT(mesh.verts == verts);
+        FGASSERT(mesh.surfaces.size() == 1);
+        Surf const &        surf = mesh.surfaces[0];
+        FGASSERT(surf.tris.posInds == Vec3UIs({{0,1,2},{1,4,5},{1,5,2},{1,2,3}}));
+        FGASSERT(surf.quads.posInds == Vec4UIs({{0,1,2,3}}));
+        FGASSERT(mesh.uvs.size() == 14);           // Degenerate facet UVs are still read
+        auto                uvMatches = [&](uint uvIdx,uint posIdx)
+        {
+            Vec2F               uv = mesh.uvs[uvIdx];
+            return ((uv[0] == verts[posIdx][0]) && (uv[1] == verts[posIdx][1]));
+        };
+        for (size_t ii=0; ii<surf.tris.size(); ++ii)
+            for (uint vv=0; vv<3; ++vv)
+                FGASSERT(uvMatches(surf.tris.uvInds[ii][vv],surf.tris.posInds[ii][vv]));
+        for (uint vv=0; vv<4; ++vv)
+            FGASSERT(uvMatches(surf.quads.uvInds[0][vv],surf.quads.posInds[0][vv]));
+        // Truncation is detected, including element counts too large for the file before allocation:
+        String              badCount = data;
+        badCount.replace(badCount.find("vertex 6"),8,"vertex 4000000000000");
+        for (String const & bad : {data.substr(0,data.size()-3),badCount}) {
+            saveRaw(bad,"binary.ply",false);
+            bool                threw = false;
+            try {loadPly("binary.ply"); }
+            catch (FgException const &) {threw = true; }
+            FGASSERT(threw);
+        }
+    }
+    // ASCII from our own exporter, which writes 6 significant digits:
+    Ustring             dd = dataDir() + "base/";
+    Mesh                merged = mergeMeshes(svec(loadTri(dd+"Mouth.tri"),loadTri(dd+"Glasses.tri")));
+    Mesh                ascii = loadPly(dd+"test/meshExportPly.ply");
+    FGASSERT(isApproxEqual(ascii.verts,merged.verts,cMaxElem(cDims(merged.verts))*1.0e-5));
+    Vec3UIs             tris;
+    for (Surf const & surf : merged.surfaces)
+        cat_(tris,surf.getTriEquivs().posInds);
+    FGASSERT(ascii.surfaces[0].tris.posInds == tris);
+    FGASSERT(ascii.surfaces[0].tris.uvInds.size() == tris.size());
+    // Loading by extension:
+    FGASSERT(loadMesh(dd+"test/meshExportPly").verts == ascii.verts);
+}
+
+
+void
+testmLoadPlyStl(CLArgs const & args)
+{
+    uint                dim = 1024;
+    if (args.size() > 1) {
+        Syntax              syn(args,"[<dim>]\n"
+            "    <dim> - grid vertices along each side of a synthetic mesh (default 1024)");
+        dim = syn.nextAs<uint>();
+    }
+    FGTESTDIR
+    Mesh                grid;
+    for (uint yy=0; yy<dim; ++yy)
+        for (uint xx=0; xx<dim; ++xx)
+            grid.verts.push_back(Vec3F(float(xx),float(yy),float((xx*yy)%7)));
+    Vec3UIs             tris;
+    for (uint yy=0; yy+1<dim; ++yy) {
+        for (uint xx=0; xx+1<dim; ++xx) {
+            uint                idx = yy*dim + xx;
+            tris.push_back(Vec3UI(idx,idx+1,idx+dim+1));
+            tris.push_back(Vec3UI(idx,idx+dim+1,idx+dim));
+        }
+    }
+    grid.surfaces.push_back(Surf(tris));
+    String              data = "ply\nformat binary_little_endian 1.0\nelement vertex " + toStr(grid.verts.size()) +
+        "\nproperty float x\nproperty float y\nproperty float z\nelement face " + toStr(tris.size()) +
+        "\nproperty list uchar int vertex_indices\nend_header\n";
+    for (Vec3F v : grid.verts)
+        for (uint dd=0; dd<3; ++dd)
+            putPly(data,false,v[dd]);
+    for (Vec3UI t : tris) {
+        putPly(data,false,uchar(3));
+        for (uint vv=0; vv<3; ++vv)
+            putPly(data,false,int32(t[vv]));
+    }
+    saveRaw(data,"synth.ply",false);
+    savePly("synthAscii",{grid});
+    saveStl("synth.stl",{grid});
+    fgout << fgnl << tris.size() << " tris" << fgnl << "format,MB,ms,MB/s";
+    for (String fname : {"synth.ply","synthAscii.ply","synth.stl"}) {
+        Timer               timer;
+        Mesh                mesh = loadMesh(fname);
+        uint64              ms = timer.readMs();
+        FGASSERT(mesh.verts.size() == grid.verts.size());
+        FGASSERT(mesh.surfaces[0].numTriEquivs() == tris.size());
+        double              mb = double(getFileSize(fname)) / double(1 << 20);
+        fgout << fgnl << fname << "," << mb << "," << ms << "," << mb * 1000.0 / double(cMax(ms,uint64(1)));
+    }
+}
+
 }
 
 // */
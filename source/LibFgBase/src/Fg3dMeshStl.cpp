@@ -9,6 +9,9 @@
 #include "FgFileSystem.hpp"
 #include "FgException.hpp"
 #include "Fg3dNormals.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include <unordered_map>
 
 using namespace std;
 
@@ -71,4 +74,98 @@ saveStl(Ustring const & fname,Meshes const & meshes)
         saveStl(ff,meshes[ii]);
 }
 
+Mesh
+loadStl(Ustring const & fname)
+{
+    MappedFile          file(fname);
+    uchar const *       data = file.data();
+    size_t              size = file.size();
+    if (size < 84)
+        fgThrow("STL file is too small",fname);
+    uint32              numTris;
+    memcpy(&numTris,data+80,4);
+    if (size < 84 + size_t(numTris)*50) {
+        // The header of a binary STL can legally begin with 'solid' so this is only checked on failure:
+        if (memcmp(data,"solid",5) == 0)
+            fgThrow("ASCII STL files are not supported",fname);
+        fgThrow("STL file is truncated",fname);
+    }
+    Mesh                mesh;
+    mesh.name = pathToBase(fname);
+    Vec3UIs             tris;
+    tris.reserve(numTris);
+    // STL stores each facet's corners separately so shared vertices are recovered by welding exactly
+    // equal positions:
+    unordered_map<Vec3UI,uint,PosBitsHash>  vertInds;
+    vertInds.reserve(size_t(numTris)/2 + 1);
+    uchar const *       rec = data + 84;
+    for (uint32 tt=0; tt<numTris; ++tt,rec+=50) {
+        Vec3UI              tri;
+        for (uint vv=0; vv<3; ++vv) {
+            Vec3F               pos;
+            memcpy(&pos[0],rec+12+12*vv,12);
+            Vec3UI              bits = cPosBits(pos);       // Welds -0 with +0
+            auto                it = vertInds.emplace(bits,uint(mesh.verts.size()));
+            if (it.second) {
+                memcpy(&pos[0],&bits[0],12);
+                mesh.verts.push_back(pos);
+            }
+            tri[vv] = it.first->second;
+        }
+        if ((tri[0] != tri[1]) && (tri[1] != tri[2]) && (tri[2] != tri[0]))
+            tris.push_back(tri);
+    }
+    mesh.surfaces.push_back(Surf(tris));
+    return mesh;
+}
+
+void
+testStlLoad(CLArgs const & args)
+{
+    FGTESTDIR
+    Mesh                jane = loadTri(dataDir()+"base/Jane.tri");
+    saveStl("jane.stl",{jane});
+    Mesh                mesh = loadMesh("jane.stl");
+    // Corner positions must match in the order written, with quads split into two tris:
+    Surf const &        orig = jane.surfaces[0];
+    Vec3Fs              corners;
+    for (Vec3UI tri : orig.tris.posInds)
+        for (uint vv=0; vv<3; ++vv)
+            corners.push_back(jane.verts[tri[vv]]);
+    for (Vec4UI quad : orig.quads.posInds)
+        for (uint vv : {0,1,2,2,3,0})
+            corners.push_back(jane.verts[quad[vv]]);
+    FGASSERT(mesh.surfaces.size() == 1);
+    Vec3UIs const &     tris = mesh.surfaces[0].tris.posInds;
+    FGASSERT(tris.size()*3 == corners.size());
+    for (size_t ii=0; ii<tris.size(); ++ii)
+        for (uint vv=0; vv<3; ++vv)
+            FGASSERT(mesh.verts[tris[ii][vv]] == corners[ii*3+vv]);
+    // Welding recovers the shared vertices:
+    FGASSERT(mesh.verts.size() <= jane.verts.size());
+    // Facets made degenerate by welding are removed:
+    Mesh                degen;
+    degen.verts = {{0,0,0},{1,0,0},{1,0,0},{0,1,0}};
+    degen.surfaces.push_back(Surf(Vec3UIs{{0,1,3},{0,1,2}}));
+    saveStl("degen.stl",{degen});
+    Mesh                welded = loadStl("degen.stl");
+    FGASSERT(welded.verts.size() == 3);
+    FGASSERT(welded.surfaces[0].tris.posInds == Vec3UIs(1,Vec3UI(0,1,2)));
+    // -0 is welded with +0. The sign is set on the bits since -ffast-math may ignore it otherwise:
+    Mesh                zeros;
+    zeros.verts = {{0,0,0},{1,0,0},{0,1,0},{0,0,0},{1,-1,0}};
+    uint32 const        negZero = 0x80000000U;
+    for (uint dd=0; dd<3; ++dd)
+        memcpy(&zeros.verts[3][dd],&negZero,4);
+    zeros.surfaces.push_back(Surf(Vec3UIs{{0,1,2},{3,4,1}}));
+    saveStl("zeros.stl",{zeros});
+    String              zerosData = loadRawString("zeros.stl");
+    FGASSERT(memcmp(&zerosData[84+50+12],&negZero,4) == 0);
+    Mesh                zerosWelded = loadStl("zeros.stl");
+    FGASSERT(zerosWelded.verts.size() == 4);
+    FGASSERT(zerosWelded.surfaces[0].tris.posInds[1][0] == 0);
 }
+
+}
+
+// */
@@ -0,0 +1,688 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+#include "Fg3dMeshStream.hpp"
+#include "Fg3dMeshIo.hpp"
+#include "Fg3dMeshOps.hpp"
+#include "FgFileSystem.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
+#include <unordered_map>
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+// Vertices, then UVs, then the facets of each surface in order, 'blockElems' at a time:
+struct  MeshStreamReader : MeshReader
+{
+    Mesh const &        mesh;
+    size_t              blockElems;
+    size_t              stage,          // 0: verts, 1: uvs, then 2 per surface for tris and quads
+                        elemIdx;
+
+    MeshStreamReader(Mesh const & m,size_t b) : mesh(m), blockElems(b), stage(0), elemIdx(0)
+    {FGASSERT(blockElems > 0); }
+
+    void
+    rewind() override
+    {stage = elemIdx = 0; }
+
+    template<class T>
+    Svec<T>
+    slice(Svec<T> const & arr)
+    {
+        size_t              beg = std::min(elemIdx,arr.size()),
+                            end = std::min(beg+blockElems,arr.size());
+        return Svec<T>(arr.begin()+beg,arr.begin()+end);
+    }
+
+    template<uint dim>
+    FacetInds<dim>
+    slice(FacetInds<dim> const & fis)
+    {
+        FacetInds<dim>      ret;
+        ret.posInds = slice(fis.posInds);
+        if (fis.hasUvs())
+            ret.uvInds = slice(fis.uvInds);
+        return ret;
+    }
+
+    bool
+    next(MeshBlock & block) override
+    {
+        block = MeshBlock();
+        for (; stage<2+2*mesh.surfaces.size(); ++stage,elemIdx=0) {
+            size_t              num;
+            if (stage == 0)
+                num = (block.verts = slice(mesh.verts)).size();
+            else if (stage == 1)
+                num = (block.uvs = slice(mesh.uvs)).size();
+            else {
+                size_t              ss = (stage-2)/2;
+                Surf const &        surf = mesh.surfaces[ss];
+                block.surfIdx = uint(ss);
+                block.surfName = surf.name;
+                if (stage % 2 == 0)
+                    num = (block.tris = slice(surf.tris)).size();
+                else
+                    num = (block.quads = slice(surf.quads)).size();
+            }
+            if (num > 0) {
+                elemIdx += num;
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+template<uint dim>
+void
+appendFacets(FacetInds<dim> const & src,FacetInds<dim> & dst)
+{
+    cat_(dst.posInds,src.posInds);
+    cat_(dst.uvInds,src.uvInds);
+}
+
+}
+
+Sptr<MeshReader>
+meshReader(Mesh const & mesh,size_t blockElems)
+{return make_shared<MeshStreamReader>(mesh,blockElems); }
+
+void
+MeshCollector::write(MeshBlock const & block)
+{
+    cat_(mesh.verts,block.verts);
+    cat_(mesh.uvs,block.uvs);
+    if (!block.hasFacets())
+        return;
+    if (block.surfIdx >= mesh.surfaces.size())
+        mesh.surfaces.resize(block.surfIdx+1);
+    Surf &              surf = mesh.surfaces[block.surfIdx];
+    if (surf.empty())
+        surf.name = block.surfName;
+    appendFacets(block.tris,surf.tris);
+    appendFacets(block.quads,surf.quads);
+}
+
+void
+MeshCollector::finish()
+{
+    for (Surf & surf : mesh.surfaces) {
+        if (!surf.tris.valid() || !surf.quads.valid()) {
+            surf.tris.uvInds.clear();
+            surf.quads.uvInds.clear();
+            fgout << fgnl << "WARNING: Partial UV indices ignored in surface " << surf.name;
+        }
+    }
+}
+
+Sptr<MeshReader>
+openMeshReader(Ustring const & fname)
+{
+    String              ext = toLower(pathToExt(fname).m_str);
+    if ((ext == "obj") || (ext == "wobj"))
+        return objReader(fname);
+    if (ext == "fgmesh")
+        return fgmeshReader(fname);
+    fgThrow("Mesh streaming is not supported for this file type",fname);
+    return Sptr<MeshReader>();
+}
+
+Sptr<MeshWriter>
+openMeshWriter(Ustring const & fname)
+{
+    String              ext = toLower(pathToExt(fname).m_str);
+    if ((ext == "obj") || (ext == "wobj"))
+        return objWriter(fname);
+    if (ext == "fgmesh")
+        return fgmeshWriter(fname);
+    fgThrow("Mesh streaming is not supported for this file type",fname);
+    return Sptr<MeshWriter>();
+}
+
+void
+streamCopy(MeshReader & src,MeshWriter & dst)
+{
+    MeshBlock           block;
+    src.rewind();
+    while (src.next(block))
+        dst.write(block);
+    dst.finish();
+}
+
+void
+streamTransform(MeshReader & src,Affine3F const & xform,MeshWriter & dst)
+{
+    MeshBlock           block;
+    src.rewind();
+    while (src.next(block)) {
+        mapMul_(xform,block.verts);
+        dst.write(block);
+    }
+    dst.finish();
+}
+
+namespace {
+
+template<uint dim>
+void
+markUsed(Svec<Mat<uint,dim,1> > const & inds,vector<bool> & used)
+{
+    for (Mat<uint,dim,1> const & ind : inds) {
+        for (uint ii=0; ii<dim; ++ii) {
+            FGASSERT(ind[ii] < used.size());
+            used[ind[ii]] = true;
+        }
+    }
+}
+
+template<uint dim>
+void
+remap(Svec<Mat<uint,dim,1> > & inds,Uints const & map)
+{
+    for (Mat<uint,dim,1> & ind : inds)
+        for (uint ii=0; ii<dim; ++ii)
+            ind[ii] = map[ind[ii]];
+}
+
+// Replace 'arr' by its elements flagged in 'keep' starting at 'base', advancing 'base':
+template<class T>
+void
+keepFlagged(Svec<T> & arr,vector<bool> const & keep,size_t & base)
+{
+    size_t              cnt = 0;
+    for (size_t ii=0; ii<arr.size(); ++ii)
+        if (keep[base+ii])
+            arr[cnt++] = arr[ii];
+    base += arr.size();
+    arr.resize(cnt);
+}
+
+// Assign new consecutive indices to the flagged elements:
+Uints
+flaggedIndices(vector<bool> const & flags)
+{
+    Uints               ret(flags.size(),numeric_limits<uint>::max());
+    uint                cnt = 0;
+    for (size_t ii=0; ii<flags.size(); ++ii)
+        if (flags[ii])
+            ret[ii] = cnt++;
+    return ret;
+}
+
+}
+
+void
+streamRemoveUnusedVerts(MeshReader & src,MeshWriter & dst)
+{
+    vector<bool>        vertUsed,
+                        uvUsed;
+    MeshBlock           block;
+    src.rewind();
+    while (src.next(block)) {
+        vertUsed.resize(vertUsed.size()+block.verts.size(),false);
+        uvUsed.resize(uvUsed.size()+block.uvs.size(),false);
+        markUsed(block.tris.posInds,vertUsed);
+        markUsed(block.quads.posInds,vertUsed);
+        markUsed(block.tris.uvInds,uvUsed);
+        markUsed(block.quads.uvInds,uvUsed);
+    }
+    Uints               vertMap = flaggedIndices(vertUsed),
+                        uvMap = flaggedIndices(uvUsed);
+    size_t              vertBase = 0,
+                        uvBase = 0;
+    src.rewind();
+    while (src.next(block)) {
+        keepFlagged(block.verts,vertUsed,vertBase);
+        keepFlagged(block.uvs,uvUsed,uvBase);
+        remap(block.tris.posInds,vertMap);
+        remap(block.quads.posInds,vertMap);
+        remap(block.tris.uvInds,uvMap);
+        remap(block.quads.uvInds,uvMap);
+        dst.write(block);
+    }
+    dst.finish();
+}
+
+namespace {
+
+struct  VertRecord
+{
+    Vec3UI              bits;           // As given by 'cPosBits' 
+    uint                idx;
+};
+
+// Removes the files on destruction so they are not left behind by an exception:
+struct  TempFiles
+{
+    Ustrings            fnames;
+
+    ~TempFiles()
+    {
+        for (Ustring const & fname : fnames) {
+            try {pathRemove(fname); }
+            catch (...) {}
+        }
+    }
+};
+
+}
+
+void
+streamUnifyIdenticalVerts(
+    MeshReader &        src,
+    MeshWriter &        dst,
+    Ustring const &     tempBase,
+    size_t              maxBytes)
+{
+    // Bytes per vertex when unifying a partition, allowing for the hash table overhead:
+    size_t const        bytesPerVert = 64;
+    FGASSERT(maxBytes >= 64*bytesPerVert);
+    MeshBlock           block;
+    size_t              numVerts = 0;
+    src.rewind();
+    while (src.next(block))
+        numVerts += block.verts.size();
+    FGASSERT(numVerts < numeric_limits<uint>::max());
+    size_t              numParts = (numVerts * bytesPerVert) / maxBytes + 1,
+                        bufferRecs = cMax(maxBytes / (4 * numParts * sizeof(VertRecord)),size_t(1));
+    TempFiles           temps;
+    for (size_t pp=0; pp<numParts; ++pp)
+        temps.fnames.push_back(tempBase + "." + toStr(pp) + ".tmp");
+    // Equal positions always fall in the same partition since it is chosen by hash. NaNs are never
+    // equal so they are left as their own representatives:
+    Uints               rep(numVerts);
+    {
+        Svec<Svec<VertRecord> >     buffers(numParts);
+        Svec<uint64>                partSizes(numParts,0);
+        auto                        flush = [&](size_t pp)
+        {
+            Svec<VertRecord> &          buf = buffers[pp];
+            Ofstream                    ofs(temps.fnames[pp],partSizes[pp] > 0);
+            ofs.write(reinterpret_cast<char const *>(buf.data()),buf.size()*sizeof(VertRecord));
+            ofs.close();
+            if (ofs.fail())
+                fgThrow("Error writing temporary file",temps.fnames[pp]);
+            partSizes[pp] += buf.size();
+            buf.clear();
+        };
+        PosBitsHash                 hash;
+        uint                        idx = 0;
+        src.rewind();
+        while (src.next(block)) {
+            for (Vec3F pos : block.verts) {
+                rep[idx] = idx;
+                VertRecord          rec {cPosBits(pos),idx};
+                if (!isNanBits(rec.bits[0]) && !isNanBits(rec.bits[1]) && !isNanBits(rec.bits[2])) {
+                    // The high bits are independent of the hash table bucket used below:
+                    size_t              pp = (uint64(hash(rec.bits)) >> 32) % numParts;
+                    buffers[pp].push_back(rec);
+                    if (buffers[pp].size() >= bufferRecs)
+                        flush(pp);
+                }
+                ++idx;
+            }
+        }
+        for (size_t pp=0; pp<numParts; ++pp)
+            if (!buffers[pp].empty())
+                flush(pp);
+        for (size_t pp=0; pp<numParts; ++pp) {
+            if (partSizes[pp] == 0)
+                continue;
+            Svec<VertRecord>            recs(size_t(partSizes[pp]));
+            Ifstream                    ifs(temps.fnames[pp]);
+            ifs.read(reinterpret_cast<char*>(recs.data()),recs.size()*sizeof(VertRecord));
+            if (!ifs)
+                fgThrow("Error reading temporary file",temps.fnames[pp]);
+            ifs.close();
+            pathRemove(temps.fnames[pp]);
+            // Records are in index order so the first of each position is its representative:
+            unordered_map<Vec3UI,uint,PosBitsHash>  firsts;
+            firsts.reserve(recs.size());
+            for (VertRecord const & rec : recs)
+                rep[rec.idx] = firsts.emplace(rec.bits,rec.idx).first->second;
+        }
+    }
+    // Representatives always precede their duplicates so this can be done in place:
+    uint                cnt = 0;
+    for (size_t ii=0; ii<rep.size(); ++ii)
+        rep[ii] = (rep[ii] == ii) ? cnt++ : rep[rep[ii]];
+    size_t              numUnique = cnt;
+    uint                idx = 0;
+    cnt = 0;
+    src.rewind();
+    while (src.next(block)) {
+        Vec3Fs              verts;
+        for (Vec3F const & pos : block.verts)
+            if (rep[idx++] == cnt) {
+                verts.push_back(pos);
+                ++cnt;
+            }
+        block.verts = verts;
+        remap(block.tris.posInds,rep);
+        remap(block.quads.posInds,rep);
+        dst.write(block);
+    }
+    FGASSERT(cnt == numUnique);
+    dst.finish();
+}
+
+namespace {
+
+uint
+findRoot(Uints & parents,uint idx)
+{
+    while (parents[idx] != idx) {
+        parents[idx] = parents[parents[idx]];       // Path halving
+        idx = parents[idx];
+    }
+    return idx;
+}
+
+template<uint dim>
+void
+unionUvs(FacetInds<dim> const & fis,Uints & parents)
+{
+    if (fis.uvInds.size() != fis.posInds.size())
+        fgThrow("Splitting surfaces by UVs requires all facets to have UVs");
+    for (Mat<uint,dim,1> const & ind : fis.uvInds) {
+        for (uint ii=0; ii<dim; ++ii)
+            FGASSERT(ind[ii] < parents.size());
+        uint                r0 = findRoot(parents,ind[0]);
+        for (uint ii=1; ii<dim; ++ii) {
+            uint                rr = findRoot(parents,ind[ii]);
+            if (rr != r0)
+                parents[cMax(rr,r0)] = cMin(rr,r0);
+            r0 = cMin(rr,r0);
+        }
+    }
+}
+
+}
+
+void
+streamSplitSurfsByUvs(MeshReader & src,MeshWriter & dst)
+{
+    uint const          none = numeric_limits<uint>::max();
+    Uints               parents;
+    MeshBlock           block;
+    src.rewind();
+    while (src.next(block)) {
+        size_t              num = parents.size();
+        parents.resize(num+block.uvs.size());
+        for (size_t ii=num; ii<parents.size(); ++ii)
+            parents[ii] = uint(ii);
+        unionUvs(block.tris,parents);
+        unionUvs(block.quads,parents);
+    }
+    // Components are numbered in order of their first facet:
+    Uints               comps(parents.size(),none);
+    uint                numComps = 0;
+    unordered_map<uint,size_t> outIdxs;     // Component to its output block for the current block
+    src.rewind();
+    while (src.next(block)) {
+        Svec<MeshBlock>     outs;
+        outIdxs.clear();
+        auto                component = [&](uint uvIdx)
+        {
+            uint &              comp = comps[findRoot(parents,uvIdx)];
+            if (comp == none)
+                comp = numComps++;
+            auto                ins = outIdxs.insert(make_pair(comp,outs.size()));
+            if (ins.second) {
+                outs.push_back(MeshBlock());
+                outs.back().surfIdx = comp;
+            }
+            return ins.first->second;
+        };
+        for (size_t ii=0; ii<block.tris.size(); ++ii) {
+            Tris &              tris = outs[component(block.tris.uvInds[ii][0])].tris;
+            tris.posInds.push_back(block.tris.posInds[ii]);
+            tris.uvInds.push_back(block.tris.uvInds[ii]);
+        }
+        for (size_t ii=0; ii<block.quads.size(); ++ii) {
+            Quads &             quads = outs[component(block.quads.uvInds[ii][0])].quads;
+            quads.posInds.push_back(block.quads.posInds[ii]);
+            quads.uvInds.push_back(block.quads.uvInds[ii]);
+        }
+        if (!block.verts.empty() || !block.uvs.empty()) {
+            MeshBlock           shared;
+            shared.verts = block.verts;
+            shared.uvs = block.uvs;
+            dst.write(shared);
+        }
+        for (MeshBlock const & out : outs)
+            dst.write(out);
+    }
+    fgout << fgnl << numComps << " separate UV-contiguous surfaces created";
+    dst.finish();
+}
+
+namespace {
+
+void
+checkSameShape(Mesh const & lhs,Mesh const & rhs,bool names=true)
+{
+    FGASSERT(lhs.verts == rhs.verts);
+    FGASSERT(lhs.uvs == rhs.uvs);
+    FGASSERT(lhs.surfaces.size() == rhs.surfaces.size());
+    for (size_t ss=0; ss<lhs.surfaces.size(); ++ss) {
+        Surf const &        ls = lhs.surfaces[ss];
+        Surf const &        rs = rhs.surfaces[ss];
+        if (names) {
+            FGASSERT(ls.name == rs.name);
+        }
+        FGASSERT(ls.tris.posInds == rs.tris.posInds);
+        FGASSERT(ls.tris.uvInds == rs.tris.uvInds);
+        FGASSERT(ls.quads.posInds == rs.quads.posInds);
+        FGASSERT(ls.quads.uvInds == rs.quads.uvInds);
+    }
+}
+
+Mesh
+collect(MeshReader & src)
+{
+    MeshCollector       mc;
+    streamCopy(src,mc);
+    return mc.mesh;
+}
+
+}
+
+void
+testMeshStream(CLArgs const & args)
+{
+    FGTESTDIR
+    Mesh                jane = loadTri(dataDir()+"base/Jane.tri");
+    jane.deltaMorphs.clear();
+    jane.targetMorphs.clear();
+    jane.markedVerts.clear();
+    for (Surf & surf : jane.surfaces)
+        surf.surfPoints.clear();
+    // Small blocks so that facets refer to vertices in earlier blocks:
+    size_t const        blockElems = 999;
+    // Operations rewind their input so a reader can be re-used:
+    Sptr<MeshReader>    reader = meshReader(jane,blockElems);
+    checkSameShape(collect(*reader),jane);
+    checkSameShape(collect(*reader),jane);
+    {
+        Affine3F            xform(Mat33F(0,1,0,-1,0,0,0,0,2),Vec3F(1,2,3));
+        Mesh                ref = jane;
+        ref.transform(xform);
+        MeshCollector       mc;
+        streamTransform(*meshReader(jane,blockElems),xform,mc);
+        checkSameShape(mc.mesh,ref);
+    }
+    {
+        Mesh                sub = jane;             // Leaves unused vertices and UVs
+        Quads &             quads = sub.surfaces[0].quads;
+        quads.posInds.resize(quads.size()/2);
+        quads.uvInds.resize(quads.posInds.size());
+        MeshCollector       mc;
+        streamRemoveUnusedVerts(*meshReader(sub,blockElems),mc);
+        checkSameShape(mc.mesh,meshRemoveUnusedVerts(sub));
+    }
+    {
+        // Duplicate the vertices and refer every other facet to the duplicates, with one pair
+        // differing only in the sign of zero. The sign is set on the bits since -ffast-math may
+        // ignore it otherwise:
+        Mesh                dup = jane;
+        uint                numVerts = uint(dup.verts.size());
+        cat_(dup.verts,jane.verts);
+        uint32 const        negZero = 0x80000000U;
+        dup.verts[0][0] = 0.0f;
+        memcpy(&dup.verts[numVerts][0],&negZero,4);
+        for (Surf & surf : dup.surfaces) {
+            for (size_t ii=0; ii<surf.tris.size(); ii+=2)
+                surf.tris.posInds[ii] += Vec3UI(numVerts);
+            for (size_t ii=0; ii<surf.quads.size(); ii+=2)
+                surf.quads.posInds[ii] += Vec4UI(numVerts);
+        }
+        Mesh                ref = unifyIdenticalVerts(dup);
+        MeshCollector       mc;
+        // Small enough to require several partitions:
+        streamUnifyIdenticalVerts(*meshReader(dup,blockElems),mc,"unify",size_t(1) << 16);
+        checkSameShape(mc.mesh,ref);
+        FGASSERT(!fileExists("unify.0.tmp"));
+        // NaNs are never unified, even with identical bits:
+        uint32 const        nanBits = 0x7FC00000U;
+        Vec3F               nan(0);
+        memcpy(&nan[1],&nanBits,4);
+        Mesh                nans;
+        nans.verts = {Vec3F(1,2,3),nan,Vec3F(1,2,3),nan};
+        nans.surfaces.push_back(Surf(Vec3UIs{{0,1,2},{2,3,0}}));
+        MeshCollector       nc;
+        streamUnifyIdenticalVerts(*meshReader(nans,blockElems),nc,"unify");
+        FGASSERT(nc.mesh.verts.size() == 3);
+        FGASSERT(isNanBits(cPosBits(nc.mesh.verts[1])[1]) && isNanBits(cPosBits(nc.mesh.verts[2])[1]));
+        FGASSERT(nc.mesh.surfaces[0].tris.posInds == Vec3UIs({{0,1,0},{0,2,0}}));
+        FGASSERT(!fileExists("unify.0.tmp"));
+    }
+    {
+        Mesh                quads = jane;
+        for (Surf & surf : quads.surfaces)
+            surf.tris = Tris();
+        Mesh                ref = splitSurfsByUvs(quads);
+        MeshCollector       mc;
+        streamSplitSurfsByUvs(*meshReader(quads,blockElems),mc);
+        checkSameShape(mc.mesh,ref);
+        // The many resulting surfaces share a single spool file:
+        streamSplitSurfsByUvs(*meshReader(quads,blockElems),*fgmeshWriter("split.fgmesh"));
+        FGASSERT(!fileExists("split.fgmesh.tmp"));
+        checkSameShape(loadFgmesh("split.fgmesh"),ref);
+        bool                threw = false;
+        try {
+            Mesh                noUvs = jane;
+            noUvs.surfaces[0].quads.uvInds.clear();
+            noUvs.surfaces[0].tris.uvInds.clear();
+            streamSplitSurfsByUvs(*meshReader(noUvs,blockElems),mc);
+        }
+        catch (FgException const &) {threw = true; }
+        FGASSERT(threw);
+    }
+    // File round trips and conversions. OBJ positions are written exactly and unnamed surfaces are
+    // given names:
+    streamCopy(*meshReader(jane,blockElems),*openMeshWriter("stream.obj"));
+    checkSameShape(collect(*objReader("stream.obj","g",4096)),jane,false);
+    checkSameShape(loadWObj("stream.obj","g"),jane,false);
+    streamCopy(*objReader("stream.obj","g",4096),*openMeshWriter("stream.fgmesh"));
+    FGASSERT(!fileExists("stream.fgmesh.tmp"));
+    checkSameShape(collect(*fgmeshReader("stream.fgmesh",blockElems)),jane,false);
+    checkSameShape(loadFgmesh("stream.fgmesh"),jane,false);
+    // Compressed and delta-coded arrays are decoded:
+    FgmeshOptions       opts;
+    opts.compress = true;
+    saveFgmesh("compressed.fgmesh",jane,opts);
+    checkSameShape(collect(*openMeshReader("compressed.fgmesh")),jane);
+    opts.quantize = true;
+    saveFgmesh("quantized.fgmesh",jane,opts);
+    checkSameShape(collect(*fgmeshReader("quantized.fgmesh",blockElems)),loadFgmesh("quantized.fgmesh"));
+}
+
+namespace {
+
+// A grid of quads with UVs in horizontal strips, so that there are several UV-contiguous
+// components, generated one row at a time:
+struct  GridReader : MeshReader
+{
+    uint                dim,
+                        stripRows,
+                        row = 0;
+
+    GridReader(uint d,uint s) : dim(d), stripRows(s) {}
+
+    void
+    rewind() override
+    {row = 0; }
+
+    bool
+    next(MeshBlock & block) override
+    {
+        if (row == dim)
+            return false;
+        block = MeshBlock();
+        for (uint xx=0; xx<dim; ++xx) {
+            block.verts.push_back(Vec3F(float(xx),float(row),float((xx*row) % 7)));
+            block.uvs.push_back(Vec2F(float(xx)/dim,float(row % stripRows)/stripRows));
+        }
+        // UV rows are duplicated at strip boundaries so facets between strips don't connect them:
+        if ((row > 0) && (row % stripRows != 0)) {
+            uint                base = (row-1)*dim;
+            for (uint xx=0; xx+1<dim; ++xx) {
+                Vec4UI              ind(base+xx,base+xx+1,base+dim+xx+1,base+dim+xx);
+                block.quads.posInds.push_back(ind);
+                block.quads.uvInds.push_back(ind);
+            }
+        }
+        ++row;
+        return true;
+    }
+};
+
+// Discards the output so that only the operation is timed:
+struct  NullWriter : MeshWriter
+{
+    void write(MeshBlock const &) override {}
+    void finish() override {}
+};
+
+}
+
+void
+testmMeshStream(CLArgs const & args)
+{
+    FGTESTDIR
+    uint const          dim = 1000;
+    GridReader          grid(dim,100);
+    NullWriter          nw;
+    fgout << fgnl << dim*dim << " verts" << fgnl << "operation,ms";
+    auto                time = [](String const & name,Sfun<void()> const & op)
+    {
+        Timer               timer;
+        op();
+        fgout << fgnl << name << "," << timer.readMs();
+    };
+    time("read",[&]{streamCopy(grid,nw); });
+    time("write fgmesh",[&]{streamCopy(grid,*fgmeshWriter("grid.fgmesh")); });
+    time("write obj",[&]{streamCopy(grid,*objWriter("grid.obj")); });
+    time("read fgmesh",[&]{streamCopy(*fgmeshReader("grid.fgmesh"),nw); });
+    time("read obj",[&]{streamCopy(*objReader("grid.obj"),nw); });
+    time("transform",[&]{streamTransform(grid,Affine3F(Vec3F(1)),nw); });
+    time("removeUnusedVerts",[&]{streamRemoveUnusedVerts(grid,nw); });
+    time("unifyIdenticalVerts",[&]{streamUnifyIdenticalVerts(grid,nw,"grid",size_t(1) << 24); });
+    time("splitSurfsByUvs",[&]{streamSplitSurfsByUvs(grid,nw); });
+}
+
+}
+
+// */
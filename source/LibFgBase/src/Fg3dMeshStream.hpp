@@ -0,0 +1,134 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Out-of-core mesh processing for meshes too large to hold in memory as a 'Mesh'.
+//
+// A mesh is streamed as a sequence of blocks in file order. Only the base shape is streamed: vertices,
+// UVs and the facets of named surfaces. Morphs, marked vertices, surface points and maps are not.
+// Every operation rewinds its input before reading it and multi-pass operations re-read it, so readers
+// must be rewindable and can be re-used for further operations.
+//
+// Memory use is bounded by the block size, except for index tables of up to 8 bytes per vertex or UV
+// where an operation must renumber them.
+//
+
+#ifndef FG3DMESHSTREAM_HPP
+#define FG3DMESHSTREAM_HPP
+
+#include "Fg3dMesh.hpp"
+
+namespace Fg {
+
+// Vertex and UV indices are into the whole mesh (not the block) and only refer to vertices and UVs
+// in this or earlier blocks:
+struct  MeshBlock
+{
+    Vec3Fs              verts;          // Appended to the mesh vertices
+    Vec2Fs              uvs;            // Appended to the mesh UVs
+    uint                surfIdx = 0;    // Surface to which the facets below are appended
+    Ustring             surfName;       // Name of that surface
+    Tris                tris;
+    Quads               quads;
+
+    bool
+    hasFacets() const
+    {return !(tris.empty() && quads.empty()); }
+
+    size_t
+    numFacets() const
+    {return tris.size() + quads.size(); }
+};
+
+struct  MeshReader
+{
+    virtual ~MeshReader() {};
+
+    // Returns false once the end of the mesh is reached:
+    virtual bool next(MeshBlock & block) = 0;
+
+    // Restart from the first block:
+    virtual void rewind() = 0;
+};
+
+struct  MeshWriter
+{
+    virtual ~MeshWriter() {};
+
+    virtual void write(MeshBlock const & block) = 0;
+
+    // Completes the output. No blocks may be written after:
+    virtual void finish() = 0;
+};
+
+// Streams an existing mesh, which must remain valid for the lifetime of the reader:
+Sptr<MeshReader>
+meshReader(Mesh const & mesh,size_t blockElems=size_t(1) << 20);
+
+// Wavefront OBJ. 'blockBytes' of text are parsed at a time. As for 'loadWObj' but with the
+// surfaces split by 'g' (as written by 'objWriter') unless another separator is given:
+Sptr<MeshReader>
+objReader(Ustring const & fname,String const & surfSeparator="g",size_t blockBytes=size_t(1) << 24);
+
+// Version 2 FGMESH. Uncompressed arrays are read directly from the mapping, compressed or
+// delta-coded arrays are decoded one chunk at a time:
+Sptr<MeshReader>
+fgmeshReader(Ustring const & fname,size_t blockElems=size_t(1) << 20);
+
+// By extension: [w]obj or fgmesh:
+Sptr<MeshReader>
+openMeshReader(Ustring const & fname);
+
+// Accumulates the streamed mesh in memory. UV indices are dropped from any surface in which only
+// some facets have them:
+struct  MeshCollector : MeshWriter
+{
+    Mesh                mesh;
+
+    void write(MeshBlock const & block) override;
+    void finish() override;
+};
+
+Sptr<MeshWriter>
+objWriter(Ustring const & fname);
+
+// Arrays are spooled to a single temporary file next to 'fname' then gathered into uncompressed chunks,
+// since each array must be contiguous in the file:
+Sptr<MeshWriter>
+fgmeshWriter(Ustring const & fname);
+
+// By extension: [w]obj or fgmesh:
+Sptr<MeshWriter>
+openMeshWriter(Ustring const & fname);
+
+// Format conversion. Calls 'dst.finish()' as do all the operations below:
+void
+streamCopy(MeshReader & src,MeshWriter & dst);
+
+// As 'Mesh::transform':
+void
+streamTransform(MeshReader & src,Affine3F const & xform,MeshWriter & dst);
+
+// As 'meshRemoveUnusedVerts'. Two passes:
+void
+streamRemoveUnusedVerts(MeshReader & src,MeshWriter & dst);
+
+// As 'unifyIdenticalVerts'. Vertices are partitioned by hashing their positions into temporary files
+// named from 'tempBase', each small enough to be unified in 'maxBytes'. Three passes:
+void
+streamUnifyIdenticalVerts(
+    MeshReader &        src,
+    MeshWriter &        dst,
+    Ustring const &     tempBase,
+    size_t              maxBytes=size_t(1) << 28);
+
+// As 'splitSurfsByUvs' but tris are also supported. All facets must have UVs. Two passes:
+void
+streamSplitSurfsByUvs(MeshReader & src,MeshWriter & dst);
+
+}
+
+#endif
+
+// */
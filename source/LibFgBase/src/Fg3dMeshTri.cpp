@@ -7,10 +7,14 @@
 #include "stdafx.h"
 
 #include "Fg3dMesh.hpp"
+#include "Fg3dMeshIo.hpp"
 #include "FgException.hpp"
 #include "FgStdStream.hpp"
 #include "FgBounds.hpp"
 #include "FgFileSystem.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
 
 using namespace std;
 
@@ -171,13 +175,252 @@ loadTri(istream & istr)
     return mesh;
 }
 
+namespace {
+
+// Sequential reads from a mapped file with bounds checking. Values are copied out since most are not
+// aligned in the file:
+struct  TriCursor
+{
+    uchar const *       data;
+    size_t              size;
+    Ustring const &     fname;
+    size_t              pos = 0;
+
+    TriCursor(uchar const * d,size_t s,Ustring const & f) : data(d), size(s), fname(f) {}
+
+    // Computed in 64 bits since the header counts are untrusted:
+    void
+    need(uint64 bytes) const
+    {
+        if (bytes > uint64(size - pos))
+            fgThrow("TRI file is truncated",fname);
+    }
+
+    size_t
+    skip(uint64 bytes)
+    {
+        need(bytes);
+        size_t          start = pos;
+        pos += size_t(bytes);
+        return start;
+    }
+
+    template<class T>
+    T
+    read()
+    {
+        need(sizeof(T));
+        T               val;
+        memcpy(&val,data+pos,sizeof(T));
+        pos += sizeof(T);
+        return val;
+    }
+
+    // Returns the position of the label record:
+    size_t
+    skipLabel(bool wchar)
+    {
+        size_t          start = pos;
+        uint32          len = read<uint32>();
+        skip(uint64(len) * (wchar ? sizeof(wchar_t) : 1));
+        return start;
+    }
+};
+
+}
+
+TriMapped::TriMapped(Ustring const & fname) : m_file(std::make_shared<MappedFile>(fname))
+{
+    TriCursor           cur(m_file->data(),m_file->size(),fname);
+    cur.need(8);
+    if (strncmp(reinterpret_cast<char const *>(cur.data),"FRTRI103",8) == 0)
+        fgThrow("File is encrypted, use 'fileconvert' utility to decrypt",fname);
+    if (strncmp(reinterpret_cast<char const *>(cur.data),triIdent.data(),8) != 0)
+        fgThrow("File not in TRI format",fname);
+    cur.pos = 8;
+    uint32              numVerts = cur.read<uint32>(),
+                        numTris = cur.read<uint32>(),
+                        numQuads = cur.read<uint32>(),
+                        numLabVerts = cur.read<uint32>(),
+                        numSurfPts = cur.read<uint32>(),
+                        numUvs = cur.read<uint32>(),
+                        texExt = cur.read<uint32>(),
+                        numDiffMorph = cur.read<uint32>(),
+                        numStatMorph = cur.read<uint32>(),
+                        numStatMorphVerts = cur.read<uint32>();
+    cur.skip(16);
+    bool                texs = ((texExt & 0x01) != 0);
+    m_wchar = ((texExt & 0x02) != 0);
+    if (m_wchar)
+        fgout << fgnl << "WARNING: Unicode labels being converted to ASCII.";
+    if (numVerts == 0)
+        fgThrow("TRI file has no vertices",fname);
+    m_verts = viewAt<Vec3F>(cur.skip(12*uint64(numVerts)),numVerts);
+    ArrayView<Vec3F>    targVerts = viewAt<Vec3F>(cur.skip(12*uint64(numStatMorphVerts)),numStatMorphVerts);
+    m_tris = viewAt<Vec3UI>(cur.skip(12*uint64(numTris)),numTris);
+    m_quads = viewAt<Vec4UI>(cur.skip(16*uint64(numQuads)),numQuads);
+    m_markedVerts.reserve(numLabVerts);
+    for (uint ii=0; ii<numLabVerts; ++ii) {
+        m_markedVerts.push_back(cur.skip(4));
+        cur.skipLabel(m_wchar);
+    }
+    m_surfPoints.reserve(numSurfPts);
+    for (uint ii=0; ii<numSurfPts; ++ii) {
+        m_surfPoints.push_back(cur.skip(16));
+        cur.skipLabel(m_wchar);
+    }
+    if (numUvs > 0) {
+        m_uvs = viewAt<Vec2F>(cur.skip(8*uint64(numUvs)),numUvs);
+        m_triUvInds = viewAt<Vec3UI>(cur.skip(12*uint64(numTris)),numTris);
+        m_quadUvInds = viewAt<Vec4UI>(cur.skip(16*uint64(numQuads)),numQuads);
+    }
+    else if (texs) {
+        m_uvs = viewAt<Vec2F>(cur.skip(8*uint64(numVerts)),numVerts);
+        m_perVertexUvs = true;
+    }
+    m_deltaMorphs.reserve(numDiffMorph);
+    for (uint mm=0; mm<numDiffMorph; ++mm) {
+        DeltaMorph          dm;
+        dm.namePos = cur.skipLabel(m_wchar);
+        dm.scale = cur.read<float>();
+        dm.vals = viewAt<Vec3S>(cur.skip(6*uint64(numVerts)),numVerts);
+        m_deltaMorphs.push_back(dm);
+    }
+    size_t              targVertsStart = 0;
+    for (uint mm=0; mm<numStatMorph; ++mm) {
+        TargetMorph         tm;
+        tm.namePos = cur.skipLabel(m_wchar);
+        uint32              num = cur.read<uint32>();
+        if (num > 0) {
+            if (num > targVerts.size() - targVertsStart)
+                fgThrow("TRI file target morph vertex count inconsistent",fname);
+            tm.baseInds = viewAt<uint>(cur.skip(4*uint64(num)),num);
+            tm.verts = ArrayView<Vec3F>(targVerts.ptr+targVertsStart,num);
+            targVertsStart += num;
+            m_targetMorphs.push_back(tm);
+        }
+    }
+}
+
+void const *
+TriMapped::alignedPtr(size_t pos,size_t bytes,size_t align)
+{
+    uchar const *       ptr = m_file->data() + pos;
+    if (reinterpret_cast<uintptr_t>(ptr) % align == 0)
+        return ptr;
+    m_copies.push_back(Uints((bytes+3)/4));
+    memcpy(m_copies.back().data(),ptr,bytes);
+    return m_copies.back().data();
+}
+
+// Bounds were checked on construction:
+String
+TriMapped::labelAt(size_t pos) const
+{
+    uchar const *       ptr = m_file->data() + pos;
+    uint32              len;
+    memcpy(&len,ptr,4);
+    ptr += 4;
+    String              ret;
+    if (len == 0)
+        return ret;
+    ret.resize(len);
+    for (uint ii=0; ii<len; ++ii) {
+        if (m_wchar) {
+            wchar_t             wch;
+            memcpy(&wch,ptr+ii*sizeof(wchar_t),sizeof(wchar_t));
+            ret[ii] = char(wch);
+        }
+        else
+            ret[ii] = char(ptr[ii]);
+    }
+    // Get rid of NULL terminating character required by spec:
+    ret.resize(len-1);
+    return ret;
+}
+
+MarkedVert
+TriMapped::markedVert(size_t idx) const
+{
+    size_t              pos = m_markedVerts[idx];
+    uint32              vertIdx;
+    memcpy(&vertIdx,m_file->data()+pos,4);
+    return MarkedVert {vertIdx,labelAt(pos+4)};
+}
+
+SurfPoint
+TriMapped::surfPoint(size_t idx) const
+{
+    size_t              pos = m_surfPoints[idx];
+    SurfPoint           ret;
+    memcpy(&ret.triEquivIdx,m_file->data()+pos,4);
+    memcpy(&ret.weights[0],m_file->data()+pos+4,12);
+    ret.label = labelAt(pos+16);
+    return ret;
+}
+
+String
+TriMapped::deltaMorphName(size_t idx) const
+{return labelAt(m_deltaMorphs[idx].namePos); }
+
+String
+TriMapped::targetMorphName(size_t idx) const
+{return labelAt(m_targetMorphs[idx].namePos); }
+
+Mesh
+TriMapped::toMesh() const
+{
+    Mesh                mesh;
+    mesh.verts.assign(m_verts.begin(),m_verts.end());
+    // A TRI has at most one surface:
+    bool                hasSurface = (!m_tris.empty() || !m_quads.empty());
+    if (hasSurface)
+        mesh.surfaces.resize(1);
+    Surf                dummy;
+    Surf &              surf = hasSurface ? mesh.surfaces[0] : dummy;
+    surf.tris.posInds.assign(m_tris.begin(),m_tris.end());
+    surf.quads.posInds.assign(m_quads.begin(),m_quads.end());
+    mesh.markedVerts.reserve(numMarkedVerts());
+    for (size_t ii=0; ii<numMarkedVerts(); ++ii)
+        mesh.markedVerts.push_back(markedVert(ii));
+    surf.surfPoints.reserve(numSurfPoints());
+    for (size_t ii=0; ii<numSurfPoints(); ++ii)
+        surf.surfPoints.push_back(surfPoint(ii));
+    mesh.uvs.assign(m_uvs.begin(),m_uvs.end());
+    if (m_perVertexUvs) {               // Convert to indexed UVs
+        surf.tris.uvInds = surf.tris.posInds;
+        surf.quads.uvInds = surf.quads.posInds;
+    }
+    else if (!m_uvs.empty()) {
+        surf.tris.uvInds.assign(m_triUvInds.begin(),m_triUvInds.end());
+        surf.quads.uvInds.assign(m_quadUvInds.begin(),m_quadUvInds.end());
+    }
+    mesh.deltaMorphs.resize(m_deltaMorphs.size());
+    for (size_t mm=0; mm<m_deltaMorphs.size(); ++mm) {
+        DeltaMorph const &  dm = m_deltaMorphs[mm];
+        Morph &             morph = mesh.deltaMorphs[mm];
+        morph.name = deltaMorphName(mm);
+        morph.verts.resize(dm.vals.size());
+        for (size_t vv=0; vv<dm.vals.size(); ++vv)
+            morph.verts[vv] = Vec3F(dm.vals[vv]) * dm.scale;
+    }
+    mesh.targetMorphs.resize(m_targetMorphs.size());
+    for (size_t mm=0; mm<m_targetMorphs.size(); ++mm) {
+        TargetMorph const & tm = m_targetMorphs[mm];
+        IndexedMorph &      morph = mesh.targetMorphs[mm];
+        morph.name = targetMorphName(mm);
+        morph.baseInds.assign(tm.baseInds.begin(),tm.baseInds.end());
+        morph.verts.assign(tm.verts.begin(),tm.verts.end());
+    }
+    return mesh;
+}
+
 Mesh
 loadTri(Ustring const & fname)
 {
     Mesh        ret;
     try {
-        Ifstream      ff(fname);
-        ret = loadTri(ff);
+        ret = TriMapped(fname).toMesh();
     }
     catch (FgException & e) {
         e.m_ct.back().dataUtf8 = fname.m_str;
@@ -295,4 +538,106 @@ saveTri(
     }
 }
 
+static
+void
+checkTriEqual(Mesh const & lhs,Mesh const & rhs)
+{
+    FGASSERT(lhs.verts == rhs.verts);
+    FGASSERT(lhs.uvs == rhs.uvs);
+    FGASSERT(lhs.surfaces.size() == rhs.surfaces.size());
+    for (size_t ss=0; ss<lhs.surfaces.size(); ++ss) {
+        Surf const &        ls = lhs.surfaces[ss],
+                            rs = rhs.surfaces[ss];
+        FGASSERT(ls.tris.posInds == rs.tris.posInds);
+        FGASSERT(ls.tris.uvInds == rs.tris.uvInds);
+        FGASSERT(ls.quads.posInds == rs.quads.posInds);
+        FGASSERT(ls.quads.uvInds == rs.quads.uvInds);
+        FGASSERT(ls.surfPoints.size() == rs.surfPoints.size());
+        for (size_t ii=0; ii<ls.surfPoints.size(); ++ii) {
+            FGASSERT(ls.surfPoints[ii].triEquivIdx == rs.surfPoints[ii].triEquivIdx);
+            FGASSERT(ls.surfPoints[ii].weights == rs.surfPoints[ii].weights);
+            FGASSERT(ls.surfPoints[ii].label == rs.surfPoints[ii].label);
+        }
+    }
+    FGASSERT(lhs.markedVerts.size() == rhs.markedVerts.size());
+    for (size_t ii=0; ii<lhs.markedVerts.size(); ++ii) {
+        FGASSERT(lhs.markedVerts[ii].idx == rhs.markedVerts[ii].idx);
+        FGASSERT(lhs.markedVerts[ii].label == rhs.markedVerts[ii].label);
+    }
+    FGASSERT(lhs.deltaMorphs.size() == rhs.deltaMorphs.size());
+    for (size_t ii=0; ii<lhs.deltaMorphs.size(); ++ii) {
+        FGASSERT(lhs.deltaMorphs[ii].name == rhs.deltaMorphs[ii].name);
+        FGASSERT(lhs.deltaMorphs[ii].verts == rhs.deltaMorphs[ii].verts);
+    }
+    FGASSERT(lhs.targetMorphs.size() == rhs.targetMorphs.size());
+    for (size_t ii=0; ii<lhs.targetMorphs.size(); ++ii) {
+        FGASSERT(lhs.targetMorphs[ii].name == rhs.targetMorphs[ii].name);
+        FGASSERT(lhs.targetMorphs[ii] == rhs.targetMorphs[ii]);
+    }
+}
+
+static
+Mesh
+loadTriStream(Ustring const & fname)
+{
+    Ifstream            ifs(fname);
+    return loadTri(ifs);
+}
+
+void
+testTriMapped(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    for (String name : {"Jane","JaneLoresFace","Mouth","Glasses","Hair","test/teethLower"})
+        checkTriEqual(loadTri(dd+name+".tri"),loadTriStream(dd+name+".tri"));
+    // Odd length labels leave the following arrays misaligned in the file:
+    Mesh                mesh = loadTri(dd+"Mouth.tri");
+    mesh.markedVerts = {MarkedVert{3,"a"},MarkedVert{7,"odd"}};
+    mesh.deltaMorphs[0].name = "a";
+    mesh.targetMorphs[0].name = "xy";
+    saveTri("aligned.tri",mesh);
+    {
+        TriMapped           tm("aligned.tri");
+        checkTriEqual(tm.toMesh(),loadTriStream("aligned.tri"));
+        FGASSERT(tm.numMarkedVerts() == 2);
+        FGASSERT(tm.markedVert(1).label == "odd");
+        FGASSERT(tm.targetMorphName(0) == "xy");
+        FGASSERT(reinterpret_cast<uintptr_t>(tm.uvs().ptr) % alignof(Vec2F) == 0);
+        FGASSERT(reinterpret_cast<uintptr_t>(tm.deltaMorphVals(0).ptr) % alignof(Vec3S) == 0);
+    }
+    // Truncation anywhere must be detected rather than read beyond the mapping:
+    String              data = loadRawString("aligned.tri");
+    for (size_t len : {size_t(0),size_t(7),size_t(40),data.size()/2,data.size()-1}) {
+        saveRaw(data.substr(0,len),"truncated.tri",false);
+        bool                threw = false;
+        try {TriMapped("truncated.tri"); }
+        catch (FgException const &) {threw = true; }
+        FGASSERT(threw);
+    }
+}
+
+void
+testmTriMapped(CLArgs const &)
+{
+    Ustring             fname = dataDir() + "base/Jane.tri";
+    size_t const        reps = 50;
+    Timer               timer;
+    for (size_t ii=0; ii<reps; ++ii)
+        loadTriStream(fname);
+    double              streamMs = double(timer.readMs()) / reps;
+    timer.start();
+    for (size_t ii=0; ii<reps; ++ii)
+        loadTri(fname);
+    double              meshMs = double(timer.readMs()) / reps;
+    timer.start();
+    size_t              numVerts = 0;
+    for (size_t ii=0; ii<reps; ++ii)
+        numVerts += TriMapped(fname).verts().size();
+    double              viewMs = double(timer.readMs()) / reps;
+    FGASSERT(numVerts == reps * 5850);
+    fgout << fgnl << "Jane.tri ms per load: stream " << streamMs << ", mapped mesh " << meshMs
+        << ", mapped views " << viewMs;
+}
+
 }
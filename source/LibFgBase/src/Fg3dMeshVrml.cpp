@@ -12,6 +12,7 @@
 #include "FgParse.hpp"
 #include "FgMain.hpp"
 #include "FgTestUtils.hpp"
+#include "FgTextWriter.hpp"
 
 using namespace std;
 
@@ -19,7 +20,7 @@ namespace Fg {
 
 template<uint dim>
 void
-writePoint(Ofstream & ofs,Mat<float,dim,1> const & pnt)
+writePoint(TextWriter & ofs,Mat<float,dim,1> const & pnt)
 {
     ofs << "               ";
     for (uint kk=0; kk<dim; ++kk)
@@ -28,7 +29,7 @@ writePoint(Ofstream & ofs,Mat<float,dim,1> const & pnt)
 
 template<uint dim>
 void
-writePoints(Ofstream & ofs,vector<Mat<float,dim,1> > const & pts)
+writePoints(TextWriter & ofs,vector<Mat<float,dim,1> > const & pts)
 {
     if (pts.empty())
         return;
@@ -46,7 +47,7 @@ writePoints(Ofstream & ofs,vector<Mat<float,dim,1> > const & pts)
 
 template<uint dim>
 void
-writeIdx(Ofstream & ofs,Mat<uint,dim,1> const & idx)
+writeIdx(TextWriter & ofs,Mat<uint,dim,1> const & idx)
 {
     ofs << "            ";
     for (uint ii=0; ii<dim; ++ii)
@@ -56,7 +57,7 @@ writeIdx(Ofstream & ofs,Mat<uint,dim,1> const & idx)
 
 template<uint dim>
 void
-writeIndices(Ofstream & ofs,vector<Mat<uint,dim,1> > const &  inds)
+writeIndices(TextWriter & ofs,vector<Mat<uint,dim,1> > const &  inds)
 {
     if (inds.size() == 0)
         return;
@@ -74,7 +75,7 @@ saveVrml(
     string                  imgFormat)
 {
     FGASSERT(meshes.size() > 0);
-    Ofstream            ofs(filename);
+    TextWriter          ofs(filename);
     ofs.precision(7);
     ofs <<
         "#VRML V2.0 utf8\n"
@@ -15,6 +15,7 @@
 #include "FgCommand.hpp"
 #include "FgTestUtils.hpp"
 #include "FgImageIo.hpp"
+#include "FgTextWriter.hpp"
 
 using namespace std;
 
@@ -72,7 +73,7 @@ static bool saveXsiFile(
 
     Path      path(fname);
     path.ext = "xsi";
-    Ofstream ofs(path.str());
+    TextWriter ofs(path.str());
     if (!ofs)
     {
         return false;
@@ -610,9 +611,11 @@ static bool saveXsiFile(
 //
 static string floatToString(float val)
 {
-    std::ostringstream   oss;
-    oss << std::fixed << std::setw(4) << std::setfill('0') << val;
-    return oss.str();
+    string      str;
+    appendFixed(str,val,6);
+    if (str.size() < 4)         // Zero-filled to a minimum width of 4
+        str.insert(0,4-str.size(),'0');
+    return str;
 }
 
 void
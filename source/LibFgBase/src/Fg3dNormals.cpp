@@ -56,27 +56,36 @@ cVertNorms(Vec3Ds const & verts,Vec3UIs const & tris)
 MeshNormals
 cNormals(Surfs const & surfs,Vec3Fs const & verts)
 {
-    MeshNormals             norms;
+    MeshNormals         norms;
+    Vec3Ds              vertAccs;
+    cNormals_(surfs,verts,vertAccs,norms);
+    return norms;
+}
+
+void
+cNormals_(Surfs const & surfs,Vec3Fs const & verts,Vec3Ds & vertAccs,MeshNormals & norms)
+{
     norms.facet.resize(surfs.size());
-    Vec3Ds              vertNorms(verts.size(),Vec3D(0));
+    vertAccs.assign(verts.size(),Vec3D(0));
     // Calculate facet normals and accumulate unnormalized vertex normals:
     for (size_t ss=0; ss<surfs.size(); ss++) {
         Surf const &        surf = surfs[ss];
         FacetNormals &      fnorms = norms.facet[ss];
-        fnorms.tri.reserve(surf.numTris());
-        fnorms.quad.reserve(surf.numQuads());
+        fnorms.tri.resize(surf.tris.posInds.size());
+        fnorms.quad.resize(surf.quads.posInds.size());
         // TRIs
-        for (Vec3UI tri : surf.tris.posInds) {
+        for (size_t ii=0; ii<surf.tris.posInds.size(); ++ii) {
+            Vec3UI      tri = surf.tris.posInds[ii];
             Vec3D       norm = cFacetNorm(verts,tri);
-            vertNorms[tri[0]] += norm;
-            vertNorms[tri[1]] += norm;
-            vertNorms[tri[2]] += norm;
-            Vec3F       normf(norm);
-            fnorms.tri.push_back(normf);
+            vertAccs[tri[0]] += norm;
+            vertAccs[tri[1]] += norm;
+            vertAccs[tri[2]] += norm;
+            fnorms.tri[ii] = Vec3F(norm);
         }
         // QUADs
         // This least squares surface normal is taken from [Mantyla 87]:
-        for (Vec4UI quad : surf.quads.posInds) {
+        for (size_t ii=0; ii<surf.quads.posInds.size(); ++ii) {
+            Vec4UI      quad = surf.quads.posInds[ii];
             Vec3D       v0(verts[quad[0]]),
                         v1(verts[quad[1]]),
                         v2(verts[quad[2]]),
@@ -99,24 +108,23 @@ cNormals(Surfs const & surfs,Vec3Fs const & verts)
                 norm = Vec3D(0);
             else
                 norm = cross * (1.0 / crossMag);
-            vertNorms[quad[0]] += norm;
-            vertNorms[quad[1]] += norm;
-            vertNorms[quad[2]] += norm;
-            vertNorms[quad[3]] += norm;
-            Vec3F       normf(norm);
-            fnorms.quad.push_back(normf);
+            vertAccs[quad[0]] += norm;
+            vertAccs[quad[1]] += norm;
+            vertAccs[quad[2]] += norm;
+            vertAccs[quad[3]] += norm;
+            fnorms.quad[ii] = Vec3F(norm);
         }
     }
     // Normalize vertex normals:
-    norms.vert.reserve(verts.size());
-    for (Vec3D norm : vertNorms) {
+    norms.vert.resize(verts.size());
+    for (size_t ii=0; ii<vertAccs.size(); ++ii) {
+        Vec3D           norm = vertAccs[ii];
         double          len = cLen(norm);
         if(len > 0.0)
-            norms.vert.push_back(Vec3F(norm/len));
+            norms.vert[ii] = Vec3F(norm/len);
         else
-            norms.vert.push_back(Vec3F(0,0,1));     // Arbitrary
+            norms.vert[ii] = Vec3F(0,0,1);      // Arbitrary
     }
-    return norms;
 }
 
 }
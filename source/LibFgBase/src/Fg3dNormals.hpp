@@ -49,6 +49,11 @@ typedef Svec<MeshNormals>       MeshNormalss;
 MeshNormals
 cNormals(Surfs const & surfs,Vec3Fs const & verts);
 
+// As above but re-using the storage of 'norms' and the working storage 'vertAccs', so that no heap
+// allocation is done when they have already been used for the same mesh topology:
+void
+cNormals_(Surfs const & surfs,Vec3Fs const & verts,Vec3Ds & vertAccs,MeshNormals & norms);
+
 inline
 MeshNormals
 cNormals(Mesh const & mesh)
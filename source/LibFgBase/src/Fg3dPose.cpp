@@ -33,6 +33,126 @@ macAsTargetMorph_(
     }
 }
 
+namespace {
+
+float const             quantMax = 32767.0f;        // Symmetric so the centre of the bounds is exact
+
+QuantVerts
+quantizeFinite(Vec3Fs const & verts)
+{
+    QuantVerts          ret;
+    ret.vals.resize(verts.size());
+    if (verts.empty())
+        return ret;
+    Mat32F              bounds = cBounds(verts);
+    for (uint dd=0; dd<3; ++dd) {
+        ret.offset[dd] = (bounds.rc(dd,0) + bounds.rc(dd,1)) * 0.5f;
+        ret.scale[dd] = (bounds.rc(dd,1) - bounds.rc(dd,0)) * 0.5f / quantMax;
+    }
+    for (size_t ii=0; ii<verts.size(); ++ii) {
+        for (uint dd=0; dd<3; ++dd) {
+            float               q = 0;
+            if (ret.scale[dd] > 0)
+                q = clampBounds(std::round((verts[ii][dd] - ret.offset[dd]) / ret.scale[dd]),-quantMax,quantMax);
+            ret.vals[ii][dd] = int16(q);
+        }
+        ret.maxErr = std::max(ret.maxErr,cLen(ret[ii] - verts[ii]));
+    }
+    return ret;
+}
+
+}
+
+QuantVerts
+quantize(Vec3Fs const & verts)
+{
+    for (Vec3F const & v : verts)
+        if (!isFinite(v))
+            fgThrow("Cannot quantize non-finite vertex",toStr(v));
+    return quantizeFinite(verts);
+}
+
+Vec3Fs
+dequantize(QuantVerts const & qv)
+{
+    Vec3Fs              ret;
+    ret.reserve(qv.size());
+    for (size_t ii=0; ii<qv.size(); ++ii)
+        ret.push_back(qv[ii]);
+    return ret;
+}
+
+void
+QuantMorph::accAsDelta_(float val,Vec3Fs & accVerts) const
+{
+    FGASSERT(baseInds.size() == verts.size());
+    FGASSERT(baseInds.empty() || (cMax(baseInds) < accVerts.size()));
+    Vec3F               off = verts.offset * val,
+                        scl = verts.scale * val;
+    for (size_t ii=0; ii<baseInds.size(); ++ii)
+        accVerts[baseInds[ii]] += off + mapMul(scl,Vec3F(verts.vals[ii]));
+}
+
+void
+QuantMorph::accAsTarget_(Vec3Fs const & baseVerts,float val,Vec3Fs & accVerts) const
+{
+    FGASSERT(baseInds.size() == verts.size());
+    FGASSERT(baseVerts.size() == accVerts.size());
+    FGASSERT(baseInds.empty() || (cMax(baseInds) < accVerts.size()));
+    for (size_t ii=0; ii<baseInds.size(); ++ii) {
+        size_t              idx = baseInds[ii];
+        accVerts[idx] += (verts[ii] - baseVerts[idx]) * val;
+    }
+}
+
+QuantMorph
+quantizeDelta(Morph const & deltaMorph,float zeroTol)
+{
+    QuantMorph          ret;
+    ret.name = deltaMorph.name;
+    Vec3Fs              deltas;
+    float               omittedErr = 0;
+    for (size_t ii=0; ii<deltaMorph.verts.size(); ++ii) {
+        Vec3F               del = deltaMorph.verts[ii];
+        if (!isFinite(del))
+            fgThrow("Cannot quantize non-finite delta in morph",deltaMorph.name);
+        if (cMaxElem(mapAbs(del)) > zeroTol) {
+            ret.baseInds.push_back(uint(ii));
+            deltas.push_back(del);
+        }
+        else
+            omittedErr = std::max(omittedErr,cLen(del));
+    }
+    ret.verts = quantizeFinite(deltas);
+    ret.verts.maxErr = std::max(ret.verts.maxErr,omittedErr);
+    return ret;
+}
+
+QuantMorph
+quantize(IndexedMorph const & morph)
+{
+    FGASSERT(morph.baseInds.size() == morph.verts.size());
+    return QuantMorph {morph.name,morph.baseInds,quantize(morph.verts)};
+}
+
+Morph
+dequantizeDelta(QuantMorph const & deltaMorph,size_t numVerts)
+{
+    Morph               ret {deltaMorph.name,Vec3Fs(numVerts,Vec3F(0))};
+    deltaMorph.accAsDelta_(1.0f,ret.verts);
+    return ret;
+}
+
+IndexedMorph
+dequantize(QuantMorph const & morph)
+{
+    IndexedMorph        ret;
+    ret.name = morph.name;
+    ret.baseInds = morph.baseInds;
+    ret.verts = dequantize(morph.verts);
+    return ret;
+}
+
 void
 accDeltaMorphs(
     Morphs const &     deltaMorphs,
@@ -48,6 +168,18 @@ accDeltaMorphs(
     }
 }
 
+void
+accDeltaMorphs(
+    QuantMorphs const &         deltaMorphs,
+    Floats const &              coord,
+    Vec3Fs &                    accVerts)
+{
+    FGASSERT(deltaMorphs.size() == coord.size());
+    for (size_t ii=0; ii<deltaMorphs.size(); ++ii)
+        if (coord[ii] != 0)
+            deltaMorphs[ii].accAsDelta_(coord[ii],accVerts);
+}
+
 void
 accTargetMorphs(
     Vec3Fs const &             allVerts,
@@ -72,6 +72,62 @@ struct  IndexedMorph
 
 typedef Svec<IndexedMorph>  IndexedMorphs;
 
+// Vertex positions or deltas quantized to 16 bits per axis, for compact storage of large morph sets.
+// Each axis is mapped over its own bounds so the error per axis is at most half a quantization step:
+struct  QuantVerts
+{
+    Vec3F               offset;         // Centre of the bounds
+    Vec3F               scale;          // Decoded value is 'offset' + 'scale' * quantized value
+    Svec<Vec3S>         vals;
+    // Greatest distance of a decoded vertex from its original. For a delta morph this also
+    // includes the deltas omitted as negligible:
+    float               maxErr = 0;
+
+    size_t
+    size() const
+    {return vals.size(); }
+
+    Vec3F
+    operator[](size_t idx) const
+    {return offset + mapMul(scale,Vec3F(vals[idx])); }
+};
+
+QuantVerts
+quantize(Vec3Fs const & verts);
+
+Vec3Fs
+dequantize(QuantVerts const & qv);
+
+// Quantized equivalent of IndexedMorph, also used for delta morphs so that only the affected
+// vertices are stored. Morphing reads the quantized values directly:
+struct  QuantMorph
+{
+    Ustring             name;
+    Uints               baseInds;       // Increasing for delta morphs
+    QuantVerts          verts;          // Target positions or deltas. 1-1 with 'baseInds'
+
+    void
+    accAsDelta_(float val,Vec3Fs & accVerts) const;
+
+    void
+    accAsTarget_(Vec3Fs const & baseVerts,float val,Vec3Fs & accVerts) const;
+};
+
+typedef Svec<QuantMorph>    QuantMorphs;
+
+// Only vertices with a delta component greater in magnitude than 'zeroTol' are stored:
+QuantMorph
+quantizeDelta(Morph const & deltaMorph,float zeroTol=0);
+
+QuantMorph
+quantize(IndexedMorph const & morph);
+
+Morph
+dequantizeDelta(QuantMorph const & deltaMorph,size_t numVerts);
+
+IndexedMorph
+dequantize(QuantMorph const & morph);
+
 inline
 size_t
 cNumVerts(IndexedMorphs const & ims)
@@ -88,6 +144,13 @@ accDeltaMorphs(
     Floats const &              coord,
     Vec3Fs &                    accVerts);  // MODIFIED: morphing delta accumualted here
 
+// The error is at most the sum over morphs of abs(coord) * maxErr:
+void
+accDeltaMorphs(
+    QuantMorphs const &         deltaMorphs,
+    Floats const &              coord,
+    Vec3Fs &                    accVerts);  // MODIFIED: morphing delta accumulated here
+
 // This version of target morph application is more suited to SSM dataflow, where the
 // target positions have been transformed as part of the 'allVerts' array:
 void
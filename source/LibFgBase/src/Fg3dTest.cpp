@@ -17,6 +17,7 @@
 #include "FgAffine1.hpp"
 #include "FgBuild.hpp"
 #include "FgCoordSystem.hpp"
+#include "FgTime.hpp"
 
 using namespace std;
 
@@ -107,10 +108,19 @@ void fgSaveLwoTest(CLArgs const &);
 void fgSaveMaTest(CLArgs const &);
 void fgSaveFbxTest(CLArgs const &);
 void testSaveDae(CLArgs const &);
+void testSaveGlb(CLArgs const &);
 void fgSaveObjTest(CLArgs const &);
+void testLoadObj(CLArgs const &);
 void fgSavePlyTest(CLArgs const &);
 void fgSaveXsiTest(CLArgs const &);
 void testVrmlSave(CLArgs const &);
+void testTriMapped(CLArgs const &);
+void testFgmesh(CLArgs const &);
+void testLoadMeshes(CLArgs const &);
+void testLoadCache(CLArgs const &);
+void testPlyLoad(CLArgs const &);
+void testStlLoad(CLArgs const &);
+void testMeshStream(CLArgs const &);
 
 void
 test3d(CLArgs const & args)
@@ -121,8 +131,17 @@ test3d(CLArgs const & args)
         {fgSaveMaTest,"ma","Maya ASCII file format export"},
         {testSaveDae, "dae", "Collada DAE format export"},
         {fgSaveFbxTest, "fbx", ".FBX file format export"},
+        {testSaveGlb, "glb", "glTF binary format export with morph targets"},
+        {testFgmesh, "fgmesh", "FaceGen mesh format chunked import and export"},
+        {testLoadCache, "loadCache", "Process-wide cache of loaded meshes and images"},
+        {testLoadMeshes, "loadMeshes", "Concurrent batch mesh import with per-file errors"},
         {fgSaveObjTest, "obj", "Wavefront OBJ ASCII file format export"},
+        {testLoadObj, "objLoad", "Wavefront OBJ ASCII file format import"},
         {fgSavePlyTest, "ply", ".PLY file format export"},
+        {testPlyLoad, "plyLoad", ".PLY ASCII and binary file format import"},
+        {testStlLoad, "stlLoad", "Binary .STL file format import with vertex welding"},
+        {testMeshStream, "stream", "Streaming mesh I/O and out-of-core operations"},
+        {testTriMapped, "tri", "FaceGen TRI format memory mapped import"},
         {testVrmlSave,  "vrml", ".WRL file format export"},
 #ifdef _MSC_VER     // Precision differences with gcc/clang:
         {fgSaveXsiTest, "xsi", ".XSI file format export"},
@@ -132,6 +151,13 @@ test3d(CLArgs const & args)
 }
 
 void fgSaveFgmeshTest(CLArgs const &);
+void testmLoadObj(CLArgs const &);
+void testmTriMapped(CLArgs const &);
+void testmFgmesh(CLArgs const &);
+void testmLoadMeshes(CLArgs const &);
+void testmLoadCache(CLArgs const &);
+void testmLoadPlyStl(CLArgs const &);
+void testmMeshStream(CLArgs const &);
 
 void
 testmSubdFace(CLArgs const &)
@@ -171,14 +197,49 @@ testmSubdShapes(CLArgs const &)
     viewMesh(meshes,true);
 }
 
+void
+testmSaveText(CLArgs const & args)
+{
+    FGTESTDIR
+    Mesh            mesh = loadTri(dataDir()+"base/Jane.tri");
+    Meshes          meshes {mesh};
+    // Morphs are included since they dominate the output size of the formats that support them:
+    fgout << fgnl << mesh.verts.size() << " verts, " << mesh.numMorphs() << " morphs" << fgnl << "format,MB,ms,MB/s";
+    auto            time = [](String const & name,Ustring const & fname,Sfun<void()> const & save)
+    {
+        Timer           timer;
+        save();
+        uint64          ms = timer.readMs();
+        double          mb = double(loadRawString(fname).size()) / double(1 << 20);
+        fgout << fgnl << name << "," << mb << "," << ms << "," << mb * 1000.0 / double(cMax(ms,uint64(1)));
+    };
+    time("obj","saveText.obj",[&]{saveWObj("saveText.obj",meshes); });
+    time("ma","saveText.ma",[&]{saveMa("saveText.ma",meshes); });
+    time("xsi","saveText.xsi",[&]{saveXsi("saveText.xsi",meshes); });
+    time("dae","saveText.dae",[&]{saveDae("saveText.dae",meshes); });
+    time("vrml","saveText.wrl",[&]{saveVrml("saveText.wrl",meshes); });
+    time("ply","saveText.ply",[&]{savePly("saveText.ply",meshes); });
+    time("fbx","saveText.fbx",[&]{saveFbx("saveText.fbx",meshes); });
+    // Binary for comparison:
+    time("glb","saveText.glb",[&]{saveGlb("saveText.glb",meshes); });
+}
+
 void
 testm3d(CLArgs const & args)
 {
     Cmds            cmds {
         {edgeDist,"edgeDist"},
         {fgSaveFgmeshTest,"fgmesh","FaceGen mesh file format export"},  // Uses GUI
+        {testmLoadMeshes,"batchLoad","Batch mesh and map import speed, serial and concurrent"},
+        {testmLoadCache,"cacheLoad","Cached mesh and image reload speed with and without content hashing"},
+        {testmFgmesh,"fgmeshLoad","FaceGen mesh format load speed by version, compression and single morph"},
+        {testmLoadObj,"objLoad","Wavefront OBJ import speed on large synthetic meshes"},
+        {testmLoadPlyStl,"plyStlLoad","PLY and STL import speed on a large synthetic mesh"},
+        {testmSaveText,"saveText","Text mesh format export speed"},
+        {testmMeshStream,"streamOps","Streaming mesh I/O and out-of-core operation speed on a large synthetic mesh"},
         {testmSubdShapes,"subd0","Loop subdivsion of simple shapes"},
         {testmSubdFace,"subd1","Loop subdivision of textured face"},
+        {testmTriMapped,"triLoad","TRI import speed by stream and memory mapping"},
     };
     doMenu(args,cmds,true,false,true);
 }
@@ -15,6 +15,7 @@ Cmd     getImgopsCmd();
 Cmd     getMeshopsCmd();
 Cmd     getMorphCmd();
 Cmd     getRenderCmd();
+Cmd     getRenderServerCmd();
 Cmd     getTriExportCmd();
 void    cmdCons(CLArgs const &);
 Cmds    getViewCmds();
@@ -38,14 +38,19 @@ void fgMetaFormatTest(CLArgs const &);
 void fgMorphTest(CLArgs const &);
 void fgPathTest(CLArgs const &);
 void fgQuaternionTest(CLArgs const &);
+void testRayCaster(CLArgs const &);
 void fgCmdRenderTest(CLArgs const &);
+void fgCmdRenderServerTest(CLArgs const &);
+void testSampler(CLArgs const &);
 void fgSerializeTest(CLArgs const &);
 void fgSimilarityTest(CLArgs const &);
 void fgSimilarityApproxTest(CLArgs const &);
 void fgStdVectorTest(CLArgs const &);
 void fgStringTest(CLArgs const &);
+void testTextWriter(CLArgs const &);
 
 Cmd testSoftRenderInfo();   // Don't put these in a macro as it generates a clang warning about vexing parse.
+Cmd testmSoftRenderInfo();
 
 Cmds
 fgCmdBaseTests()
@@ -69,12 +74,16 @@ fgCmdBaseTests()
         {fgMorphTest,"morph"},
         {fgPathTest,"path"},
         {fgQuaternionTest,"quaternion"},
+        {testRayCaster,"rayCaster"},
         {fgCmdRenderTest,"rendc","render command"},
+        {fgCmdRenderServerTest,"renderd","render server on localhost"},
+        {testSampler,"sampler","Adaptive and progressive image sampling"},
         {fgSerializeTest,"serialize"},
         {fgSimilarityTest,"similarity"},
         {fgSimilarityApproxTest,"similarityApprox"},
         {fgStdVectorTest,"vector"},
         {fgStringTest,"string"},
+        {testTextWriter,"textWriter","Buffered text output number formatting"},
     };
     cmds.push_back(testSoftRenderInfo());
     return cmds;
@@ -123,7 +132,9 @@ void fgClusterDeployTestm(CLArgs const &);
 void fgCmdTestmCpp(CLArgs const &);
 void fg3dReadWobjTest(CLArgs const &);
 void fgRandomTest(CLArgs const &);
+void testmRayCaster(CLArgs const &);
 void testmGeometry(CLArgs const &);
+void testmTextWriter(CLArgs const &);
 void fgTextureImageMappingRenderTest(CLArgs const &);
 void fgImageTestm(CLArgs const &);
 
@@ -139,7 +150,10 @@ fgCmdBaseTestms()
         {fgCmdTestmCpp,"cpp","C++ behaviour tests"},
         {fg3dReadWobjTest,"readWobj"},
         {fgRandomTest,"random"},
+        {testmRayCaster,"rayCaster","RayCaster acceleration structure speed"},
+        {testmSoftRenderInfo()},
         {testmGeometry,"geometry"},
+        {testmTextWriter,"textWriter","TextWriter float formatting speed vs. std::ostream"},
         {fgTextureImageMappingRenderTest,"texturemap"},
         {fgImageTestm,"image"}
     };
@@ -173,6 +187,7 @@ fgCmdFgbl(CLArgs const & args)
         {getMeshopsCmd()},
         {getMorphCmd()},
         {getRenderCmd()},
+        {getRenderServerCmd()},
         {getTriExportCmd()},
         {cmdCons,"cons","Construct makefiles / solution file / project files"},
         {sysinfo,"sys","Show system info"},
@@ -33,16 +33,18 @@ combinesurfs(CLArgs const & args)
         "    <extOut> = " + meshSaveFormatsCLDescription() + "\n"
         "    All input meshes must have identical vertex lists.\n"
         );
-    Mesh    mesh = loadMesh(syn.next());
-    while (syn.more()) {
-        string  name = syn.next();
-        if (syn.more()) {
-            Mesh    next = loadMesh(name);
-            cat_(mesh.surfaces,next.surfaces);
-        }
-        else
-            saveMesh(mesh,name);
-    }
+    Ustrings        inNames {syn.next()};
+    while (syn.more())
+        inNames.push_back(syn.next());
+    if (inNames.size() < 2)
+        syn.error("At least one input and one output mesh must be given");
+    Ustring         outName = inNames.back();
+    inNames.pop_back();
+    Meshes          meshes = loadMeshes(inNames);
+    Mesh            mesh = meshes[0];
+    for (size_t ii=1; ii<meshes.size(); ++ii)
+        cat_(mesh.surfaces,meshes[ii].surfaces);
+    saveMesh(mesh,outName);
 }
 
 void
@@ -214,14 +216,14 @@ mmerge(CLArgs const & args)
         "    <extIn> = " + meshLoadFormatsCLDescription() + "\n"
         "    <extOut> = " + meshSaveFormatsCLDescription()
         );
-    Mesh    mesh = loadMesh(syn.next());
-    while (syn.more()) {
-        string  name = syn.next();
-        if (syn.more())
-            mesh = mergeMeshes(mesh,loadMesh(name));
-        else
-            saveMesh(mesh,name);
-    }
+    Ustrings        inNames {syn.next()};
+    while (syn.more())
+        inNames.push_back(syn.next());
+    if (inNames.size() < 2)
+        syn.error("At least one input and one output mesh must be given");
+    Ustring         outName = inNames.back();
+    inNames.pop_back();
+    saveMesh(mergeMeshes(loadMeshes(inNames)),outName);
 }
 
 void
@@ -330,9 +332,10 @@ sortFacets(CLArgs const & args)
     Mesh        mesh = loadMesh(syn.next());
     ImgC4UC     albedo = loadImage(syn.next());
     Ustring        outName = syn.next();
-    Mesh        opaque;
+    Ustrings    opaqueNames;
     while (syn.more())
-        opaque = mergeMeshes(opaque,loadMesh(syn.next()));
+        opaqueNames.push_back(syn.next());
+    Mesh        opaque = mergeMeshes(loadMeshes(opaqueNames));
     mesh = sortTransparentFaces(mesh,albedo,opaque);
     saveMesh(mesh,outName);
 }
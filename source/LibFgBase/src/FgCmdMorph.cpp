@@ -35,11 +35,13 @@ anim(CLArgs const & args)
         "      to the vertex list necessarily invalidates the morph data."
         );
     string                          suffix = syn.next();
+    Ustrings                        names;
+    while (endsWith(syn.peekNext(),".tri"))
+        names.push_back(syn.next());
+    Meshes                          loaded = loadMeshes(names);
     vector<pair<string,Mesh> >  meshes;
-    while (endsWith(syn.peekNext(),".tri")) {
-        string                      name = syn.next();
-        meshes.push_back(make_pair(name,loadTri(name)));
-    }
+    for (size_t ii=0; ii<names.size(); ++ii)
+        meshes.push_back(make_pair(names[ii].m_str,loaded[ii]));
     vector<pair<string,float> >     morphs;
     while (syn.more()) {
         string                      name = syn.next();
@@ -21,6 +21,11 @@
 #include "FgTestUtils.hpp"
 #include "FgBuild.hpp"
 #include "FgGridTriangles.hpp"
+#include "FgTcp.hpp"
+#include "FgFileCache.hpp"
+#include "FgParallel.hpp"
+#include "FgSerialize.hpp"
+#include "FgScopeGuard.hpp"
 
 using namespace std;
 
@@ -76,10 +81,216 @@ struct  Options
     FG_SERIALIZE3(rend,saveSurfPointFile,outputFile);
 };
 
+// The render options not included in RenderOptions serialization, sent to the server so it honours them:
+struct  RenderOptionsExt
+{
+    RenderBackend           backend;
+    RayCastAccel            rayCastAccel;
+    uint                    rasterSamplesDim;
+    bool                    mipmap;
+    uint64                  maxRays;
+    double                  maxSeconds;
+
+    RenderOptionsExt() : RenderOptionsExt(RenderOptions()) {}
+    explicit RenderOptionsExt(RenderOptions const & o) :
+        backend(o.backend), rayCastAccel(o.rayCastAccel), rasterSamplesDim(o.rasterSamplesDim),
+        mipmap(o.mipmap), maxRays(o.maxRays), maxSeconds(o.maxSeconds)
+    {}
+
+    void
+    apply(RenderOptions & o) const
+    {
+        o.backend = backend;
+        o.rayCastAccel = rayCastAccel;
+        o.rasterSamplesDim = rasterSamplesDim;
+        o.mipmap = mipmap;
+        o.maxRays = maxRays;
+        o.maxSeconds = maxSeconds;
+    }
+
+    FG_SERIALIZE6(backend,rayCastAccel,rasterSamplesDim,mipmap,maxRays,maxSeconds);
+};
+
+struct  RenderRequest
+{
+    RenderArgs              args;           // Model filenames must be valid on the server
+    RenderOptionsExt        optionsExt;
+    bool                    stopServer = false; // Only accepted from the server's host
+
+    FG_SERIALIZE3(args,optionsExt,stopServer);
+};
+
+struct  RenderResponse
+{
+    String                  error;          // Empty if successful
+    Uchars                  png;            // Encoded rendered image
+
+    FG_SERIALIZE2(error,png);
+};
+
+typedef Sfun<Sptr<Mesh const>(String const &)>      MeshLoader;
+typedef Sfun<Sptr<ImgC4UC const>(String const &)>   ImgLoader;
+
+// Loaded models shared between concurrent renders:
+struct  RenderCache
+{
+    LruCache<FileKey,Mesh>      meshes;
+    LruCache<FileKey,ImgC4UC>   images;
+
+    explicit RenderCache(size_t maxBytesEach) :
+        meshes(maxBytesEach,cMeshBytes),
+        images(maxBytesEach,cImageBytes)
+    {}
+
+    Sptr<Mesh const>
+    mesh(String const & triFilename)
+    {
+        return meshes.get(cFileKey(triFilename),
+            [](FileKey const & key){return std::make_shared<Mesh const>(loadTri(key.path)); });
+    }
+
+    Sptr<ImgC4UC const>
+    image(String const & imgFilename)
+    {
+        return images.get(cFileKey(imgFilename),
+            [](FileKey const & key){return std::make_shared<ImgC4UC const>(loadImage(key.path)); });
+    }
+};
+
 }   // namespace FgCmdRender
 
 using namespace FgCmdRender;
 
+static
+Meshes
+loadModels(Svec<ModelFiles> const & models,QuaternionD const & rotateToHcs,MeshLoader const & loadMesh,ImgLoader const & loadImg)
+{
+    Meshes              ret;
+    ret.reserve(models.size());
+    Mat33F              rotMatrix = Mat33F(rotateToHcs.asMatrix());
+    for (ModelFiles const & mf : models) {
+        ret.push_back(*loadMesh(mf.triFilename));
+        Mesh &              mesh = ret.back();
+        // The renderer never modifies maps so a shared image can be used without copying:
+        if (!mf.imgFilename.empty())
+            mesh.surfaces[0].material.albedoMap = std::const_pointer_cast<ImgC4UC>(loadImg(mf.imgFilename));
+        mesh.transform(rotMatrix);
+        mesh.surfaces[0].material.shiny = mf.shiny;
+    }
+    return ret;
+}
+
+static
+CameraParams
+cCameraParams(Meshes const & meshes,Pose const & pose)
+{
+    Mat32F              bounds = cBounds(meshes);
+    CameraParams        ret(fgF2D(bounds));
+    ret.pose =
+        cRotateY(pose.panRadians) *
+        cRotateX(pose.tiltRadians) *
+        cRotateZ(pose.rollRadians);
+    ret.relTrans = pose.relTrans;
+    ret.logRelScale = std::log(pose.relScale);
+    ret.fovMaxDeg = pose.fovMaxDeg;
+    return ret;
+}
+
+static
+String
+toAbsolutePath(String const & path)
+{
+    if (Path(path).root)
+        return path;
+    return getCurrentDir().m_str + path;
+}
+
+// Renders can take much longer than the default client timeout:
+static uint const   renderTimeoutSecs = 300;
+
+// Returns false if unable to connect to the server:
+static
+bool
+requestRender(String const & hostname,uint16 port,RenderRequest const & request,RenderResponse & response)
+{
+    String              reply;
+    if (!fgTcpClient(hostname,port,fgSerializePort(request),true,reply,renderTimeoutSecs))
+        return false;
+    if (reply.empty())
+        fgThrow("Render server closed connection without response",hostname);
+    fgDeserializePort(reply,response);
+    return true;
+}
+
+static
+ImgC4UC
+renderRemote(String const & hostname,uint16 port,RenderArgs const & args)
+{
+    RenderRequest       request;
+    RenderResponse      response;
+    request.args = args;
+    request.optionsExt = RenderOptionsExt(args.options);
+    if (!requestRender(hostname,port,request,response))
+        fgThrow("Unable to connect to render server",hostname+":"+toStr(port));
+    if (!response.error.empty())
+        fgThrow("Render server error",response.error);
+    return imgDecode(response.png);
+}
+
+static
+bool
+isLoopback(String const & ipAddr)
+{return (beginsWith(ipAddr,"127.") || (ipAddr == "::1") || beginsWith(ipAddr,"::ffff:127.")); }
+
+static
+void
+serveRenders(
+    uint16              port,
+    uint                maxConcurrent,
+    bool                publicListen,
+    RenderCache &       cache,
+    FgFuncTcpListening const & listening)
+{
+    // Divide the hardware threads between concurrent renders to avoid oversubscription:
+    uint                threadsPerRender = cMax(cNumThreads(0)/maxConcurrent,1U);
+    auto                handler = [&](String const & ipAddr,String const & data,String & reply) -> bool
+    {
+        RenderRequest       request;
+        RenderResponse      response;
+        // Avoid boost vector append bug (see fgCmdRender):
+        request.args.options.lighting.lights.clear();
+        fgDeserializePort(data,request);
+        if (request.stopServer) {
+            bool                local = isLoopback(ipAddr);
+            if (!local)
+                response.error = "Render server can only be stopped from its own host";
+            reply = fgSerializePort(response);
+            return !local;
+        }
+        try {
+            RenderArgs const &  args = request.args;
+            Meshes              meshes = loadModels(args.models,args.pose.rotateToHcs,
+                [&](String const & fn){return cache.mesh(fn); },
+                [&](String const & fn){return cache.image(fn); });
+            Camera              cam = cCameraParams(meshes,args.pose).camera(args.imagePixelSize);
+            RenderOptions       options = args.options;
+            request.optionsExt.apply(options);
+            options.numThreads = threadsPerRender;
+            ImgC4UC             image = renderSoft(args.imagePixelSize,meshes,cam.modelview,cam.itcsToIucs,options);
+            response.png = imgEncodePng(image);
+        }
+        catch (FgException const & e) {
+            response.error = e.no_tr_message();
+        }
+        catch (std::exception const & e) {
+            response.error = e.what();
+        }
+        reply = fgSerializePort(response);
+        return true;
+    };
+    fgTcpServer(port,true,handler,1<<20,maxConcurrent,!publicListen,listening);
+}
+
 /**
    \ingroup Base_Commands
    Command to render a mesh and colour map to an image.
@@ -88,12 +299,14 @@ void
 fgCmdRender(CLArgs const & args)
 {
     Syntax              syntax(args,
-        "<name> [-s <view>] [-l <view>] (<mesh>.tri [<image>.<ext1>])*\n"
+        "<name> [-s <view>] [-l <view>] [-c <host> <port>] (<mesh>.tri [<image>.<ext1>])*\n"
         "    Render specified meshes [with texture images] using default render arguments.\n"
         "    Saves render arguments to <name>.xml and rendered image to <name>.png\n"
         "    -s     - Save the object pose and camera intrinsics in <view>_pose.xml and <view>_cam.xml\n"
         "    -l     - Load the object pose and camera intrinsics from the above files, "
                      "do not calculate from <name>.xml\n"
+        "    -c     - Render on the given render server (see 'renderd') rather than locally.\n"
+        "             The mesh and image files must be accessible to the server by the same path.\n"
         "    <ext1> - " + imgFileExtensionsDescription() + "\n"
         "NOTES:\n"
         "    - If no mesh arguments are given, <name>.xml will be used for the arguments.\n"
@@ -125,16 +338,24 @@ fgCmdRender(CLArgs const & args)
     string              renderName = syntax.next();
     Options             opts;
     string              viewSave,    // If empty, option not selected
-                        viewLoad;    // "
+                        viewLoad,    // "
+                        serverHost;  // "
+    uint16              serverPort = 0;
     while (syntax.more() && (syntax.peekNext()[0] == '-')) {
         string      arg = syntax.next();
         if (arg == "-s")
             viewSave = syntax.next();
         else if (arg == "-l")
             viewLoad = syntax.next();
+        else if (arg == "-c") {
+            serverHost = syntax.next();
+            serverPort = syntax.nextAs<uint16>();
+        }
         else
             syntax.error("Unrecognized option",arg);
     }
+    if (!serverHost.empty() && !(viewSave.empty() && viewLoad.empty()))
+        syntax.error("-c cannot be used with -s or -l");
     if (syntax.more()) {
         while (syntax.more()) {
             //! Set up the default render options from the arguments:
@@ -156,29 +377,28 @@ fgCmdRender(CLArgs const & args)
             fgThrow("rotateToHcs: quaternion cannot be zero magnitude");
     }
 
-    //! Load data from files:
-    Meshes              meshes(opts.rend.models.size());
-    Mat33F              rotMatrix = Mat33F(opts.rend.pose.rotateToHcs.asMatrix());
-    for (size_t ii=0; ii<meshes.size(); ++ii) {
-        const ModelFiles &  mf = opts.rend.models[ii];
-        Mesh &              mesh = meshes[ii];
-        mesh = loadTri(mf.triFilename);
-        if (!mf.imgFilename.empty())
-            loadImage_(Ustring(mf.imgFilename),mesh.surfaces[0].albedoMapRef());
-        mesh.transform(rotMatrix);
-        mesh.surfaces[0].material.shiny = mf.shiny;
+    if (!serverHost.empty()) {
+        RenderArgs          args = opts.rend;
+        // The server's working directory is unrelated to ours:
+        for (ModelFiles & mf : args.models) {
+            mf.triFilename = toAbsolutePath(mf.triFilename);
+            if (!mf.imgFilename.empty())
+                mf.imgFilename = toAbsolutePath(mf.imgFilename);
+        }
+        Timer               timer;
+        ImgC4UC             image = renderRemote(serverHost,serverPort,args);
+        fgout << fgnl << "Remote render time: " << timer.read() << "s ";
+        saveImage(Ustring(opts.outputFile),image);
+        return;
     }
 
+    //! Load data from files:
+    Meshes              meshes = loadModels(opts.rend.models,opts.rend.pose.rotateToHcs,
+        [](String const & fn){return std::make_shared<Mesh const>(loadTri(fn)); },
+        [](String const & fn){return std::make_shared<ImgC4UC const>(loadImage(fn)); });
+
     //! Calculate view transforms:
-    Mat32F              bounds = cBounds(meshes);
-    CameraParams        cps(fgF2D(bounds));
-    cps.pose =
-        cRotateY(opts.rend.pose.panRadians) *
-        cRotateX(opts.rend.pose.tiltRadians) *
-        cRotateZ(opts.rend.pose.rollRadians);
-    cps.relTrans = opts.rend.pose.relTrans;
-    cps.logRelScale = std::log(opts.rend.pose.relScale);
-    cps.fovMaxDeg = opts.rend.pose.fovMaxDeg;
+    CameraParams        cps = cCameraParams(meshes,opts.rend.pose);
     Camera              cam;
     SimilarityD         mvm;
     if (!viewLoad.empty()) {
@@ -196,6 +416,7 @@ fgCmdRender(CLArgs const & args)
 
     //! Render:
     opts.rend.options.projSurfPoints = std::make_shared<ProjectedSurfPoints>();    // Receive surf point projection data
+    opts.rend.options.numThreads = 0;       // A single render so use all cores
     Timer               timer;
     ImgC4UC             image = renderSoft(opts.rend.imagePixelSize,meshes,mvm,cam.itcsToIucs,opts.rend.options);
     fgout << fgnl << "Render time: " << timer.read() << "s ";
@@ -213,6 +434,49 @@ Cmd
 getRenderCmd()
 {return Cmd(fgCmdRender,"render","Render TRI files with optional texture images to an image file"); }
 
+void
+fgCmdRenderServer(CLArgs const & args)
+{
+    Syntax              syntax(args,
+        "<port> [-t <concurrent>] [-m <cacheMB>] [-p]\n"
+        "    Serve render requests from 'render -c' until stopped.\n"
+        "    <port> - 0 to use any free port, which is printed once listening.\n"
+        "    -t     - Maximum number of renders in progress at once (default 2).\n"
+        "    -m     - Memory budget in MB for each of the loaded mesh and image caches (default 1024).\n"
+        "    -p     - Listen on all network interfaces rather than only for clients on this host.\n"
+        "NOTES:\n"
+        "    - Meshes and images are reloaded if their last write time changes.\n"
+        "    - With -p any host that can reach the port can render any file the server can read."
+    );
+    uint16              port = syntax.nextAs<uint16>();
+    uint                maxConcurrent = 2;
+    size_t              cacheMB = 1024;
+    bool                publicListen = false;
+    while (syntax.more()) {
+        string      arg = syntax.next();
+        if (arg == "-t")
+            maxConcurrent = syntax.nextAs<uint>();
+        else if (arg == "-m")
+            cacheMB = syntax.nextAs<size_t>();
+        else if (arg == "-p")
+            publicListen = true;
+        else
+            syntax.error("Unrecognized option",arg);
+    }
+    if (maxConcurrent == 0)
+        syntax.error("-t must be at least 1");
+    RenderCache         cache(cacheMB << 20);
+    serveRenders(port,maxConcurrent,publicListen,cache,[&](uint16 listenPort)
+    {
+        fgout << fgnl << "Render server listening on " << (publicListen ? "all interfaces" : "loopback")
+            << " port " << listenPort << std::flush;
+    });
+}
+
+Cmd
+getRenderServerCmd()
+{return Cmd(fgCmdRenderServer,"renderd","Render server accepting requests from 'render -c'"); }
+
 static
 bool
 imgApproxEqual(Ustring const & file0,Ustring const & file1)
@@ -247,4 +511,79 @@ fgCmdRenderTest(CLArgs const & args)
     }
 }
 
+void
+fgCmdRenderServerTest(CLArgs const & args)
+{
+    FGTESTDIR
+    fgTestCopy("base/Jane.tri");
+    fgTestCopy("base/Jane.jpg");
+    // Use a free port so concurrent test runs don't collide:
+    std::atomic<uint16> port {0};
+    RenderCache         cache(size_t(1) << 28);
+    std::atomic<bool>   serverFailed {false};
+    std::thread         server([&]()
+    {
+        try {serveRenders(0,2,false,cache,[&](uint16 p){port = p; }); }
+        catch (...) {serverFailed = true; }
+    });
+    ScopeGuard          stopServer([&]()
+    {
+        RenderRequest       request;
+        RenderResponse      response;
+        request.stopServer = true;
+        bool                stopped = false;
+        if (port != 0) {
+            try {stopped = requestRender("127.0.0.1",port,request,response); }
+            catch (...) {}
+        }
+        if (stopped || serverFailed)
+            server.join();
+        else
+            server.detach();
+    });
+    RenderArgs          rendArgs;
+    rendArgs.imagePixelSize = Vec2UI(120,160);
+    rendArgs.pose.panRadians = degToRad(55.0f);
+    ModelFiles          mf;
+    mf.triFilename = toAbsolutePath("Jane.tri");
+    mf.imgFilename = toAbsolutePath("Jane.jpg");
+    rendArgs.models.push_back(mf);
+    RenderRequest       request;
+    RenderResponse      response;
+    request.args = rendArgs;
+    // The server thread may not be listening yet:
+    for (uint ii=0; port == 0; ++ii) {
+        if ((ii == 50) || serverFailed)
+            fgThrow("Test render server failed to start");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    FGASSERT(requestRender("127.0.0.1",port,request,response));
+    FGASSERT(response.error.empty());
+    Meshes              meshes = loadModels(rendArgs.models,rendArgs.pose.rotateToHcs,
+        [](String const & fn){return std::make_shared<Mesh const>(loadTri(fn)); },
+        [](String const & fn){return std::make_shared<ImgC4UC const>(loadImage(fn)); });
+    Camera              cam = cCameraParams(meshes,rendArgs.pose).camera(rendArgs.imagePixelSize);
+    ImgC4UC             local = renderSoft(rendArgs.imagePixelSize,meshes,cam.modelview,cam.itcsToIucs,rendArgs.options);
+    FGASSERT(fgImgApproxEqual(imgDecode(response.png),local,2));
+    // Concurrent repeat requests must all be served from the cache:
+    Svec<ImgC4UC>       images(4);
+    parallelFor(images.size(),[&](size_t ii){images[ii] = renderRemote("127.0.0.1",port,rendArgs); },4);
+    for (ImgC4UC const & img : images)
+        FGASSERT(fgImgApproxEqual(img,local,2));
+    auto                meshStats = cache.meshes.stats();
+    auto                imageStats = cache.images.stats();
+    FGASSERT((meshStats.misses == 1) && (meshStats.hits == images.size()));
+    FGASSERT((imageStats.misses == 1) && (imageStats.hits == images.size()));
+    // Errors are returned to the client rather than stopping the server:
+    request.args.models[0].triFilename = toAbsolutePath("NotThere.tri");
+    FGASSERT(requestRender("127.0.0.1",port,request,response));
+    FGASSERT(!response.error.empty());
+    // Options outside the RenderOptions serialization must be honoured. A ray budget of one per pixel
+    // gives a visibly different image:
+    rendArgs.options.maxRays = rendArgs.imagePixelSize.cmpntsProduct();
+    ImgC4UC             budget = renderSoft(rendArgs.imagePixelSize,meshes,cam.modelview,cam.itcsToIucs,rendArgs.options);
+    FGASSERT(!fgImgApproxEqual(budget,local,2));
+    FGASSERT(renderRemote("127.0.0.1",port,rendArgs) == budget);
+}
+
 }
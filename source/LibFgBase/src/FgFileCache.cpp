@@ -0,0 +1,204 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgFileCache.hpp"
+#include "Fg3dMeshIo.hpp"
+#include "FgImageIo.hpp"
+#include "FgFileSystem.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+FileKey
+cFileKey(Ustring const & fname,bool hashContents)
+{
+    FileKey             ret {fname,getFileSize(fname),getLastWriteTime(fname),0};
+    if (hashContents) {
+        // FNV-1a applied to little-endian 64-bit words rather than bytes, for speed:
+        MappedFile          file(fname);
+        uchar const *       data = file.data();
+        size_t              numWords = file.size() / 8;
+        uint64              hash = 14695981039346656037ULL;
+        for (size_t ii=0; ii<numWords; ++ii) {
+            uint64              word;
+            memcpy(&word,data+ii*8,8);
+            hash = (hash ^ word) * 1099511628211ULL;
+        }
+        for (size_t ii=numWords*8; ii<file.size(); ++ii)
+            hash = (hash ^ data[ii]) * 1099511628211ULL;
+        ret.size = file.size();
+        ret.contentHash = (hash == 0) ? 1 : hash;
+    }
+    return ret;
+}
+
+size_t
+cMeshBytes(Mesh const & mesh)
+{
+    size_t          ret = sizeof(Vec3F)*mesh.verts.size() + sizeof(Vec2F)*mesh.uvs.size();
+    for (Surf const & surf : mesh.surfaces) {
+        ret += sizeof(Vec3UI)*(surf.tris.posInds.size()+surf.tris.uvInds.size()) +
+            sizeof(Vec4UI)*(surf.quads.posInds.size()+surf.quads.uvInds.size());
+        for (auto const & map : {surf.material.albedoMap,surf.material.specularMap})
+            if (map)
+                ret += cImageBytes(*map);
+    }
+    for (Morph const & morph : mesh.deltaMorphs)
+        ret += sizeof(Vec3F)*morph.verts.size();
+    for (IndexedMorph const & morph : mesh.targetMorphs)
+        ret += (sizeof(uint)+sizeof(Vec3F))*morph.verts.size();
+    return ret;
+}
+
+namespace {
+
+size_t const            defaultBudget = size_t(512) << 20;
+
+atomic<bool>            hashContentsFlag {false};
+
+LruCache<FileKey,Mesh> &
+meshCache()
+{
+    static LruCache<FileKey,Mesh>       cache(defaultBudget,cMeshBytes);
+    return cache;
+}
+
+LruCache<FileKey,ImgC4UC> &
+imageCache()
+{
+    static LruCache<FileKey,ImgC4UC>    cache(defaultBudget,cImageBytes);
+    return cache;
+}
+
+}
+
+Sptr<Mesh const>
+loadMeshCached(Ustring const & fname)
+{
+    return meshCache().get(cFileKey(fname,hashContentsFlag),
+        [](FileKey const & key){return make_shared<Mesh const>(loadMesh(key.path)); });
+}
+
+Sptr<ImgC4UC const>
+loadImageCached(Ustring const & fname)
+{
+    return imageCache().get(cFileKey(fname,hashContentsFlag),
+        [](FileKey const & key){return make_shared<ImgC4UC const>(loadImage(key.path)); });
+}
+
+void
+setLoadCacheBudget(size_t maxBytesEach)
+{
+    meshCache().setMaxBytes(maxBytesEach);
+    imageCache().setMaxBytes(maxBytesEach);
+}
+
+void
+setLoadCacheHashing(bool hashContents)
+{hashContentsFlag = hashContents; }
+
+LoadCacheStats
+loadCacheStats()
+{return LoadCacheStats {meshCache().stats(),imageCache().stats()}; }
+
+void
+clearLoadCaches()
+{
+    meshCache().clear();
+    imageCache().clear();
+}
+
+void
+testLoadCache(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    clearLoadCaches();
+    fileCopy(dd+"Mouth.tri","cache.tri",true);
+    Sptr<Mesh const>    m0 = loadMeshCached("cache.tri"),
+                        m1 = loadMeshCached("cache.tri");
+    FGASSERT(m0 == m1);
+    FGASSERT(m0->verts == loadTri(dd+"Mouth.tri").verts);
+    LoadCacheStats      stats = loadCacheStats();
+    FGASSERT((stats.meshes.hits == 1) && (stats.meshes.misses == 1) && (stats.meshes.numEntries == 1));
+    // A change of size is always detected:
+    fileCopy(dd+"Glasses.tri","cache.tri",true);
+    Sptr<Mesh const>    m2 = loadMeshCached("cache.tri");
+    FGASSERT(m2 != m0);
+    FGASSERT(m2->verts == loadTri(dd+"Glasses.tri").verts);
+    FGASSERT(m0->verts == loadTri(dd+"Mouth.tri").verts);     // Still valid
+    // A rewrite of the same size (likely within the same second) is detected with hashing:
+    setLoadCacheHashing(true);
+    Mesh                scaled = *m2;
+    saveTri("cache.tri",scaled);
+    uint64              size = getFileSize("cache.tri");
+    Sptr<Mesh const>    m3 = loadMeshCached("cache.tri");
+    scaled.scale(2.0f);
+    saveTri("cache.tri",scaled);
+    FGASSERT(getFileSize("cache.tri") == size);
+    Sptr<Mesh const>    m4 = loadMeshCached("cache.tri");
+    FGASSERT(m4 != m3);
+    FGASSERT(m4->verts == scaled.verts);
+    FGASSERT(loadMeshCached("cache.tri") == m4);
+    setLoadCacheHashing(false);
+    Sptr<ImgC4UC const> i0 = loadImageCached(dd+"Jane.jpg");
+    FGASSERT(loadImageCached(dd+"Jane.jpg") == i0);
+    FGASSERT(*i0 == loadImage(dd+"Jane.jpg"));
+    // The least recently used are evicted to meet the budget but remain valid while referenced:
+    Sptr<ImgC4UC const> i1 = loadImageCached(dd+"Glasses.tga");
+    setLoadCacheBudget(cImageBytes(*i1));
+    FGASSERT(loadCacheStats().images.numEntries == 1);
+    FGASSERT(loadImageCached(dd+"Glasses.tga") == i1);
+    FGASSERT(loadImageCached(dd+"Jane.jpg") != i0);
+    FGASSERT(*i0 == loadImage(dd+"Jane.jpg"));
+    setLoadCacheBudget(defaultBudget);
+    clearLoadCaches();
+}
+
+void
+testmLoadCache(CLArgs const &)
+{
+    Ustring             dd = dataDir() + "base/";
+    clearLoadCaches();
+    for (String fname : {"Jane.tri","Jane.jpg"}) {
+        bool                isMesh = endsWith(fname,".tri");
+        auto                load = [&]()
+        {
+            if (isMesh)
+                loadMeshCached(dd+fname);
+            else
+                loadImageCached(dd+fname);
+        };
+        Timer               timer;
+        load();
+        double              firstMs = double(timer.readMs());
+        size_t const        reps = 100;
+        timer.start();
+        for (size_t ii=0; ii<reps; ++ii)
+            load();
+        double              againMs = double(timer.readMs()) / reps;
+        setLoadCacheHashing(true);
+        load();                             // The key now includes the hash
+        timer.start();
+        for (size_t ii=0; ii<reps; ++ii)
+            load();
+        double              hashMs = double(timer.readMs()) / reps;
+        setLoadCacheHashing(false);
+        fgout << fgnl << fname << " ms: first load " << firstMs << ", cached " << againMs
+            << ", cached with content hash " << hashMs;
+    }
+    clearLoadCaches();
+}
+
+}
+
+// */
@@ -0,0 +1,82 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Process-wide caches of meshes and images loaded from files, keyed by file identity so that
+// reloading an unchanged file does not parse it again
+
+#ifndef FG_FILECACHE_HPP
+#define FG_FILECACHE_HPP
+
+#include "Fg3dMesh.hpp"
+#include "FgImage.hpp"
+#include "FgLruCache.hpp"
+
+namespace Fg {
+
+// Identifies the contents of a file from its metadata. Write times have a resolution of one second
+// so a file rewritten with the same size within that second is only distinguished by 'contentHash':
+struct  FileKey
+{
+    Ustring             path;
+    uint64              size;
+    uint64              writeTime;
+    uint64              contentHash;        // Zero if not computed
+
+    bool
+    operator<(FileKey const & rhs) const
+    {
+        if (path != rhs.path)
+            return (path < rhs.path);
+        return (std::tie(size,writeTime,contentHash) < std::tie(rhs.size,rhs.writeTime,rhs.contentHash));
+    }
+};
+
+// Throws if 'fname' is not a readable file. 'hashContents' requires reading the whole file:
+FileKey
+cFileKey(Ustring const & fname,bool hashContents=false);
+
+// Approximate memory used (bytes):
+size_t
+cMeshBytes(Mesh const & mesh);
+
+inline
+size_t
+cImageBytes(ImgC4UC const & img)
+{return img.numPixels() * sizeof(RgbaUC); }
+
+// As for 'loadMesh' and 'loadImage' respectively, but returning objects shared with any other callers
+// loading the same file contents, from any thread. The filename must include the extension. Objects
+// remain valid after eviction from the cache for as long as they are referenced:
+Sptr<Mesh const>
+loadMeshCached(Ustring const & fname);
+Sptr<ImgC4UC const>
+loadImageCached(Ustring const & fname);
+
+struct  LoadCacheStats
+{
+    LruCacheStats       meshes;
+    LruCacheStats       images;
+};
+
+// Memory budget for each of the mesh and image caches. Defaults to 512MB each:
+void
+setLoadCacheBudget(size_t maxBytesEach);
+
+// Include a hash of the file contents in the key so that rapid rewrites of the same size are
+// detected, at the cost of reading the file on every request. Defaults to false:
+void
+setLoadCacheHashing(bool hashContents);
+
+LoadCacheStats
+loadCacheStats();
+
+void
+clearLoadCaches();
+
+}
+
+#endif
+
+// */
@@ -62,6 +62,16 @@ pathExists(Ustring const & fname)
     return ret;
 }
 
+uint64
+getFileSize(Ustring const & fname)
+{
+    boost::system::error_code   ec;
+    uintmax_t                   ret = boost::filesystem::file_size(fname.ns(),ec);
+    if (ec)
+        fgThrow("Unable to read file size",fname);
+    return uint64(ret);
+}
+
 // TODO: re-write more efficient OS-specific code (utime on Linus, god knows what on Win):
 void
 fileTouch(Ustring const & fname)
@@ -156,6 +166,19 @@ string
 loadRawString(Ustring const & filename)
 {
     Ifstream          ifs(filename);
+    // Read directly into a buffer of the file size rather than copying through a stream buffer,
+    // which matters for large text meshes:
+    ifs.seekg(0,ios::end);
+    streamoff           size = ifs.tellg();
+    if (size >= 0) {
+        string              ret(size_t(size),'\0');
+        ifs.seekg(0,ios::beg);
+        if ((size == 0) || ifs.read(&ret[0],size))
+            return ret;
+    }
+    // Fall back for streams without a known size:
+    ifs.clear();
+    ifs.seekg(0,ios::beg);
     ostringstream       ss;
     ss << ifs.rdbuf();
     return ss.str();
@@ -175,6 +175,34 @@ fileReadable(Ustring const & filename);
 String
 loadRawString(Ustring const & filename);
 
+// Read-only memory mapping of an entire file, which remains valid for the lifetime of the object.
+// Pages are only read from disk when first accessed and are shared with other processes mapping
+// the same file. Throws if the file cannot be opened or mapped:
+class   MappedFile
+{
+public:
+    explicit
+    MappedFile(Ustring const & fname);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &
+    operator=(MappedFile const &) = delete;
+
+    uchar const *
+    data() const
+    {return m_data; }
+
+    size_t
+    size() const
+    {return m_size; }
+
+private:
+    uchar const *       m_data = nullptr;       // Null for an empty file
+    size_t              m_size = 0;
+};
+
 // Setting 'onlyIfChanged' to false will result in the file always being written,
 // regardless of whether the new data may be identical.
 // Leaving 'true' is useful to avoid triggering unwanted change detections.
@@ -215,6 +243,10 @@ uint64      getCreationTime(Ustring const & path);
 uint64
 getLastWriteTime(Ustring const & node);
 
+// Throws if 'fname' is not a regular file:
+uint64
+getFileSize(Ustring const & fname);
+
 // Return true if any of the sources have a 'last write time' newer than any of the sinks,
 // of if any of the sinks don't exist (an error results if any of the sources don't exist):
 bool
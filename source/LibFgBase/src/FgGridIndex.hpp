@@ -13,14 +13,73 @@
 
 namespace Fg {
 
+// 2D array of bins with all values stored contiguously in bin order (compressed sparse row).
+// Built in two passes to avoid a heap allocation per bin: first 'count' the number of values
+// for every bin, then 'allocate', then 'add' the values:
+template<typename T>
+struct  CsrBins
+{
+    Vec2UI          binDims {0};
+    Uints           offsets;        // Bin 'ii' is vals[offsets[ii],offsets[ii+1]) once allocated
+    Svec<T>         vals;
+    Uints           fillPos;        // Next position to fill for each bin during construction
+
+    Vec2UI
+    dims() const
+    {return binDims; }
+
+    size_t
+    numBins() const
+    {return binDims.cmpntsProduct(); }
+
+    // Clears any existing bins:
+    void
+    setup(Vec2UI dims)
+    {
+        binDims = dims;
+        offsets.assign(numBins()+1,0);
+        vals.clear();
+        fillPos.clear();
+    }
+
+    void
+    count(size_t binIdx,uint num=1)
+    {offsets[binIdx+1] += num; }
+
+    void
+    allocate()
+    {
+        for (size_t ii=1; ii<offsets.size(); ++ii)
+            offsets[ii] += offsets[ii-1];
+        vals.resize(offsets.back());
+        fillPos.assign(offsets.begin(),offsets.end()-1);
+    }
+
+    // Values are added to each bin in the order given:
+    void
+    add(size_t binIdx,T const & val)
+    {
+        FGASSERT_FAST(fillPos[binIdx] < offsets[binIdx+1]);
+        vals[fillPos[binIdx]++] = val;
+    }
+
+    ArrayView<T>
+    operator[](size_t binIdx) const
+    {return ArrayView<T>(vals.data()+offsets[binIdx],offsets[binIdx+1]-offsets[binIdx]); }
+
+    ArrayView<T>
+    operator[](Vec2UI binIrcs) const
+    {return operator[](binIrcs[1]*size_t(binDims[0])+binIrcs[0]); }
+};
+
 template<typename T>
 struct  GridIndex
 {
-    AffineEw2F                clientToGridIpcs;
-    Img<Svec<T> >    grid;       // Bins of client objects (bins not exactly square)
-    Svec<T> const   empty;
+    AffineEw2F              clientToGridIpcs;
+    CsrBins<T>              grid;       // Bins of client objects (bins not exactly square)
 
-    // Typically use the number of lookup objects for 'numBins':
+    // Typically use the number of lookup objects for 'numBins'.
+    // Then 'count' all the objects, 'allocate', then 'add' all the objects with the same bounds:
     void
     setup(Mat22F clientBounds,uint approxNumBins)
     {
@@ -33,36 +92,70 @@ struct  GridIndex
         gridSize = clampLo(gridSize,1U);
         Mat22F        ipcsBounds(0,gridSize[0],0,gridSize[1]);
         clientToGridIpcs = AffineEw2F(clientBounds,ipcsBounds);
-        grid.resize(gridSize);
+        grid.setup(gridSize);
     }
 
-    void
-    add(T const & val,Mat22F clientBounds)
+    // Returns the exclusive upper bounds of the bins overlapping the given bounds (possibly empty):
+    Mat22UI
+    binBounds(Mat22F clientBounds) const
     {
         Mat22F        ipcsBounds = clientToGridIpcs * clientBounds;
+        Vec2UI          dims = grid.dims();
+        // Clip to the grid before conversion as projected bounds can be out of integer range:
         ipcsBounds[0] = cMax(ipcsBounds[0],0.0f);
+        ipcsBounds[1] = cMin(ipcsBounds[1],float(dims[0]));
         ipcsBounds[2] = cMax(ipcsBounds[2],0.0f);
+        ipcsBounds[3] = cMin(ipcsBounds[3],float(dims[1]));
         if ((ipcsBounds[0] > ipcsBounds[1]) || (ipcsBounds[2] > ipcsBounds[3]))
-            return;
+            return Mat22UI(0);
         Mat22UI       ircsBounds = Mat22UI(ipcsBounds);         // All elements now guaranteed  positive
-        ircsBounds[1] = cMin(ircsBounds[1]+1,grid.width());        // Convert to exlusive upper bounds (EUB)
-        ircsBounds[3] = cMin(ircsBounds[3]+1,grid.height());       // and clip to grid.
-        for (uint yy=ircsBounds[2]; yy<ircsBounds[3]; ++yy) {      // Invalid bounds implicity skipped
-            for (uint xx=ircsBounds[0]; xx<ircsBounds[1]; ++xx)
-                grid.xy(xx,yy).push_back(val);
-        }
+        ircsBounds[1] = cMin(ircsBounds[1]+1,dims[0]);          // Convert to exlusive upper bounds (EUB)
+        ircsBounds[3] = cMin(ircsBounds[3]+1,dims[1]);          // and clip to grid.
+        return ircsBounds;
     }
 
-    Svec<T> const &
-    operator[](const Vec2F & clientPos) const
+    void
+    count(Mat22F clientBounds)
+    {
+        Mat22UI         bnds = binBounds(clientBounds);
+        for (uint yy=bnds[2]; yy<bnds[3]; ++yy)                 // Invalid bounds implicity skipped
+            for (uint xx=bnds[0]; xx<bnds[1]; ++xx)
+                grid.count(yy*size_t(grid.binDims[0])+xx);
+    }
+
+    void
+    allocate()
+    {grid.allocate(); }
+
+    void
+    add(T const & val,Mat22F clientBounds)
+    {
+        Mat22UI         bnds = binBounds(clientBounds);
+        for (uint yy=bnds[2]; yy<bnds[3]; ++yy)
+            for (uint xx=bnds[0]; xx<bnds[1]; ++xx)
+                grid.add(yy*size_t(grid.binDims[0])+xx,val);
+    }
+
+    // Returns the index of the bin containing the given position, or 'grid.numBins()' if outside the grid.
+    // Useful for looking up other bins of the same dimensions:
+    size_t
+    binIdx(const Vec2F & clientPos) const
     {
         Vec2F        posIpcs = clientToGridIpcs*clientPos;
+        Vec2UI          dims = grid.dims();
         if ((posIpcs[0] < 0.0f) || (posIpcs[1] < 0.0f))
-            return empty;
+            return grid.numBins();
         Vec2UI       posIrcs = Vec2UI(posIpcs);
-        if ((posIrcs[0] < grid.width()) && (posIrcs[1] < grid.height()))
-            return grid[posIrcs];
-        return empty;
+        if ((posIrcs[0] < dims[0]) && (posIrcs[1] < dims[1]))
+            return posIrcs[1]*size_t(dims[0])+posIrcs[0];
+        return grid.numBins();
+    }
+
+    ArrayView<T>
+    operator[](const Vec2F & clientPos) const
+    {
+        size_t          bb = binIdx(clientPos);
+        return (bb < grid.numBins()) ? grid[bb] : ArrayView<T>();
     }
 };
 
@@ -24,7 +24,7 @@ GridTriangles::nearestIntersect(Vec3UIs const & tris,Vec2Fs const & verts,Floats
     if (!isInUpperBounds(grid.dims(),gridCoord))
         return ret;
     Vec2UI           binIdx = Vec2UI(gridCoord);
-    Uints const &     bin = grid[binIdx];
+    ArrayView<uint>     bin = grid[binIdx];
     float               bestInvDepth = 0.0f;
     TriPoint          bestTp;
     for (size_t ii=0; ii<bin.size(); ++ii) {
@@ -58,7 +58,7 @@ GridTriangles::intersects_(Vec3UIs const & tris,Vec2Fs const & verts,Vec2F pos,v
     if (!isInUpperBounds(grid.dims(),gridCoord))
         return;
     Vec2UI           binIdx = Vec2UI(gridCoord);
-    Uints const &     bin = grid[binIdx];
+    ArrayView<uint>     bin = grid[binIdx];
     for (size_t ii=0; ii<bin.size(); ++ii) {
         TriPoint      tp;
         tp.triInd = bin[ii];
@@ -108,9 +108,11 @@ gridTriangles(Vec2Fs const & verts,Vec3UIs const & tris,float binsPerTri)
     // this optimization currently represents an unlikely case; we usually want to fit what we're
     // rendering on the image. This would change for more general-purpose ray casting.
     ret.clientToGridIpcs = AffineEw2F(catHoriz(domainLo,domainHi),range);
-    ret.grid.resize(rangeSize);
-    for (size_t ii=0; ii<tris.size(); ++ii) {
-        Vec3UI       tri = tris[ii];
+    ret.grid.setup(rangeSize);
+    // Returns false if the tri is not indexed:
+    auto                binBounds = [&](size_t triIdx,Mat22UI & bnds)
+    {
+        Vec3UI       tri = tris[triIdx];
         Vec2F        p0 = verts[tri[0]],
                         p1 = verts[tri[1]],
                         p2 = verts[tri[2]];
@@ -120,12 +122,22 @@ gridTriangles(Vec2Fs const & verts,Vec3UIs const & tris,float binsPerTri)
                 ret.clientToGridIpcs * p1,
                 ret.clientToGridIpcs * p2));
             if (boundsIntersect(projBounds,range,projBounds)) {
-                Mat22UI       bnds = Mat22UI(projBounds);
-                for (Iter2UI it(bnds); it.valid(); it.next())
-                    ret.grid[it()].push_back(uint(ii));
+                bnds = Mat22UI(projBounds);
+                return true;
             }
         }
-    }
+        return false;
+    };
+    Mat22UI             bnds;
+    for (size_t ii=0; ii<tris.size(); ++ii)
+        if (binBounds(ii,bnds))
+            for (Iter2UI it(bnds); it.valid(); it.next())
+                ret.grid.count(it()[1]*size_t(rangeSize[0])+it()[0]);
+    ret.grid.allocate();
+    for (size_t ii=0; ii<tris.size(); ++ii)
+        if (binBounds(ii,bnds))
+            for (Iter2UI it(bnds); it.valid(); it.next())
+                ret.grid.add(it()[1]*size_t(rangeSize[0])+it()[0],uint(ii));
     return ret;
 }
 
@@ -10,6 +10,7 @@
 
 #include "FgImage.hpp"
 #include "FgAffineCwC.hpp"
+#include "FgGridIndex.hpp"
 
 namespace Fg {
 
@@ -27,7 +28,7 @@ typedef Svec<TriPoint>      TriPoints;
 struct  GridTriangles
 {
     AffineEw2F              clientToGridIpcs;
-    Img<Uints>              grid;               // Bins of indices into client triangle array
+    CsrBins<uint>           grid;               // Bins of indices into client triangle array
 
     Opt<TriPoint>
     nearestIntersect(
@@ -79,6 +79,22 @@ imgEncodeJpeg(ImgC4UC const & img,int quality=100);
 ImgC4UC
 imgDecodeJpeg(Uchars const & jfifBlob);
 
+// Encode to PNG format blob (can be dumped to .png file):
+Uchars
+imgEncodePng(ImgC4UC const & img);
+
+// Decode from a blob in any supported file format:
+ImgC4UC
+imgDecode(Uchars const & blob);
+
+// Zlib (deflate) format as used within PNG, for compressing other binary data:
+Uchars
+zlibCompress(uchar const * data,size_t size);
+
+// Throws unless the data decompresses to exactly 'dstSize' bytes:
+void
+zlibDecompress(uchar const * src,size_t srcSize,uchar * dst,size_t dstSize);
+
 }
 
 #endif
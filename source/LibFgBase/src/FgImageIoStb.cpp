@@ -91,6 +91,72 @@ saveImage(Ustring const & fname,ImgC4UC const & img)
         fgThrow("STB image write error",fname);
 }
 
+static
+void
+writeToUchars(void *context,void * data,int size)
+{
+    Uchars &            blob = *reinterpret_cast<Uchars*>(context);
+    uchar const *       ptr = reinterpret_cast<uchar const*>(data);
+    blob.insert(blob.end(),ptr,ptr+size);
+}
+
+Uchars
+imgEncodePng(ImgC4UC const & img)
+{
+    if (img.numPixels() == 0)
+        fgThrow("Cannot encode empty image");
+    uint                wid = img.width(),
+                        hgt = img.height();
+    uchar const *       data = &img.m_data[0].m_c[0];
+    Uchars              ret;
+    if (stbi_write_png_to_func(writeToUchars,&ret,wid,hgt,4,data,wid*4) == 0)
+        fgThrow("STB PNG encode error");
+    return ret;
+}
+
+ImgC4UC
+imgDecode(Uchars const & blob)
+{
+    int                 width,height,channels;
+    if (blob.empty())
+        fgThrow("Unable to decode empty image blob");
+    uchar *             data = stbi_load_from_memory(blob.data(),int(blob.size()),&width,&height,&channels,4);
+    if (data == nullptr) {
+        string          reason(stbi__g_failure_reason);
+        fgThrow("Unable to decode image blob",reason);
+    }
+    StbiFree            sf(data);
+    if (width*height <= 0)
+        fgThrow("Invalid image dimensions",Vec2I(width,height));
+    return ImgC4UC{Vec2UI(width,height),reinterpret_cast<RgbaUC*>(data)};
+}
+
+Uchars
+zlibCompress(uchar const * data,size_t size)
+{
+    FGASSERT(size < size_t(numeric_limits<int>::max()));
+    int                 len = 0;
+    // Only reads the input despite the non-const signature:
+    uchar *             buf = stbi_zlib_compress(const_cast<uchar*>(data),int(size),&len,stbi_write_png_compression_level);
+    if (buf == nullptr)
+        fgThrow("STB zlib compress error");
+    Uchars              ret(buf,buf+len);
+    STBIW_FREE(buf);
+    return ret;
+}
+
+void
+zlibDecompress(uchar const * src,size_t srcSize,uchar * dst,size_t dstSize)
+{
+    FGASSERT((srcSize < size_t(numeric_limits<int>::max())) && (dstSize < size_t(numeric_limits<int>::max())));
+    if (dstSize == 0)
+        return;
+    int                 len = stbi_zlib_decode_buffer(reinterpret_cast<char*>(dst),int(dstSize),
+                            reinterpret_cast<char const*>(src),int(srcSize));
+    if (len != int(dstSize))
+        fgThrow("Zlib data is corrupt or of unexpected size",toStr(len)+" != "+toStr(dstSize));
+}
+
 void
 saveJfif(ImgC4UC const & img,Ustring const & fname,uint quality)
 {
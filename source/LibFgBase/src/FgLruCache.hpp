@@ -0,0 +1,124 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Thread-safe least recently used cache of immutable shared values with a memory budget
+
+#ifndef FG_LRUCACHE_HPP
+#define FG_LRUCACHE_HPP
+
+#include "FgStdExtensions.hpp"
+#include "FgTypes.hpp"
+#include <list>
+
+namespace Fg {
+
+struct  LruCacheStats
+{
+    size_t          hits = 0;
+    size_t          misses = 0;
+    size_t          numEntries = 0;
+    size_t          bytes = 0;
+};
+
+template<class Key,class Val>
+class   LruCache
+{
+public:
+    typedef Sfun<Sptr<Val const>(Key const &)>  Loader;
+    typedef Sfun<size_t(Val const &)>           Sizer;      // Approximate memory used by a value (bytes)
+    typedef LruCacheStats                       Stats;
+
+    LruCache(size_t maxBytes,Sizer const & sizer) : m_maxBytes(maxBytes), m_sizer(sizer) {}
+
+    // Loading is done outside the lock so a slow load does not block access to other entries.
+    // If two threads miss on the same key at once both will load it and the first one stored is kept.
+    // Values are never modified once loaded and remain valid for callers after eviction:
+    Sptr<Val const>
+    get(Key const & key,Loader const & loader)
+    {
+        {
+            std::lock_guard<std::mutex>     lock(m_mutex);
+            auto                            it = m_entries.find(key);
+            if (it != m_entries.end()) {
+                ++m_stats.hits;
+                m_order.splice(m_order.begin(),m_order,it->second.orderIt);
+                return it->second.val;
+            }
+            ++m_stats.misses;
+        }
+        Sptr<Val const>     val = loader(key);
+        FGASSERT(val);
+        size_t              bytes = m_sizer(*val);
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        auto                it = m_entries.find(key);
+        if (it != m_entries.end())
+            return it->second.val;
+        m_order.push_front(key);
+        m_entries[key] = Entry {val,bytes,m_order.begin()};
+        m_stats.bytes += bytes;
+        evict();
+        return val;
+    }
+
+    void
+    setMaxBytes(size_t maxBytes)
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        m_maxBytes = maxBytes;
+        evict();
+    }
+
+    Stats
+    stats() const
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        return m_stats;
+    }
+
+    void
+    clear()
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        m_entries.clear();
+        m_order.clear();
+        m_stats.numEntries = 0;
+        m_stats.bytes = 0;
+    }
+
+private:
+    typedef typename std::list<Key>::iterator   OrderIt;
+    struct  Entry
+    {
+        Sptr<Val const>     val;
+        size_t              bytes;
+        OrderIt             orderIt;
+    };
+    size_t                  m_maxBytes;
+    Sizer                   m_sizer;
+    mutable std::mutex      m_mutex;
+    std::list<Key>          m_order;        // Most recently used first
+    std::map<Key,Entry>     m_entries;
+    Stats                   m_stats;
+
+    // Must be called with the lock held. Always keeps the most recent entry even if it alone exceeds
+    // the budget:
+    void
+    evict()
+    {
+        while ((m_stats.bytes > m_maxBytes) && (m_order.size() > 1)) {
+            auto            lru = m_entries.find(m_order.back());
+            m_stats.bytes -= lru->second.bytes;
+            m_entries.erase(lru);
+            m_order.pop_back();
+        }
+        m_stats.numEntries = m_entries.size();
+    }
+};
+
+}
+
+#endif
+
+// */
@@ -19,6 +19,10 @@ namespace Fg {
 // Keep this here to avoid excess header dependencies:
 static Ofstream   s_ofs;
 
+// The capture stream and its indent for the current thread, if any:
+static thread_local ostream *   s_capture = nullptr;
+static thread_local size_t      s_captureIndent = 0;
+
 // Only this single global instance should ever be instantiated.
 // Note that 'fgout' can't be used in global variable constructors since it's
 // not guaranteed to be constructed yet itself:
@@ -134,7 +138,22 @@ FgOut::flush()
 FgOut &
 FgOut::operator<<(std::ostream& (*manip)(std::ostream&))
 {
-    if (notMute())
+    if (notMute() && s_capture) {
+        if (manip == fgpush)
+            ++s_captureIndent;
+        else if (manip == fgpop) {
+            if (s_captureIndent > 0)
+                --s_captureIndent;
+        }
+        else if (manip == fgnl) {
+            (*s_capture) << '\n';
+            for (size_t ii=0; ii<s_captureIndent; ii++)
+                (*s_capture) << "|   ";
+        }
+        else
+            (*s_capture) << manip;
+    }
+    else if (notMute())
     {
         // Handle the case of fgpush and fgpop explicitly since otherwise they
         // may be passed on to both streams and double called resulting in twice
@@ -163,6 +182,38 @@ FgOut::operator<<(std::ostream& (*manip)(std::ostream&))
     return *this;
 }
 
+void
+FgOut::writeCaptured(string const & text)
+{
+    size_t              beg = 0;
+    while (beg < text.size()) {
+        size_t              end = text.find('\n',beg);
+        if (end == string::npos)
+            end = text.size();
+        if (end > beg)
+            *this << text.substr(beg,end-beg);
+        if (end < text.size())
+            *this << fgnl;
+        beg = end + 1;
+    }
+}
+
+std::ostream *
+FgOut::threadCapture()
+{return s_capture; }
+
+FgOutCapture::FgOutCapture(ostream & os) : m_prev(s_capture), m_prevIndent(s_captureIndent)
+{
+    s_capture = &os;
+    s_captureIndent = 0;
+}
+
+FgOutCapture::~FgOutCapture()
+{
+    s_capture = m_prev;
+    s_captureIndent = m_prevIndent;
+}
+
 std::ostream *
 FgOut::defOut()
 {
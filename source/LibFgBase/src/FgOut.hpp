@@ -4,7 +4,7 @@
 // see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
 //
 // Global multi-redirectable pretty-print output stream for diagnostic feedback.
-// Not threadsafe so use ostringstream output option for threads.
+// Not threadsafe so use ostringstream output option or FgOutCapture for threads.
 // Default output is 'cout' for systems supporting CLI, 'stringstream' otherwise (Android).
 //
 // USE:
@@ -99,9 +99,14 @@ struct  FgOut
     FgOut &
     operator<<(T const & arg)
     {
-        if (notMute())
-            for (OStr & ostr : m_streams)
-                (*ostr.pOStr) << arg;
+        if (notMute()) {
+            std::ostream *      capture = threadCapture();
+            if (capture)
+                (*capture) << arg;
+            else
+                for (OStr & ostr : m_streams)
+                    (*ostr.pOStr) << arg;
+        }
         return *this;
     }
     
@@ -112,6 +117,10 @@ struct  FgOut
     getStringStream() const
     {return m_stringStream.str() + "\n"; }
 
+    // Output text captured by 'FgOutCapture', at the current indent:
+    void
+    writeCaptured(std::string const & text);
+
 private:
     struct  OStr
     {
@@ -131,10 +140,30 @@ private:
 
     std::ostream *
     defOut();
+
+    static std::ostream *
+    threadCapture();
 };
 
 extern FgOut      fgout;
 
+// Redirects 'fgout' output from the current thread only while in scope, so that tasks run
+// concurrently don't interleave their output. Replay with 'fgout.writeCaptured' from one thread:
+struct  FgOutCapture
+{
+    explicit
+    FgOutCapture(std::ostream & os);
+
+    ~FgOutCapture();
+
+    FgOutCapture(FgOutCapture const &) = delete;
+    FgOutCapture & operator=(FgOutCapture const &) = delete;
+
+private:
+    std::ostream *      m_prev;
+    size_t              m_prevIndent;
+};
+
 struct  FgOutMute
 {
     bool        m_mute;
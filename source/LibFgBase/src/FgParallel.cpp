@@ -0,0 +1,61 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgParallel.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+uint
+cNumThreads(uint numThreads)
+{
+    if (numThreads > 0)
+        return numThreads;
+    return max(thread::hardware_concurrency(),1U);      // Can return 0 if not computable
+}
+
+void
+parallelFor(size_t num,Sfun<void(size_t)> const & fn,uint numThreads)
+{
+    if (num == 0)
+        return;
+    size_t              nt = min(size_t(cNumThreads(numThreads)),num);
+    atomic<size_t>      next {0};
+    mutex               errorMutex;
+    exception_ptr       error;
+    auto                worker = [&]()
+    {
+        try {
+            for (size_t ii=next++; ii<num; ii=next++)
+                fn(ii);
+        }
+        catch (...) {
+            lock_guard<mutex>   lock(errorMutex);
+            if (!error)
+                error = current_exception();
+            next = num;             // Stop the other threads
+        }
+    };
+    if (nt == 1)
+        worker();
+    else {
+        vector<thread>      threads;
+        threads.reserve(nt);
+        for (size_t tt=0; tt<nt; ++tt)
+            threads.push_back(thread{worker});
+        for (thread & thread : threads)
+            thread.join();
+    }
+    if (error)
+        rethrow_exception(error);
+}
+
+}
+
+// */
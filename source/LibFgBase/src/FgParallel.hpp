@@ -0,0 +1,31 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Simple fork-join parallelism over index ranges using std::thread
+
+#ifndef FG_PARALLEL_HPP
+#define FG_PARALLEL_HPP
+
+#include "FgStdExtensions.hpp"
+#include "FgTypes.hpp"
+
+namespace Fg {
+
+// Returns 'numThreads' if non-zero, otherwise the number of hardware threads (at least 1):
+uint
+cNumThreads(uint numThreads);
+
+// Calls 'fn' once for each index in [0,num) using up to 'numThreads' threads (0 - all hardware threads).
+// Indices are handed out dynamically in increasing order so uneven work loads are balanced.
+// If 'fn' throws, remaining indices are skipped and the first exception is rethrown in the calling thread.
+// Runs in the calling thread if only one thread is needed:
+void
+parallelFor(size_t num,Sfun<void(size_t)> const & fn,uint numThreads=0);
+
+}
+
+#endif
+
+// */
@@ -0,0 +1,293 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgRasterizer.hpp"
+#include "FgParallel.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+struct  RasterTri
+{
+    TriInd          triInd;
+    Vec3F           invDepths;
+    // Barycentric coordinate i at IUCS point (x,y) is bcA[i]*x + bcB[i]*y + bcC[i]. These are the
+    // normalized edge functions so they are valid for either winding:
+    Vec3D           bcA,bcB,bcC;
+    Mat22D          boundsIucs;
+};
+
+// Tris binned into image tiles:
+struct  RasterSetup
+{
+    Vec2UI              dims;
+    uint                samplesDim;
+    Svec<RasterTri>     rtris;
+    Img<Uints>          tileTris;       // Indices into 'rtris' by tile
+    Svec<Mat22UI>       tileBounds;     // Pixel bounds of each tile, upper bounds exclusive
+};
+
+}
+
+static
+RasterSetup
+setupRaster(Vec2UI dims,RayCaster const & rc,uint samplesDim)
+{
+    FGASSERT(dims.cmpntsProduct() > 0);
+    FGASSERT((samplesDim > 0) && (samplesDim <= 8));
+    const uint          tileSize = 32;
+    Vec2UI              numTiles = (dims + Vec2UI(tileSize-1)) / tileSize;
+    Vec2D               dimsD(dims);
+    RasterSetup         ret;
+    ret.dims = dims;
+    ret.samplesDim = samplesDim;
+    ret.tileTris.resize(numTiles);
+    // Set up and bin the tris in mesh, surface, tri order so that equal depth samples are resolved
+    // the same way as the ray caster:
+    for (size_t mm=0; mm<rc.iucsVertss.size(); ++mm) {
+        Vec3Fs const &      iucsVerts = rc.iucsVertss[mm];
+        Triss const &       triss = rc.rcMeshes->trisss[mm];
+        for (size_t ss=0; ss<triss.size(); ++ss) {
+            Vec3UIs const &     posInds = triss[ss].posInds;
+            for (size_t tt=0; tt<posInds.size(); ++tt) {
+                Vec3UI              t = posInds[tt];
+                Vec3F               v[3] = {iucsVerts[t[0]],iucsVerts[t[1]],iucsVerts[t[2]]};
+                if ((v[0][2] <= 0.0f) || (v[1][2] <= 0.0f) || (v[2][2] <= 0.0f))
+                    continue;       // Only render tris fully in front of camera
+                Vec2D               u[3] = {
+                    Vec2D(v[0][0],v[0][1]),
+                    Vec2D(v[1][0],v[1][1]),
+                    Vec2D(v[2][0],v[2][1])};
+                double              area = (u[1][0]-u[0][0])*(u[2][1]-u[0][1]) - (u[1][1]-u[0][1])*(u[2][0]-u[0][0]);
+                if (area == 0.0)
+                    continue;       // Degenerate projection
+                RasterTri           rt;
+                rt.triInd = TriInd(tt,ss,mm);
+                rt.invDepths = Vec3F(v[0][2],v[1][2],v[2][2]);
+                for (uint ii=0; ii<3; ++ii) {
+                    Vec2D               a = u[(ii+1)%3],
+                                        b = u[(ii+2)%3];
+                    rt.bcA[ii] = (a[1]-b[1]) / area;
+                    rt.bcB[ii] = (b[0]-a[0]) / area;
+                    rt.bcC[ii] = (a[0]*b[1] - a[1]*b[0]) / area;
+                }
+                rt.boundsIucs = Mat22D(
+                    cMin(u[0][0],u[1][0],u[2][0]),cMax(u[0][0],u[1][0],u[2][0]),
+                    cMin(u[0][1],u[1][1],u[2][1]),cMax(u[0][1],u[1][1],u[2][1]));
+                Vec2I               lo,hi;              // Inclusive tile bounds
+                bool                inView = true;
+                for (uint dd=0; dd<2; ++dd) {
+                    double              pxLo = rt.boundsIucs.rc(dd,0) * dimsD[dd],
+                                        pxHi = rt.boundsIucs.rc(dd,1) * dimsD[dd];
+                    if ((pxHi < 0.0) || (pxLo >= dimsD[dd]))
+                        inView = false;
+                    else {
+                        lo[dd] = int(cMax(pxLo,0.0)) / int(tileSize);
+                        hi[dd] = int(cMin(pxHi,dimsD[dd]-1.0)) / int(tileSize);
+                    }
+                }
+                if (!inView)
+                    continue;
+                uint                idx = uint(ret.rtris.size());
+                ret.rtris.push_back(rt);
+                for (int yy=lo[1]; yy<=hi[1]; ++yy)
+                    for (int xx=lo[0]; xx<=hi[0]; ++xx)
+                        ret.tileTris.xy(xx,yy).push_back(idx);
+            }
+        }
+    }
+    for (uint yy=0; yy<numTiles[1]; ++yy)
+        for (uint xx=0; xx<numTiles[0]; ++xx)
+            ret.tileBounds.push_back(Mat22UI(
+                xx*tileSize,cMin((xx+1)*tileSize,dims[0]),
+                yy*tileSize,cMin((yy+1)*tileSize,dims[1])));
+    return ret;
+}
+
+// Returns the closest intersects of each sample of tile 'tt', row-major within the tile:
+static
+Svec<RayCaster::Intersects>
+rasterTile(RasterSetup const & rs,size_t tt)
+{
+    Mat22UI             bnds = rs.tileBounds[tt];
+    uint                samplesDim = rs.samplesDim;
+    double              sampleToIucsX = 1.0 / (double(rs.dims[0])*samplesDim),
+                        sampleToIucsY = 1.0 / (double(rs.dims[1])*samplesDim);
+    // Global sample index bounds of tile, upper bounds exclusive:
+    int                 s0x = bnds[0]*samplesDim,
+                        s1x = bnds[1]*samplesDim,
+                        s0y = bnds[2]*samplesDim,
+                        s1y = bnds[3]*samplesDim,
+                        wid = s1x - s0x;
+    Svec<RayCaster::Intersects> frags(size_t(wid)*(s1y-s0y));
+    for (uint ri : rs.tileTris[tt]) {
+        RasterTri const &   rt = rs.rtris[ri];
+        // Sample 's' is at IUCS (s+0.5)*sampleToIucs so clip the tri bounds to the sample centres:
+        int                 sx0 = int(cMax(ceil(rt.boundsIucs[0]/sampleToIucsX - 0.5),double(s0x))),
+                            sx1 = int(cMin(floor(rt.boundsIucs[1]/sampleToIucsX - 0.5),double(s1x-1))),
+                            sy0 = int(cMax(ceil(rt.boundsIucs[2]/sampleToIucsY - 0.5),double(s0y))),
+                            sy1 = int(cMin(floor(rt.boundsIucs[3]/sampleToIucsY - 0.5),double(s1y-1)));
+        for (int sy=sy0; sy<=sy1; ++sy) {
+            double              y = (sy + 0.5) * sampleToIucsY;
+            Vec3D               rowC = rt.bcC + rt.bcB * y;
+            RayCaster::Intersects * rowFrags = &frags[size_t(sy-s0y)*wid - s0x];
+            for (int sx=sx0; sx<=sx1; ++sx) {
+                double              x = (sx + 0.5) * sampleToIucsX;
+                Vec3D               bc = rowC + rt.bcA * x;
+                if ((bc[0] >= 0) && (bc[1] >= 0) && (bc[2] >= 0)) {
+                    double              id = bc[0]*rt.invDepths[0] + bc[1]*rt.invDepths[1] + bc[2]*rt.invDepths[2];
+                    rowFrags[sx].update(float(id),RayCaster::Intersect(rt.triInd,bc));
+                }
+            }
+        }
+    }
+    return frags;
+}
+
+// Index of the sample nearest the centre of pixel 'px', row-major within the tile bounds:
+static inline
+size_t
+centreSampleIdx(Mat22UI bnds,uint samplesDim,Vec2UI px)
+{
+    size_t              wid = size_t(bnds[1]-bnds[0]) * samplesDim;
+    return size_t((px[1]-bnds[2])*samplesDim + samplesDim/2)*wid + (px[0]-bnds[0])*samplesDim + samplesDim/2;
+}
+
+// Box filter the shaded samples of the pixels in 'bnds' into 'img'. 'shadeSample' takes the sample
+// index row-major within the bounds:
+template<class Fn>
+static
+void
+filterTile(Mat22UI bnds,uint samplesDim,Fn const & shadeSample,ImgC4UC & img)
+{
+    size_t              wid = size_t(bnds[1]-bnds[0]) * samplesDim;
+    float               weight = 1.0f / float(samplesDim*samplesDim);
+    for (uint py=bnds[2]; py<bnds[3]; ++py) {
+        for (uint px=bnds[0]; px<bnds[1]; ++px) {
+            RgbaF               acc(0.0f);
+            for (uint jj=0; jj<samplesDim; ++jj) {
+                size_t              rowIdx = size_t((py-bnds[2])*samplesDim+jj)*wid + (px-bnds[0])*samplesDim;
+                for (uint ii=0; ii<samplesDim; ++ii)
+                    acc += shadeSample(rowIdx+ii);
+            }
+            acc *= weight;
+            img.xy(px,py) = RgbaUC(
+                uchar(clampBounds(acc.red(),0.0f,255.0f)),
+                uchar(clampBounds(acc.green(),0.0f,255.0f)),
+                uchar(clampBounds(acc.blue(),0.0f,255.0f)),
+                uchar(clampBounds(acc.alpha(),0.0f,255.0f)));
+        }
+    }
+}
+
+ImgC4UC
+rasterize(
+    Vec2UI              dims,
+    RayCaster const &   rc,
+    uint                samplesDim,
+    uint                numThreads,
+    SampleTileStatss *  stats,
+    CentreIntersectsFunc const & centreIntersects)
+{
+    RasterSetup         rs = setupRaster(dims,rc,samplesDim);
+    ImgC4UC             img(dims);
+    SampleTileStatss    tiles;
+    for (Mat22UI bnds : rs.tileBounds)
+        tiles.push_back(SampleTileStats{bnds});
+    auto                rasterTileFn = [&](size_t tt)
+    {
+        Svec<RayCaster::Intersects> frags = rasterTile(rs,tt);
+        Mat22UI             bnds = rs.tileBounds[tt];
+        filterTile(bnds,samplesDim,[&](size_t ss){return rc.shade(frags[ss]); },img);
+        if (centreIntersects)
+            for (Iter2UI it(bnds); it.valid(); it.next())
+                centreIntersects(it(),frags[centreSampleIdx(bnds,samplesDim,it())]);
+        tiles[tt].rayCount = uint64(frags.size());
+    };
+    parallelFor(tiles.size(),rasterTileFn,numThreads);
+    if (stats)
+        *stats = tiles;
+    return img;
+}
+
+VisibilityBuffer
+rasterizeVisibility(
+    Vec2UI              dims,
+    RayCaster const &   rc,
+    uint                samplesDim,
+    uint                numThreads)
+{
+    RasterSetup         rs = setupRaster(dims,rc,samplesDim);
+    VisibilityBuffer    ret;
+    ret.dims = dims;
+    ret.samplesDim = samplesDim;
+    ret.tiles.resize(rs.tileBounds.size());
+    auto                fn = [&](size_t tt)
+    {
+        Svec<RayCaster::Intersects> frags = rasterTile(rs,tt);
+        VisibilityBuffer::Tile &    tile = ret.tiles[tt];
+        tile.boundsIrcs = rs.tileBounds[tt];
+        tile.offsets.resize(frags.size()+1);
+        tile.offsets[0] = 0;
+        for (size_t ss=0; ss<frags.size(); ++ss) {
+            RayCaster::Intersects const & best = frags[ss];
+            for (uint ii=0; ii<best.size(); ++ii)
+                tile.frags.push_back(VisibilityBuffer::Frag{
+                    best[ii].second.triInd,Vec3F(best[ii].second.barycentric),best[ii].first});
+            tile.offsets[ss+1] = uint(tile.frags.size());
+        }
+    };
+    parallelFor(ret.tiles.size(),fn,numThreads);
+    return ret;
+}
+
+RayCaster::Intersects
+VisibilityBuffer::Tile::intersects(size_t sampleIdx) const
+{
+    RayCaster::Intersects   ret;
+    for (uint ff=offsets[sampleIdx]; ff<offsets[sampleIdx+1]; ++ff)     // Closest first so order is kept
+        ret.update(frags[ff].invDepth,RayCaster::Intersect(frags[ff].triInd,Vec3D(frags[ff].barycentric)));
+    return ret;
+}
+
+void
+forCentreIntersects(VisibilityBuffer const & vis,CentreIntersectsFunc const & fn)
+{
+    for (VisibilityBuffer::Tile const & tile : vis.tiles)
+        for (Iter2UI it(tile.boundsIrcs); it.valid(); it.next())
+            fn(it(),tile.intersects(centreSampleIdx(tile.boundsIrcs,vis.samplesDim,it())));
+}
+
+ImgC4UC
+shadeVisibility(
+    VisibilityBuffer const & vis,
+    RayCaster const &   rc,
+    Lighting const &    lighting,
+    RgbaF               background,
+    bool                useMaps,
+    bool                allShiny,
+    uint                numThreads)
+{
+    ImgC4UC             img(vis.dims);
+    auto                fn = [&](size_t tt)
+    {
+        VisibilityBuffer::Tile const & tile = vis.tiles[tt];
+        auto                shadeSample = [&](size_t ss)
+        {return rc.shade(tile.intersects(ss),lighting,background,useMaps,allShiny); };
+        filterTile(tile.boundsIrcs,vis.samplesDim,shadeSample,img);
+    };
+    parallelFor(vis.tiles.size(),fn,numThreads);
+    return img;
+}
+
+}
+
+// */
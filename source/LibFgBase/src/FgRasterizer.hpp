@@ -0,0 +1,87 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Multisampled Z-buffer rasterizer for the projected geometry of a RayCaster
+//
+
+#ifndef FG_RASTERIZER_HPP
+#define FG_RASTERIZER_HPP
+
+#include "FgRayCaster.hpp"
+#include "FgSampler.hpp"
+
+namespace Fg {
+
+// Called with the closest intersects of the sample nearest each pixel centre, given the pixel coordinates:
+typedef std::function<void(Vec2UI,RayCaster::Intersects const &)>  CentreIntersectsFunc;
+
+// Triangles are binned into image tiles which are rasterized concurrently using edge functions.
+// Each sample keeps the same closest intersects as RayCaster::closestIntersects (rather than a single
+// depth value) so transparent surfaces are composited and shaded exactly as by RayCaster::cast.
+// Samples lie on a regular grid of 'samplesDim' x 'samplesDim' within each pixel and are box filtered:
+ImgC4UC
+rasterize(
+    Vec2UI              dims,           // Must be non-zero
+    RayCaster const &   rc,
+    uint                samplesDim,     // Must be in [1,8]
+    uint                numThreads=0,   // 0 - all hardware threads
+    SampleTileStatss *  stats=nullptr,  // If non-null, per-tile statistics are RETURNED here
+    // If defined, called concurrently for each pixel during rasterization:
+    CentreIntersectsFunc const & centreIntersects=CentreIntersectsFunc());
+
+// The visible fragments of every sample of a rasterization, closest first, so that the image can be shaded
+// again (eg. under different lighting) without repeating the visibility computation:
+struct  VisibilityBuffer
+{
+    struct  Frag
+    {
+        TriInd          triInd;
+        Vec3F           barycentric;
+        float           invDepth;
+    };
+    struct  Tile
+    {
+        Mat22UI         boundsIrcs;     // Pixel bounds, upper bounds exclusive
+        // Sample 'ii' (row-major within the tile) has fragments [offsets[ii],offsets[ii+1]):
+        Uints           offsets;
+        Svec<Frag>      frags;
+
+        RayCaster::Intersects
+        intersects(size_t sampleIdx) const;
+    };
+    Vec2UI              dims;           // Pixels
+    uint                samplesDim;     // Samples per pixel along each axis
+    Svec<Tile>          tiles;
+};
+
+// Samples are the same as those of 'rasterize':
+VisibilityBuffer
+rasterizeVisibility(
+    Vec2UI              dims,           // Must be non-zero
+    RayCaster const &   rc,
+    uint                samplesDim,     // Must be in [1,8]
+    uint                numThreads=0);  // 0 - all hardware threads
+
+// Call 'fn' serially for each pixel:
+void
+forCentreIntersects(VisibilityBuffer const & vis,CentreIntersectsFunc const & fn);
+
+// Shade and filter with the given parameters. 'rc' must be the RayCaster the buffer was made from.
+// Gives the same image as 'rasterize' when the shading parameters are those of 'rc':
+ImgC4UC
+shadeVisibility(
+    VisibilityBuffer const & vis,
+    RayCaster const &   rc,
+    Lighting const &    lighting,       // In OECS
+    RgbaF               background,     // Must be alpha-weighted
+    bool                useMaps,
+    bool                allShiny,
+    uint                numThreads=0);  // 0 - all hardware threads
+
+}
+
+#endif
+
+// */
@@ -9,6 +9,18 @@
 
 #include "FgRayCaster.hpp"
 #include "FgGeometry.hpp"
+#include "Fg3dMeshOps.hpp"
+#include "FgRandom.hpp"
+#include "FgCommand.hpp"
+#include "Fg3dMeshIo.hpp"
+#include "Fg3dCamera.hpp"
+#include "FgTime.hpp"
+#include "FgParallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FG_RAYCASTER_SSE
+#include <xmmintrin.h>
+#endif
 
 using namespace std;
 
@@ -22,30 +34,14 @@ TriInd::TriInd(size_t triIdx_,size_t surfIdx_,size_t meshIdx_)
     FGASSERT(meshIdx < numeric_limits<uint16>::max());
 }
 
-RayCaster::RayCaster(
-    Meshes const &      meshes,
-    SimilarityD         modelview,
-    AffineEw2D          itcsToIucs_,
-    Lighting const &    lighting_,
-    RgbaF               background_,
-    bool                useMaps_,
-    bool                allShiny_)
-    :
-    itcsToIucs(itcsToIucs_),
-    lighting(lighting_),
-    background(background_),
-    useMaps(useMaps_),
-    allShiny(allShiny_)
+RayCastMeshes::RayCastMeshes(Meshes const & meshes,bool mipmaps) : numTriEquivs(uint(fgNumTriEquivs(meshes)))
 {
     trisss.resize(meshes.size());
     materialss.resize(meshes.size());
-    vertss.resize(meshes.size());
+    vertsPtrs.resize(meshes.size());
+    surfsPtrs.resize(meshes.size());
     uvsPtrs.resize(meshes.size());
     normss.resize(meshes.size());
-    iucsVertss.resize(meshes.size());
-    // TODO: set up grid only after seeing how many verts fall in frustum, possibly use smaller grid size,
-    // and what their bounding box is for setting client to grid transform:
-    grid.setup(Mat22F(0,1,0,1),uint(fgNumTriEquivs(meshes)));
     for (size_t mm=0; mm<meshes.size(); ++mm) {
         Mesh const &    mesh = meshes[mm];
         Triss &           triss = trisss[mm];
@@ -56,14 +52,348 @@ RayCaster::RayCaster(
             triss.push_back(mesh.surfaces[ss].asTris());
             materials.push_back(mesh.surfaces[ss].material);
         }
-        Vec3Fs &           verts = vertss[mm];
-        verts = mapMul(Affine3F{modelview.asAffine()},mesh.verts);
+        vertsPtrs[mm] = &mesh.verts;
+        surfsPtrs[mm] = &mesh.surfaces;
         uvsPtrs[mm] = &mesh.uvs;
-        normss[mm] = cNormals(mesh.surfaces,verts);
-        Vec3Fs &           iucsVerts = iucsVertss[mm];
-        iucsVerts.reserve(verts.size());
-        for (Vec3F v : verts)
-            iucsVerts.push_back(oecsToIucs(v));
+        normss[mm] = cNormals(mesh.surfaces,mesh.verts);
+    }
+    albedoMipss.resize(meshes.size());
+    specularMipss.resize(meshes.size());
+    for (size_t mm=0; mm<meshes.size(); ++mm) {
+        albedoMipss[mm].resize(materialss[mm].size());
+        specularMipss[mm].resize(materialss[mm].size());
+    }
+    if (!mipmaps)
+        return;
+    // Maps are often shared between surfaces and meshes so only build each one once:
+    map<ImgC4UC const *,Sptr<ImgC4UCs const> >  mipsByMap;
+    for (Materials const & materials : materialss)
+        for (Material const & material : materials)
+            for (Sptr<ImgC4UC> const & mapPtr : {material.albedoMap,material.specularMap})
+                if (mapPtr && (cMinElem(mapPtr->dims()) >= 4))      // Smaller maps have no reduced levels
+                    mipsByMap[mapPtr.get()] = Sptr<ImgC4UCs const>();
+    Svec<ImgC4UC const *>   maps;
+    for (auto const & it : mipsByMap)
+        maps.push_back(it.first);
+    Svec<Sptr<ImgC4UCs const> > mipss(maps.size());
+    auto                fn = [&](size_t ii)
+    {
+        ImgC4UCs            levels = cMipMap(*maps[ii]);
+        levels.erase(levels.begin());
+        mipss[ii] = make_shared<ImgC4UCs>(move(levels));
+    };
+    parallelFor(maps.size(),fn);
+    for (size_t ii=0; ii<maps.size(); ++ii)
+        mipsByMap[maps[ii]] = mipss[ii];
+    auto                lookup = [&](Sptr<ImgC4UC> const & mapPtr)
+    {
+        auto                it = mipsByMap.find(mapPtr.get());
+        return (it == mipsByMap.end()) ? Sptr<ImgC4UCs const>() : it->second;
+    };
+    for (size_t mm=0; mm<materialss.size(); ++mm) {
+        for (size_t ss=0; ss<materialss[mm].size(); ++ss) {
+            albedoMipss[mm][ss] = lookup(materialss[mm][ss].albedoMap);
+            specularMipss[mm][ss] = lookup(materialss[mm][ss].specularMap);
+        }
+    }
+}
+
+RayCaster::RayCaster(
+    Meshes const &      meshes,
+    SimilarityD         modelview,
+    AffineEw2D          itcsToIucs_,
+    Lighting const &    lighting_,
+    RgbaF               background_,
+    bool                useMaps_,
+    bool                allShiny_,
+    RayCastAccel        accel_)
+    :
+    RayCaster(std::make_shared<RayCastMeshes>(meshes),modelview,itcsToIucs_,lighting_,background_,useMaps_,allShiny_,accel_)
+{}
+
+static
+TriEdges
+cTriEdges(TriInd ti,RayCaster const & rc)
+{
+    Vec3UI              vis = rc.rcMeshes->trisss[ti.meshIdx][ti.surfIdx].posInds[ti.triIdx];
+    Vec3Fs const &      iucsVerts = rc.iucsVertss[ti.meshIdx];
+    double              maxCoord = 0.0;
+    Vec2D               u[3];
+    for (uint vv=0; vv<3; ++vv) {
+        Vec3F               v = iucsVerts[vis[vv]];
+        u[vv] = Vec2D(v[0],v[1]);
+        maxCoord = cMax(maxCoord,std::abs(u[vv][0]),std::abs(u[vv][1]));
+    }
+    double              a = (u[1][0]-u[0][0]) * (u[2][1]-u[0][1]),
+                        b = (u[2][0]-u[0][0]) * (u[1][1]-u[0][1]),
+                        area = a - b,
+                        orient = (area < 0.0) ? -1.0 : 1.0;
+    TriEdges            ret;
+    // Expansion of the edge function (u_j - p) x (u_k - p):
+    for (uint ii=0; ii<3; ++ii) {
+        uint                jj = (ii+1)%3,
+                            kk = (ii+2)%3;
+        ret.c[ii] = float((u[jj][0]*u[kk][1] - u[kk][0]*u[jj][1]) * orient);
+        ret.cx[ii] = float((u[jj][1] - u[kk][1]) * orient);
+        ret.cy[ii] = float((u[kk][0] - u[jj][0]) * orient);
+    }
+    ret.triInd = ti;
+    // The exact test's orientation (its barycentric denominator) is only guaranteed to match
+    // 'orient' for well-conditioned tris, and very distant vertices could overflow in float:
+    ret.exact = (std::abs(area) <= 1.0e-6 * (std::abs(a) + std::abs(b))) || (maxCoord > 1.0e15);
+    return ret;
+}
+
+// Set tri 'll' of 'pack':
+static
+void
+packTri(TriEdges const & te,uint ll,TriPack4 & pack)
+{
+    for (uint ii=0; ii<3; ++ii) {
+        pack.c[ii][ll] = te.c[ii];
+        pack.cx[ii][ll] = te.cx[ii];
+        pack.cy[ii][ll] = te.cy[ii];
+    }
+    pack.triInds[ll] = te.triInd;
+    if (te.exact)
+        pack.exactMask |= 1U << ll;
+    else
+        pack.exactMask &= ~(1U << ll);
+}
+
+// Add a tri to the last pack, or a new one if it is full:
+static
+void
+addToPacks(TriInd ti,RayCaster const & rc,TriPack4s & packs)
+{
+    if (packs.empty() || (packs.back().num == 4))
+        packs.emplace_back();
+    TriPack4 &          pack = packs.back();
+    packTri(cTriEdges(ti,rc),pack.num++,pack);
+}
+
+static
+void
+setupGrid(
+    RayCaster const &       rc,
+    TriBoundss const &      tbs,
+    Mat22F                  boundsIucs,
+    uint                    numBins,
+    GridIndex<TriInd> &     triGrid,        // Working storage
+    GridIndex<TriPack4> &   grid,           // RETURNED
+    CsrBins<TriEdges> &     gridRest)       // RETURNED
+{
+    triGrid.setup(boundsIucs,numBins);
+    for (TriBounds const & tb : tbs)
+        triGrid.count(tb.boundsIucs);
+    triGrid.allocate();
+    for (TriBounds const & tb : tbs)
+        triGrid.add(tb.triInd,tb.boundsIucs);
+    // Pack each bin, preserving the order of the tris. Any tris which don't fill a pack are kept
+    // singly, so sparsely populated bins (most of them) don't hold mostly empty packs:
+    grid.clientToGridIpcs = triGrid.clientToGridIpcs;
+    grid.grid.setup(triGrid.grid.dims());
+    gridRest.setup(triGrid.grid.dims());
+    size_t              numGridBins = triGrid.grid.numBins();
+    for (size_t bb=0; bb<numGridBins; ++bb) {
+        uint                num = uint(triGrid.grid[bb].size());
+        grid.grid.count(bb,num/4);
+        gridRest.count(bb,num%4);
+    }
+    grid.grid.allocate();
+    gridRest.allocate();
+    for (size_t bb=0; bb<numGridBins; ++bb) {
+        ArrayView<TriInd>   tris = triGrid.grid[bb];
+        size_t              numPacked = tris.size() - tris.size()%4;
+        for (size_t ii=0; ii<numPacked; ii+=4) {
+            TriPack4            pack;
+            for (size_t jj=ii; jj<ii+4; ++jj)
+                packTri(cTriEdges(tris[jj],rc),pack.num++,pack);
+            grid.grid.add(bb,pack);
+        }
+        for (size_t ii=numPacked; ii<tris.size(); ++ii)
+            gridRest.add(bb,cTriEdges(tris[ii],rc));
+    }
+}
+
+static
+Mat22F
+unionBounds(TriBoundss::const_iterator begin,TriBoundss::const_iterator end)
+{
+    Mat22F              ret = begin->boundsIucs;
+    for (auto it=begin+1; it!=end; ++it) {
+        Mat22F const &      b = it->boundsIucs;
+        ret[0] = cMin(ret[0],b[0]);
+        ret[1] = cMax(ret[1],b[1]);
+        ret[2] = cMin(ret[2],b[2]);
+        ret[3] = cMax(ret[3],b[3]);
+    }
+    return ret;
+}
+
+// Median split on the longest axis of the bounds centres, with one pack per leaf.
+// Adds the node for the given range at 'nodeIdx', which must already exist:
+static
+void
+buildBvh(RayCaster const & rc,TriBoundss::iterator begin,TriBoundss::iterator end,uint nodeIdx,TriPackBvh & bvh)
+{
+    Mat22F              bounds = unionBounds(begin,end);
+    bvh.nodes[nodeIdx].bounds = bounds;
+    size_t              num = end - begin;
+    if (num <= 4) {
+        bvh.nodes[nodeIdx].idx = uint(bvh.packs.size());
+        bvh.nodes[nodeIdx].numPacks = 1;
+        // Keep the original order of the tris so equal depth intersects are resolved as for the grid:
+        sort(begin,end,[](TriBounds const & l,TriBounds const & r)
+        {
+            return (l.triInd.meshIdx != r.triInd.meshIdx) ? (l.triInd.meshIdx < r.triInd.meshIdx) :
+                ((l.triInd.surfIdx != r.triInd.surfIdx) ? (l.triInd.surfIdx < r.triInd.surfIdx) :
+                (l.triInd.triIdx < r.triInd.triIdx));
+        });
+        bvh.packs.emplace_back();
+        for (auto it=begin; it!=end; ++it)
+            addToPacks(it->triInd,rc,bvh.packs);
+        return;
+    }
+    uint                axis = (bounds[1]-bounds[0] >= bounds[3]-bounds[2]) ? 0 : 1;
+    auto                centre = [axis](TriBounds const & tb)
+    {return tb.boundsIucs.rc(axis,0) + tb.boundsIucs.rc(axis,1); };
+    TriBoundss::iterator mid = begin + num/2;
+    nth_element(begin,mid,end,[&centre](TriBounds const & l,TriBounds const & r){return centre(l) < centre(r); });
+    uint                childIdx = uint(bvh.nodes.size());
+    bvh.nodes[nodeIdx].idx = childIdx;
+    bvh.nodes[nodeIdx].numPacks = 0;
+    bvh.nodes.resize(childIdx+2);
+    buildBvh(rc,begin,mid,childIdx,bvh);
+    buildBvh(rc,mid,end,childIdx+1,bvh);
+}
+
+// Recompute the packs and bounds of an existing BVH whose tris have moved:
+static
+void
+refitBvh(RayCaster const & rc,TriPackBvh & bvh)
+{
+    // Children always follow their parent so bottom-up is reverse order:
+    for (size_t nn=bvh.nodes.size(); nn>0; --nn) {
+        TriPackBvh::Node &  node = bvh.nodes[nn-1];
+        Mat22F &            b = node.bounds;
+        if (node.numPacks > 0) {
+            b = Mat22F(maxFloat(),-maxFloat(),maxFloat(),-maxFloat());
+            for (uint pp=0; pp<node.numPacks; ++pp) {
+                TriPack4 &          pack = bvh.packs[node.idx+pp];
+                for (uint ll=0; ll<pack.num; ++ll) {
+                    TriInd              ti = pack.triInds[ll];
+                    Vec3UI              vis = rc.rcMeshes->trisss[ti.meshIdx][ti.surfIdx].posInds[ti.triIdx];
+                    Vec3Fs const &      iucsVerts = rc.iucsVertss[ti.meshIdx];
+                    packTri(cTriEdges(ti,rc),ll,pack);
+                    for (uint vv=0; vv<3; ++vv) {
+                        Vec3F               v = iucsVerts[vis[vv]];
+                        b[0] = cMin(b[0],v[0]);
+                        b[1] = cMax(b[1],v[0]);
+                        b[2] = cMin(b[2],v[1]);
+                        b[3] = cMax(b[3],v[1]);
+                    }
+                }
+            }
+        }
+        else {
+            Mat22F const &      b0 = bvh.nodes[node.idx].bounds;
+            Mat22F const &      b1 = bvh.nodes[node.idx+1].bounds;
+            b = Mat22F(cMin(b0[0],b1[0]),cMax(b0[1],b1[1]),cMin(b0[2],b1[2]),cMax(b0[3],b1[3]));
+        }
+    }
+}
+
+RayCaster::RayCaster(
+    Sptr<RayCastMeshes const> const & rcMeshes_,
+    SimilarityD         modelview_,
+    AffineEw2D          itcsToIucs_,
+    Lighting const &    lighting_,
+    RgbaF               background_,
+    bool                useMaps_,
+    bool                allShiny_,
+    RayCastAccel        accel_)
+    :
+    rcMeshes(rcMeshes_),
+    modelview(modelview_),
+    itcsToIucs(itcsToIucs_),
+    accel(accel_),
+    lighting(lighting_),
+    background(background_),
+    useMaps(useMaps_),
+    allShiny(allShiny_)
+{
+    FGASSERT(rcMeshes);
+    size_t              numMeshes = rcMeshes->trisss.size();
+    vertss.resize(numMeshes);
+    normss.resize(numMeshes);
+    iucsVertss.resize(numMeshes);
+    setCamera(modelview_,itcsToIucs_);
+}
+
+void
+RayCaster::setCamera(SimilarityD modelview_,AffineEw2D itcsToIucs_)
+{
+    modelview = modelview_;
+    itcsToIucs = itcsToIucs_;
+    for (size_t mm=0; mm<vertss.size(); ++mm)
+        projectVerts(mm,*rcMeshes->vertsPtrs[mm],rcMeshes->normss[mm]);
+    setupIndex(false);
+}
+
+void
+RayCaster::updateVerts(Vec3Fss const & modelVertss)
+{
+    FGASSERT(modelVertss.size() == vertss.size());
+    for (size_t mm=0; mm<vertss.size(); ++mm) {
+        FGASSERT(modelVertss[mm].size() == vertss[mm].size());
+        cNormals_(*rcMeshes->surfsPtrs[mm],modelVertss[mm],normAccs,modelNorms);
+        projectVerts(mm,modelVertss[mm],modelNorms);
+    }
+    setupIndex(true);
+}
+
+void
+RayCaster::projectVerts(size_t mm,Vec3Fs const & modelVerts,MeshNormals const & modelNorms)
+{
+    Affine3F            toOecs {modelview.asAffine()};
+    // Normals only need rotating since the scale of a similarity transform is positive:
+    Mat33F              rotate {modelview.rot.asMatrix()};
+    Vec3Fs &            verts = vertss[mm];
+    Vec3Fs &            iucsVerts = iucsVertss[mm];
+    verts.resize(modelVerts.size());
+    iucsVerts.resize(modelVerts.size());
+    for (size_t ii=0; ii<modelVerts.size(); ++ii) {
+        verts[ii] = toOecs * modelVerts[ii];
+        iucsVerts[ii] = oecsToIucs(verts[ii]);
+    }
+    MeshNormals &       norms = normss[mm];
+    norms.vert.resize(modelNorms.vert.size());
+    for (size_t ii=0; ii<modelNorms.vert.size(); ++ii)
+        norms.vert[ii] = rotate * modelNorms.vert[ii];
+    norms.facet.resize(modelNorms.facet.size());
+    for (size_t ss=0; ss<modelNorms.facet.size(); ++ss) {
+        FacetNormals const & mfn = modelNorms.facet[ss];
+        FacetNormals &      fn = norms.facet[ss];
+        fn.tri.resize(mfn.tri.size());
+        for (size_t ii=0; ii<mfn.tri.size(); ++ii)
+            fn.tri[ii] = rotate * mfn.tri[ii];
+        fn.quad.resize(mfn.quad.size());
+        for (size_t ii=0; ii<mfn.quad.size(); ++ii)
+            fn.quad[ii] = rotate * mfn.quad[ii];
+    }
+}
+
+void
+RayCaster::setupIndex(bool refit)
+{
+    // Gather the visible tris in place, noting if they have changed since the last setup:
+    size_t              numPrev = triBoundss.size(),
+                        num = 0;
+    bool                same = refit;
+    for (size_t mm=0; mm<iucsVertss.size(); ++mm) {
+        Vec3Fs const &      iucsVerts = iucsVertss[mm];
+        Triss const &       triss = rcMeshes->trisss[mm];
         for (size_t ss=0; ss<triss.size(); ++ss) {
             Tris const &  tris = triss[ss];
             for (size_t tt=0; tt<tris.posInds.size(); ++tt) {
@@ -77,24 +407,102 @@ RayCaster::RayCaster(
                     bnds[1] = cMax(v0[0],v1[0],v2[0]);
                     bnds[2] = cMin(v0[1],v1[1],v2[1]);
                     bnds[3] = cMax(v0[1],v1[1],v2[1]);
-                    grid.add(TriInd(tt,ss,mm),bnds);
+                    // Only the grid keeps tris outside the image; rays outside it are never cast:
+                    if ((accel == RayCastAccel::grid) ||
+                        ((bnds[1] >= 0.0f) && (bnds[0] < 1.0f) && (bnds[3] >= 0.0f) && (bnds[2] < 1.0f))) {
+                        TriBounds           tb {TriInd(tt,ss,mm),bnds};
+                        if (num < numPrev) {
+                            TriInd              prev = triBoundss[num].triInd;
+                            same = same && (prev.triIdx == tt) && (prev.surfIdx == ss) && (prev.meshIdx == mm);
+                            triBoundss[num] = tb;
+                        }
+                        else
+                            triBoundss.push_back(tb);
+                        ++num;
+                    }
                 }
             }
         }
     }
+    same = same && (num == numPrev);
+    triBoundss.resize(num);
+    if (accel == RayCastAccel::grid)
+        setupGrid(*this,triBoundss,Mat22F(0,1,0,1),rcMeshes->numTriEquivs,triGrid,grid,gridRest);
+    else if (accel == RayCastAccel::boundsGrid) {
+        Mat22F              bounds(0,1,0,1);
+        if (!triBoundss.empty()) {
+            Mat22F              tb = unionBounds(triBoundss.begin(),triBoundss.end());
+            // Grid upper bounds are exclusive so pad them to include rays on the upper edges of the mesh:
+            const float         pad = 1.0e-5f;
+            bounds[0] = cMax(tb[0],0.0f);
+            bounds[1] = cMin(tb[1]+pad,1.0f);
+            bounds[2] = cMax(tb[2],0.0f);
+            bounds[3] = cMin(tb[3]+pad,1.0f);
+            if ((bounds[1] <= bounds[0]) || (bounds[3] <= bounds[2]))   // Degenerate
+                bounds = Mat22F(0,1,0,1);
+        }
+        setupGrid(*this,triBoundss,bounds,uint(cMax(triBoundss.size(),size_t(1))),triGrid,grid,gridRest);
+    }
+    else if (same && !bvh.nodes.empty())
+        refitBvh(*this,bvh);
+    else {
+        bvh.nodes.clear();
+        bvh.packs.clear();
+        if (!triBoundss.empty()) {
+            bvhTris.assign(triBoundss.begin(),triBoundss.end());     // Reordered by the build
+            bvh.packs.reserve(bvhTris.size()/2);
+            bvh.nodes.reserve(bvhTris.size()/2);
+            bvh.nodes.resize(1);
+            buildBvh(*this,bvhTris.begin(),bvhTris.end(),0,bvh);
+        }
+    }
 }
 
+// Level of detail for a map of the given dimensions from the UV derivatives over one pixel (both in IUCS).
+// Uses the longer of the texel footprint axes, so anisotropic minification is blurred along the short axis:
+static inline
+float
+mipLod(Vec2F duvdx,Vec2F duvdy,Vec2UI mapDims)
+{
+    Vec2F               dims(mapDims);
+    double              lenSqr = cMax(cMag(mapMul(duvdx,dims)),cMag(mapMul(duvdy,dims)));
+    return (lenSqr > 1.0) ? float(0.5 * log2(lenSqr)) : 0.0f;
+}
+
+// Trilinear sample between the two nearest levels of detail. 'mips' holds the reduced levels so the
+// full resolution map is used exactly as before when magnified:
+static
 RgbaF
-RayCaster::cast(Vec2F posIucs) const
+sampleMipIucs(ImgC4UC const & map,ImgC4UCs const * mips,Vec2F uvIucs,float lod)
 {
-    BestN<float,Intersect,4>      best = closestIntersects(posIucs);
-    // Compute ray color:
-    RgbaF               color = background;
+    if ((mips == nullptr) || mips->empty() || (lod <= 0.0f))
+        return sampleClipIucs(map,uvIucs);
+    lod = cMin(lod,float(mips->size()));
+    uint                lo = uint(lod);
+    float               wgt = lod - float(lo);
+    ImgC4UC const &     mapLo = (lo == 0) ? map : (*mips)[lo-1];
+    RgbaF               ret = sampleClipIucs(mapLo,uvIucs);
+    if (wgt > 0.0f)
+        ret = ret * (1.0f - wgt) + sampleClipIucs((*mips)[lo],uvIucs) * wgt;
+    return ret;
+}
+
+RgbaF
+RayCaster::shade(
+    Intersects const &  best,
+    Lighting const &    lighting_,
+    RgbaF               background_,
+    bool                useMaps_,
+    bool                allShiny_) const
+{
+    RgbaF               color = background_;
     for (uint ii=best.size(); ii>0; --ii) {             // Render back to front
         Intersect           isct = best[ii-1].second;
-        Tris const &        tris = trisss[isct.triInd.meshIdx][isct.triInd.surfIdx];
-        Material            material = materialss[isct.triInd.meshIdx][isct.triInd.surfIdx];
-        MeshNormals const &     norms = normss[isct.triInd.meshIdx];
+        size_t              mm = isct.triInd.meshIdx,
+                            ss = isct.triInd.surfIdx;
+        Tris const &        tris = rcMeshes->trisss[mm][ss];
+        Material const &    material = rcMeshes->materialss[mm][ss];
+        MeshNormals const &     norms = normss[mm];
         Vec3UI              vis = tris.posInds[isct.triInd.triIdx];
         // TODO: Use perspective-correct normal and UV interpolation (makes very little difference for small tris):
         Vec3F               n0 = norms.vert[vis[0]],
@@ -103,29 +511,51 @@ RayCaster::cast(Vec2F posIucs) const
                             bc = Vec3F(isct.barycentric),
                             norm = normalize(bc[0]*n0 + bc[1]*n1 + bc[2]*n2);
         RgbaF               albedo(230,230,230,255);
-        Vec2Fs const &      uvs = *uvsPtrs[isct.triInd.meshIdx];
+        Vec2Fs const &      uvs = *rcMeshes->uvsPtrs[mm];
         Vec2F               uv {maxFloat()};
+        // UV derivatives over one pixel along each image axis, zero if not mipmapping:
+        Vec2F               duvdx {0},
+                            duvdy {0};
         if ((!tris.uvInds.empty()) && (!uvs.empty()) && (material.albedoMap) &&
-            (!material.albedoMap->empty()) && useMaps) {
+            (!material.albedoMap->empty()) && useMaps_) {
             Vec3UI              uvInds = tris.uvInds[isct.triInd.triIdx];
-            uv = bc[0]*uvs[uvInds[0]] + bc[1]*uvs[uvInds[1]] + bc[2]*uvs[uvInds[2]];
+            Vec2F               uv0 = uvs[uvInds[0]],
+                                uv1 = uvs[uvInds[1]],
+                                uv2 = uvs[uvInds[2]];
+            uv = bc[0]*uv0 + bc[1]*uv1 + bc[2]*uv2;
             uv[1] = 1.0f - uv[1];   // OTCS to IUCS
-            albedo = RgbaF(sampleClipIucs(*material.albedoMap,uv));
+            if (iucsPerPixel[0] > 0.0f) {
+                // UV is affine in IUCS over the tri (consistent with the interpolation above):
+                Vec3Fs const &      iucsVerts = iucsVertss[mm];
+                Vec3F               p0 = iucsVerts[vis[0]],
+                                    e1 = iucsVerts[vis[1]] - p0,
+                                    e2 = iucsVerts[vis[2]] - p0;
+                float               det = e1[0]*e2[1] - e2[0]*e1[1];
+                if (det != 0.0f) {
+                    Vec2F               t1 = uv1 - uv0,
+                                        t2 = uv2 - uv0;
+                    duvdx = (t1*e2[1] - t2*e1[1]) * (iucsPerPixel[0] / det);
+                    duvdy = (t2*e1[0] - t1*e2[0]) * (iucsPerPixel[1] / det);
+                }
+            }
+            albedo = sampleMipIucs(*material.albedoMap,rcMeshes->albedoMipss[mm][ss].get(),uv,
+                mipLod(duvdx,duvdy,material.albedoMap->dims()));
         }
         Vec3F               acc(0.0f);
 	    float	            aw = albedo.alpha() / 255.0f;
         Vec3F               surfColour = albedo.m_c.subMatrix<3,1>(0,0) * aw;
-        for (size_t ll=0; ll<lighting.lights.size(); ++ll) {
-            Light               lgt = lighting.lights[ll];
+        for (size_t ll=0; ll<lighting_.lights.size(); ++ll) {
+            Light               lgt = lighting_.lights[ll];
             float               fac = cDot(norm,lgt.direction);
             if (fac > 0.0f) {
                 acc += mapMul(surfColour,lgt.colour) * fac;
                 float           shininess = material.shiny ? 1.0f : 0.0f;
                 if ((uv[0] != maxFloat()) && material.specularMap && !material.specularMap->empty()) {
-                    RgbaF           s = sampleClipIucs(*material.specularMap,uv);
+                    RgbaF           s = sampleMipIucs(*material.specularMap,rcMeshes->specularMipss[mm][ss].get(),
+                        uv,mipLod(duvdx,duvdy,material.specularMap->dims()));
                     shininess = scast<float>(s.red()) / 255.0f;
                 }
-                if (allShiny)
+                if (allShiny_)
                     shininess = 1.0f;
                 if (shininess > 0.0f) {
                     Vec3F           reflectDir = norm * fac * 2.0f - lgt.direction;
@@ -137,7 +567,7 @@ RayCaster::cast(Vec2F posIucs) const
                 }
             }
         }
-        acc += mapMul(surfColour,lighting.ambient);
+        acc += mapMul(surfColour,lighting_.ambient);
         RgbaF           isctColor = RgbaF(acc[0],acc[1],acc[2],albedo.alpha());
         color = compositeFragment(isctColor,color);
      }
@@ -154,34 +584,270 @@ RayCaster::oecsToIucs(Vec3F posOecs) const
     return Vec3F(iucs[0],iucs[1],id);
 }
 
-BestN<float,RayCaster::Intersect,4>
+// Tolerance relative to the magnitude of the terms of the float edge functions. This is well above the
+// rounding error of the coefficients and their evaluation so that no tri accepted by the exact
+// double-precision test is ever rejected:
+static const float  edgeTolerance = 1.0e-6f;
+
+static inline
+bool
+edgeMayBeInside(float c,float cx,float cy,Vec2F pos)
+{
+    float               tx = cx * pos[0],
+                        ty = cy * pos[1],
+                        err = edgeTolerance * (std::abs(c) + std::abs(tx) + std::abs(ty));
+    return (c + tx + ty + err >= 0.0f);
+}
+
+// Returns true if the tri may contain 'pos', to be confirmed by the exact test:
+static inline
+bool
+candidateTri(TriEdges const & te,Vec2F pos)
+{
+    return te.exact ||
+        (edgeMayBeInside(te.c[0],te.cx[0],te.cy[0],pos) &&
+         edgeMayBeInside(te.c[1],te.cx[1],te.cy[1],pos) &&
+         edgeMayBeInside(te.c[2],te.cx[2],te.cy[2],pos));
+}
+
+// Returns a bit mask of the tris in 'pack' which may contain 'pos', to be confirmed by the exact test:
+static inline
+uint
+candidateTris(TriPack4 const & pack,Vec2F pos)
+{
+#ifdef FG_RAYCASTER_SSE
+    __m128              px = _mm_set1_ps(pos[0]),
+                        py = _mm_set1_ps(pos[1]),
+                        absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)),
+                        tol = _mm_set1_ps(edgeTolerance),
+                        zero = _mm_setzero_ps(),
+                        inside = _mm_cmpeq_ps(zero,zero);
+    for (uint ii=0; ii<3; ++ii) {
+        __m128              c = _mm_loadu_ps(pack.c[ii]),
+                            tx = _mm_mul_ps(_mm_loadu_ps(pack.cx[ii]),px),
+                            ty = _mm_mul_ps(_mm_loadu_ps(pack.cy[ii]),py),
+                            mag = _mm_add_ps(_mm_add_ps(_mm_and_ps(c,absMask),_mm_and_ps(tx,absMask)),
+                                _mm_and_ps(ty,absMask)),
+                            e = _mm_add_ps(_mm_add_ps(_mm_add_ps(c,tx),ty),_mm_mul_ps(tol,mag));
+        inside = _mm_and_ps(inside,_mm_cmpge_ps(e,zero));
+    }
+    uint                mask = uint(_mm_movemask_ps(inside));
+#else
+    uint                mask = 0;
+    for (uint ll=0; ll<pack.num; ++ll) {
+        bool                inside = true;
+        for (uint ii=0; ii<3; ++ii)
+            inside = inside && edgeMayBeInside(pack.c[ii][ll],pack.cx[ii][ll],pack.cy[ii][ll],pos);
+        if (inside)
+            mask |= 1U << ll;
+    }
+#endif
+    return (mask | pack.exactMask) & ((1U << pack.num) - 1U);
+}
+
+// Exact test of a single tri:
+static inline
+void
+updateIntersect(RayCaster const & rc,TriInd ti,Vec2F posIucs,RayCaster::Intersects & best)
+{
+    Vec3UI              vis = rc.rcMeshes->trisss[ti.meshIdx][ti.surfIdx].posInds[ti.triIdx];
+    Vec3Fs const &      iucsVerts = rc.iucsVertss[ti.meshIdx];
+    Vec3F               v0 = iucsVerts[vis[0]],
+                        v1 = iucsVerts[vis[1]],
+                        v2 = iucsVerts[vis[2]];
+    // TODO: make a float version of fgBarycentriCoords:
+    Opt<Vec3D>          bco = barycentricCoord(Vec2D(posIucs),Vec2D(v0[0],v0[1]),Vec2D(v1[0],v1[1]),Vec2D(v2[0],v2[1]));
+    if (bco.valid()) {
+        Vec3D               bc = bco.val();
+        // TODO: Use a consistent intersection policy to ensure only 1 tri of an edge-connected pair
+        // is ever intersected:
+        if ((bc[0] >= 0) && (bc[1] >= 0) && (bc[2] >= 0)) {     // Point landed on triangle:
+            double          id = bc[0]*v0[2] + bc[1]*v1[2] + bc[2]*v2[2];
+            best.update(id,RayCaster::Intersect(ti,bc));
+        }
+    }
+}
+
+RayCaster::Intersects
 RayCaster::closestIntersects(Vec2F posIucs) const
 {
-    const TriInds &     triInds = grid[posIucs];
-    BestN<float,Intersect,4> best;
-    for (TriInd ti : triInds) {
-        Tris const &        tris = trisss[ti.meshIdx][ti.surfIdx];
-        Vec3UI              vis = tris.posInds[ti.triIdx];
-        Vec3Fs const &      iucsVerts = iucsVertss[ti.meshIdx];
-        Vec3F               v0 = iucsVerts[vis[0]],
-                            v1 = iucsVerts[vis[1]],
-                            v2 = iucsVerts[vis[2]];
-        Vec2D               u0(v0[0],v0[1]),
-                            u1(v1[0],v1[1]),
-                            u2(v2[0],v2[1]);
-        // TODO: make a float version of fgBarycentriCoords:
-        Opt<Vec3D>          bco = barycentricCoord(Vec2D(posIucs),u0,u1,u2);
-        if (bco.valid()) {       // TODO: filter out degenerate projected tris during cache setup
-            Vec3D               bc = bco.val();
-            // TODO: Use a consistent intersection policy to ensure only 1 tri of an edge-connected pair
-            // is ever intersected:
-            if ((bc[0] >= 0) && (bc[1] >= 0) && (bc[2] >= 0)) {     // Point landed on triangle:
-                double          id = bc[0]*v0[2] + bc[1]*v1[2] + bc[2]*v2[2];   // Interpolate inverse depth
-                best.update(id,Intersect(ti,bc));
+    Intersects          best;
+    forCandidates(posIucs,
+        [&](TriPack4 const & pack)
+        {
+            uint                mask = candidateTris(pack,posIucs);
+            for (uint ll=0; mask != 0; ++ll, mask >>= 1)
+                if (mask & 1U)
+                    updateIntersect(*this,pack.triInds[ll],posIucs,best);
+        },
+        [&](TriEdges const & te)
+        {
+            if (candidateTri(te,posIucs))
+                updateIntersect(*this,te.triInd,posIucs,best);
+        });
+    return best;
+}
+
+// Reference implementation of 'closestIntersects' without the candidate tests:
+static
+RayCaster::Intersects
+closestIntersectsExact(RayCaster const & rc,Vec2F posIucs)
+{
+    RayCaster::Intersects   best;
+    rc.forCandidates(posIucs,
+        [&](TriPack4 const & pack)
+        {
+            for (uint ll=0; ll<pack.num; ++ll)
+                updateIntersect(rc,pack.triInds[ll],posIucs,best);
+        },
+        [&](TriEdges const & te)
+        {updateIntersect(rc,te.triInd,posIucs,best); });
+    return best;
+}
+
+static
+void
+checkEqual(RayCaster::Intersects const & lhs,RayCaster::Intersects const & rhs)
+{
+    FGASSERT(lhs.size() == rhs.size());
+    for (uint ii=0; ii<lhs.size(); ++ii) {
+        FGASSERT(lhs[ii].first == rhs[ii].first);
+        RayCaster::Intersect    l = lhs[ii].second,
+                                r = rhs[ii].second;
+        FGASSERT(l.triInd.meshIdx == r.triInd.meshIdx);
+        FGASSERT(l.triInd.surfIdx == r.triInd.surfIdx);
+        FGASSERT(l.triInd.triIdx == r.triInd.triIdx);
+        FGASSERT(l.barycentric == r.barycentric);
+    }
+}
+
+// For comparing results where equal depth intersects may be in a different order:
+static
+void
+checkEqualDepths(RayCaster::Intersects const & lhs,RayCaster::Intersects const & rhs)
+{
+    FGASSERT(lhs.size() == rhs.size());
+    for (uint ii=0; ii<lhs.size(); ++ii)
+        FGASSERT(lhs[ii].first == rhs[ii].first);
+}
+
+void
+testRayCaster(CLArgs const &)
+{
+    randSeedRepeatable();
+    Meshes              meshes {cSphere(1.0f,4),c3dCube()};
+    for (Vec3F & v : meshes[1].verts)       // Intersecting the sphere
+        v = v * 0.7f + Vec3F(0.5f,0,0);
+    Sptr<RayCastMeshes const> rcMeshes = make_shared<RayCastMeshes>(meshes);
+    AffineEw2D          itcsToIucs(Vec2D(0.5),Vec2D(0.5));
+    for (uint vv=0; vv<8; ++vv) {
+        // From close-up to far away:
+        SimilarityD         modelview {1.0,QuaternionD::rand(),Vec3D(0,0,-1.5 - vv*vv*0.5)};
+        RayCaster           rc {rcMeshes,modelview,itcsToIucs,Lighting(),RgbaF(0)},
+                            rcBoundsGrid {rcMeshes,modelview,itcsToIucs,Lighting(),RgbaF(0),true,false,RayCastAccel::boundsGrid},
+                            rcBvh {rcMeshes,modelview,itcsToIucs,Lighting(),RgbaF(0),true,false,RayCastAccel::bvh};
+        Svec<Vec2F>         poss;
+        for (uint ii=0; ii<4000; ++ii)
+            poss.push_back(Vec2F(randUniform(),randUniform()));
+        // Vertices and edge midpoints are the hardest cases:
+        for (Vec3Fs const & iucsVerts : rc.iucsVertss) {
+            for (size_t ii=0; ii+1<iucsVerts.size(); ++ii) {
+                Vec2F               p0(iucsVerts[ii][0],iucsVerts[ii][1]),
+                                    p1(iucsVerts[ii+1][0],iucsVerts[ii+1][1]);
+                poss.push_back(p0);
+                poss.push_back((p0+p1)*0.5f);
             }
         }
+        size_t              numHits = 0;
+        for (Vec2F pos : poss) {
+            RayCaster::Intersects   best = rc.closestIntersects(pos);
+            // The SIMD candidate test must not change the result:
+            checkEqual(best,closestIntersectsExact(rc,pos));
+            checkEqual(rcBoundsGrid.closestIntersects(pos),closestIntersectsExact(rcBoundsGrid,pos));
+            checkEqual(rcBvh.closestIntersects(pos),closestIntersectsExact(rcBvh,pos));
+            // The grids list tris in mesh order in every bin so they give the same result:
+            checkEqual(best,rcBoundsGrid.closestIntersects(pos));
+            // The BVH only lists tris in mesh order within a leaf so equal depth intersects (eg. at a shared
+            // vertex) may be ordered differently:
+            checkEqualDepths(best,rcBvh.closestIntersects(pos));
+            numHits += best.size();
+        }
+        FGASSERT(numHits > 0);
     }
-    return best;
+    // Updating the vertex positions must give the same result as setting up from scratch:
+    Meshes              morphed = meshes;
+    for (Vec3F & v : morphed[0].verts)
+        v *= 1.0f + 0.3f * v[1];
+    Vec3Fss             morphedVertss {morphed[0].verts,morphed[1].verts};
+    for (double dist : {3.0,1.2}) {         // The close-up changes the set of tris in the image
+        SimilarityD         modelview {1.0,QuaternionD::rand(),Vec3D(0,0,-dist)};
+        for (RayCastAccel accel : {RayCastAccel::grid,RayCastAccel::boundsGrid,RayCastAccel::bvh}) {
+            RayCaster           rc {rcMeshes,modelview,itcsToIucs,Lighting(),RgbaF(0),true,false,accel},
+                                ref {morphed,modelview,itcsToIucs,Lighting(),RgbaF(0),true,false,accel};
+            rc.updateVerts(morphedVertss);
+            for (size_t mm=0; mm<meshes.size(); ++mm) {
+                FGASSERT(rc.iucsVertss[mm] == ref.iucsVertss[mm]);
+                FGASSERT(rc.normss[mm].vert == ref.normss[mm].vert);
+            }
+            for (uint ii=0; ii<4000; ++ii) {
+                Vec2F               pos(randUniform(),randUniform());
+                RayCaster::Intersects   best = rc.closestIntersects(pos);
+                checkEqual(best,closestIntersectsExact(rc,pos));
+                // A refit BVH has a different structure to a newly built one:
+                if (accel == RayCastAccel::bvh)
+                    checkEqualDepths(best,ref.closestIntersects(pos));
+                else
+                    checkEqual(best,ref.closestIntersects(pos));
+            }
+        }
+    }
+}
+
+void
+testmRayCaster(CLArgs const &)
+{
+    Mesh                mesh = loadTri(dataDir()+"base/Jane.tri");
+    Meshes              meshes {mesh};
+    Sptr<RayCastMeshes const> rcMeshes = make_shared<RayCastMeshes>(meshes);
+    Vec2UI              dims(512);
+    CameraParams        cps {Mat32D(cBounds(mesh.verts))};
+    Svec<pair<String,double> > views {{"far",-2.5},{"default",cps.logRelScale},{"close-up",1.5}};
+    Svec<pair<String,RayCastAccel> > accels {
+        {"grid",RayCastAccel::grid},
+        {"boundsGrid",RayCastAccel::boundsGrid},
+        {"bvh",RayCastAccel::bvh},
+    };
+    fgout << fgnl << mesh.numTriEquivs() << " tris, " << dims[0] << "x" << dims[1] << " rays:" << fgpush;
+    for (auto const & view : views) {
+        cps.logRelScale = view.second;
+        Camera              cam = cps.camera(dims);
+        fgout << fgnl << view.first << " view:" << fgpush;
+        for (auto const & accel : accels) {
+            Timer               timer;
+            const uint          numSetups = 10;
+            for (uint ii=0; ii<numSetups; ++ii)
+                RayCaster{rcMeshes,cam.modelview,cam.itcsToIucs,Lighting(),RgbaF(0),true,false,accel.second};
+            double              setupMs = timer.readMs() / double(numSetups);
+            RayCaster           rc {rcMeshes,cam.modelview,cam.itcsToIucs,Lighting(),RgbaF(0),true,false,accel.second};
+            Vec3Fss             vertss {mesh.verts};
+            timer.start();
+            for (uint ii=0; ii<numSetups; ++ii)
+                rc.updateVerts(vertss);
+            double              updateMs = timer.readMs() / double(numSetups);
+            size_t              numHits = 0;
+            timer.start();
+            for (Iter2UI it(dims); it.valid(); it.next()) {
+                Vec2F               pos = mapDiv(Vec2F(it()) + Vec2F(0.5f),Vec2F(dims));
+                numHits += rc.closestIntersects(pos).size();
+            }
+            double              castMs = timer.readMs();
+            fgout << fgnl << accel.first << ": setup " << setupMs << "ms, update " << updateMs
+                << "ms, cast " << castMs << "ms, "
+                << numHits << " hits";
+        }
+        fgout << fgpop;
+    }
+    fgout << fgpop;
 }
 
 }
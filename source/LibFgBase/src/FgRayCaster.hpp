@@ -29,21 +29,106 @@ struct  TriInd
 };
 typedef Svec<TriInd>    TriInds;
 
-// Ray-casting requires caching the projected coordinates as well as their mesh and surface indices:
-struct  RayCaster
+// The edge functions of a projected tri, precomputed as 'c + cx*x + cy*y' over IUCS. These are the
+// numerators of the barycentric coordinates in 'barycentricCoord', signed to be non-negative inside the tri:
+struct  TriEdges
+{
+    float           c[3];               // By edge, opposite the vertex of the same index
+    float           cx[3];              // "
+    float           cy[3];              // "
+    TriInd          triInd;
+    bool            exact = false;      // Must always be tested exactly
+};
+
+// The edge functions of up to 4 projected tris in structure-of-arrays layout so they can be tested
+// against a ray together using SIMD:
+struct  TriPack4
+{
+    float           c[3][4];            // By edge, by tri
+    float           cx[3][4];           // "
+    float           cy[3][4];           // "
+    TriInd          triInds[4];
+    uint            num = 0;            // Number of valid tris in [1,4]
+    uint            exactMask = 0;      // Bits set for tris which must always be tested exactly
+};
+typedef Svec<TriPack4>  TriPack4s;
+
+struct  TriBounds
+{
+    TriInd          triInd;
+    Mat22F          boundsIucs;
+};
+typedef Svec<TriBounds>     TriBoundss;
+
+// Bounding volume hierarchy of the IUCS bounds of packed tris:
+struct  TriPackBvh
+{
+    struct  Node
+    {
+        Mat22F          bounds;             // IUCS
+        uint            idx;                // Leaf: first index into 'packs'. Otherwise: first of 2 child nodes
+        uint            numPacks;           // 0 for non-leaf nodes
+    };
+    Svec<Node>          nodes;              // Root is first if non-empty
+    TriPack4s           packs;
+};
+
+// Screen-space structure used to find the candidate tris for a ray:
+enum class RayCastAccel
+{
+    // Uniform grid over the image with as many bins as tris. Fast to build but bins become crowded
+    // for close-ups and the mesh only covers a few bins when it is small in the image:
+    grid,
+    // Uniform grid over the image bounds of the visible tris with as many bins as visible tris:
+    boundsGrid,
+    // BVH of the visible tris. Slower to build but handles varied tri sizes without duplication:
+    bvh
+};
+
+// Camera-independent ray-casting data, which can be shared by RayCasters of the same meshes
+// from different views. Pointers into the given meshes are kept so they must remain valid:
+struct  RayCastMeshes
 {
     Trisss                  trisss;         // By mesh, by surface
     Materialss              materialss;     // By mesh, by surface
-    Vec3Fss                 vertss;         // By mesh, in OECS
+    Svec<Vec3Fs const *>    vertsPtrs;      // By mesh, in model coordinates
+    Svec<Surfs const *>     surfsPtrs;      // By mesh
     Svec<Vec2Fs const *>    uvsPtrs;        // By mesh, in OTCS
-    MeshNormalss                normss;         // By mesh, in OECS
+    MeshNormalss            normss;         // By mesh, in model coordinates
+    uint                    numTriEquivs;
+    // Reduced resolution levels of the albedo and specular maps, finest first (the map itself is level 0
+    // so is not included). By mesh, by surface. Null if there is no map or mipmaps were not built:
+    Svec<Svec<Sptr<ImgC4UCs const> > > albedoMipss,specularMipss;
+
+    // Each distinct map's mipmap is built once here if 'mipmaps' is true:
+    explicit RayCastMeshes(Meshes const & meshes,bool mipmaps=false);
+};
+
+// Ray-casting requires caching the projected coordinates as well as their mesh and surface indices:
+struct  RayCaster
+{
+    Sptr<RayCastMeshes const> rcMeshes;     // Camera-independent data
+    SimilarityD             modelview;      // Model to OECS
+    Vec3Fss                 vertss;         // By mesh, in OECS
+    MeshNormalss            normss;         // By mesh, in OECS
     AffineEw2D              itcsToIucs;
     Vec3Fss                 iucsVertss;     // By mesh, X,Y in IUCS, Z component is inverse FCCS depth
-    GridIndex<TriInd>       grid;           // Index from IUCS to bin of TriInds
+    RayCastAccel            accel;
+    GridIndex<TriPack4>     grid;           // Index from IUCS to bin of full packs of tris if using a grid
+    CsrBins<TriEdges>       gridRest;       // The last 1-3 tris of each bin of 'grid' when they don't fill a pack
+    TriPackBvh              bvh;            // If using a BVH
+    TriBoundss              triBoundss;     // Tris in the index in mesh order. Kept for updates
+    GridIndex<TriInd>       triGrid;        // Working storage for grid setup. Kept for updates
+    TriBoundss              bvhTris;        // Working storage for BVH build. Kept for reuse
+    MeshNormals             modelNorms;     // Working storage for 'updateVerts'. Kept for reuse
+    Vec3Ds                  normAccs;       // "
     Lighting                lighting;
     RgbaF                   background;     // Must be alpha-weighted
     bool                    useMaps = true;
     bool                    allShiny = false;
+    // Pixel size in IUCS, used to select the mipmap level of detail from the screen-space UV derivatives
+    // with trilinear filtering. Maps are sampled at full resolution if zero or if mipmaps were not built:
+    Vec2F                   iucsPerPixel {0};
 
     RayCaster(
         Meshes const &      meshes,
@@ -52,10 +137,34 @@ struct  RayCaster
         Lighting const &    lighting,       // In OECS
         RgbaF               background,      // Must be alpha-weighted
         bool                useMaps = true,
-        bool                allShiny = false);
+        bool                allShiny = false,
+        RayCastAccel        accel = RayCastAccel::grid);
+
+    // Only does the camera-dependent setup:
+    RayCaster(
+        Sptr<RayCastMeshes const> const & rcMeshes,
+        SimilarityD         modelview,      // to OECS
+        AffineEw2D          itcsToIucs,
+        Lighting const &    lighting,       // In OECS
+        RgbaF               background,      // Must be alpha-weighted
+        bool                useMaps = true,
+        bool                allShiny = false,
+        RayCastAccel        accel = RayCastAccel::grid);
+
+    // Change the camera, re-using the existing storage so that no heap allocation is done once it has
+    // been used for a similar view:
+    void
+    setCamera(SimilarityD modelview,AffineEw2D itcsToIucs);
+
+    // Update to new vertex positions for the same meshes (eg. for animation). The projection and
+    // screen-space index are updated in place rather than reallocated; a BVH is refit rather than
+    // rebuilt unless the set of visible tris changes:
+    void
+    updateVerts(Vec3Fss const & modelVertss);   // By mesh, in model coordinates
 
     RgbaF
-    cast(Vec2F posIucs) const;
+    cast(Vec2F posIucs) const
+    {return shade(closestIntersects(posIucs)); }
 
     // Return value depth component is inverse depth if visible and >0, negative otherwise:
     Vec3F
@@ -70,9 +179,72 @@ struct  RayCaster
         Intersect(TriInd ti,Vec3D bc) : triInd(ti), barycentric(bc) {}
     };
 
-    // Return closest tri intersects for given ray:
-    BestN<float,Intersect,4>
+    // Up to 4 closest intersects keyed by inverse depth, closest first:
+    typedef BestN<float,Intersect,4>    Intersects;
+
+    // Return closest tri intersects for given ray. Rays outside the image IUCS bounds [0,1) never intersect:
+    Intersects
     closestIntersects(Vec2F posIucs) const;
+
+    // Call 'packFn' with each TriPack4 and 'triFn' with each TriEdges which may contain tris intersecting
+    // the given ray, in a fixed order:
+    template<class PackFn,class TriFn>
+    void
+    forCandidates(Vec2F posIucs,PackFn const & packFn,TriFn const & triFn) const
+    {
+        if (accel != RayCastAccel::bvh) {
+            size_t              bb = grid.binIdx(posIucs);
+            if (bb < gridRest.numBins()) {
+                for (TriPack4 const & pack : grid.grid[bb])
+                    packFn(pack);
+                for (TriEdges const & te : gridRest[bb])
+                    triFn(te);
+            }
+            return;
+        }
+        if ((bvh.nodes.empty()) ||
+            (posIucs[0] < 0.0f) || (posIucs[0] >= 1.0f) || (posIucs[1] < 0.0f) || (posIucs[1] >= 1.0f))
+            return;
+        uint                stack[64];      // Much deeper than a median-split tree can be
+        uint                size = 0;
+        stack[size++] = 0;
+        while (size > 0) {
+            TriPackBvh::Node const & node = bvh.nodes[stack[--size]];
+            Mat22F              b = node.bounds;
+            if ((posIucs[0] < b[0]) || (posIucs[0] > b[1]) || (posIucs[1] < b[2]) || (posIucs[1] > b[3]))
+                continue;
+            if (node.numPacks > 0) {
+                for (uint ii=0; ii<node.numPacks; ++ii)
+                    packFn(bvh.packs[node.idx+ii]);
+            }
+            else {
+                stack[size++] = node.idx + 1;
+                stack[size++] = node.idx;
+            }
+        }
+    }
+
+    // Shade and composite the given intersects back to front over the background. Used by any
+    // method of finding intersects so that all render backends produce the same colours:
+    RgbaF
+    shade(Intersects const & best) const
+    {return shade(best,lighting,background,useMaps,allShiny); }
+
+    // As above but with the given shading parameters instead of those of this object, for re-shading:
+    RgbaF
+    shade(
+        Intersects const &  best,
+        Lighting const &    lighting,       // In OECS
+        RgbaF               background,     // Must be alpha-weighted
+        bool                useMaps,
+        bool                allShiny) const;
+
+private:
+    void
+    projectVerts(size_t meshIdx,Vec3Fs const & modelVerts,MeshNormals const & modelNorms);
+
+    void
+    setupIndex(bool refit);
 };
 
 }
@@ -6,6 +6,18 @@
 
 #include "stdafx.h"
 
+// The progressive and adaptive samplers evaluate the same sample positions and values in different
+// contexts, and must do so identically to give the same image, so fast math is disabled here:
+#if defined(_MSC_VER) || defined(__INTEL_COMPILER)
+#pragma float_control(precise,on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma float_control(precise,on)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("no-fast-math","fp-contract=off")
+#endif
+
 #include "FgSampler.hpp"
 #include "FgOpt.hpp"
 #include "FgBounds.hpp"
@@ -13,125 +25,227 @@
 #include "FgSyntax.hpp"
 #include "FgImgDisplay.hpp"
 #include "FgTime.hpp"
+#include "FgParallel.hpp"
 
 using namespace std;
 
 namespace Fg {
 
 static
-inline bool
-valsDiffer(
-    const RgbaF &                 centre,
-    const Mat<RgbaF,2,2> &  corners,
-    float                           maxDiff)
+Vec2F
+cornerPos(uint xx,uint yy,float widf,float hgtf)
+{return Vec2F(float(xx)/widf,float(yy)/hgtf); }
+
+static
+Mat22F
+pixelBounds(uint col,uint row,float widf,float hgtf)
+{
+    return Mat22F(
+        float(col)/widf,
+        float(col+1)/widf,
+        float(row)/hgtf,
+        float(row+1)/hgtf);
+}
+
+static
+Vec2F
+centreOf(Mat22F bounds)
 {
-    return (
-        (cMaxElem(mapAbs(corners[0].m_c - centre.m_c)) > maxDiff) ||
-        (cMaxElem(mapAbs(corners[1].m_c - centre.m_c)) > maxDiff) ||
-        (cMaxElem(mapAbs(corners[2].m_c - centre.m_c)) > maxDiff) ||
-        (cMaxElem(mapAbs(corners[3].m_c - centre.m_c)) > maxDiff));
+    Vec2F               lc = bounds.colVec(0);
+    return lc + (bounds.colVec(1)-lc)*0.5f;
 }
 
-static uint64 rayCount;
+typedef ProgressiveSampler::Square     SampleSquare;
+
+static inline
+float
+cMaxDiff(SampleSquare const & sq)
+{
+    float               ret = 0.0f;
+    for (RgbaF const & corner : sq.corners.m)
+        ret = cMax(ret,cMaxElem(mapAbs(corner.m_c - sq.centre.m_c)));
+    return ret;
+}
 
 static
 RgbaF
-sampleRecurse(
-    SampleFunc            sample,
-    Mat22F                bounds,
-    Mat<RgbaF,2,2>  cornerVals,
-    float                   maxDiff)
+leafVal(SampleSquare const & sq)
+{
+    Mat<RgbaF,2,2> const &  cv = sq.corners;
+    return (cv[0]+cv[1]+cv[2]+cv[3]) * 0.125f + sq.centre * 0.5f;
+}
+
+static
+RgbaF
+meanOf(Arr<RgbaF,4> const & vals)
+{return (vals[0]+vals[1]+vals[2]+vals[3]) * 0.25f; }
+
+// Takes 8 samples to split 'sq' into 4 squares in raster order:
+static
+void
+subdivide(SampleFunc const & sample,SampleSquare const & sq,Arr<SampleSquare,4> & quads)
 {
-    Vec2F        lc = bounds.colVec(0),
-                    uc = bounds.colVec(1),
+    Vec2F        lc = sq.bounds.colVec(0),
+                    uc = sq.bounds.colVec(1),
                     del = (uc-lc)*0.5f,
                     delx,dely;
     delx[0] = del[0];
     dely[1] = del[1];
-    RgbaF         ret,
-                    centre(sample(lc+delx+dely));
-    if (valsDiffer(centre,cornerVals,maxDiff)) {
-        rayCount+=4;
-        Mat<RgbaF,3,3>  vals(
-                cornerVals[0],
-                sample(lc+delx),
-                cornerVals[1],
-                sample(lc+dely),
-                centre,
-                sample(uc-dely),
-                cornerVals[2],
-                sample(uc-delx),
-                cornerVals[3]);
-        RgbaF     acc;
-        for (Iter2UI it(2); it.valid(); it.next()) {
-            Vec2UI   coord = it();
-            Vec2F    lc2 = lc + Vec2F(coord) * del[0];
-            acc += 
-                sampleRecurse(
-                    sample,
-                    catHoriz(lc2,lc2+del),
-                    vals.subMatrix<2,2>(coord[1],coord[0]), // Matrices are (row,col) not (x,y)
-                    maxDiff*2.0f);
-        }
-        ret = acc * 0.25f;
+    Mat<RgbaF,3,3>  vals(
+            sq.corners[0],
+            sample(lc+delx),
+            sq.corners[1],
+            sample(lc+dely),
+            sq.centre,
+            sample(uc-dely),
+            sq.corners[2],
+            sample(uc-delx),
+            sq.corners[3]);
+    size_t          qq = 0;
+    for (Iter2UI it(2); it.valid(); it.next()) {
+        Vec2UI   coord = it();
+        Vec2F    lc2 = lc + Vec2F(coord) * del[0];
+        SampleSquare &  quad = quads[qq++];
+        quad.bounds = catHoriz(lc2,lc2+del);
+        quad.corners = vals.subMatrix<2,2>(coord[1],coord[0]);  // Matrices are (row,col) not (x,y)
+        quad.centre = sample(centreOf(quad.bounds));
+    }
+}
+
+static
+RgbaF
+sampleRecurse(
+    SampleFunc const &  sample,
+    SampleSquare const & sq,
+    float               maxDiff,
+    uint64 &            rayCount)
+{
+    if (cMaxDiff(sq) > maxDiff) {
+        rayCount += 8;
+        Arr<SampleSquare,4>     quads;
+        subdivide(sample,sq,quads);
+        Arr<RgbaF,4>            vals;
+        for (size_t ii=0; ii<4; ++ii)
+            vals[ii] = sampleRecurse(sample,quads[ii],maxDiff*2.0f,rayCount);
+        return meanOf(vals);
     }
     else
-        ret = (cornerVals[0]+cornerVals[1]+cornerVals[2]+cornerVals[3]) * 0.125f + centre * 0.5f;
+        return leafVal(sq);
+}
+
+// Sample the pixels of 'img' within the given tile. Sample positions depend only on the pixel
+// coordinates and image dimensions, so the results do not depend on how the image is tiled:
+static
+void
+sampleTile(
+    SampleFunc const &  sample,
+    CentreSampleFunc const & centreSample,
+    uint                antiAliasBitDepth,
+    SampleTileStats &   tile,
+    ImgC4F &            sampleLines,        // Working storage
+    ImgC4F &            img)
+{
+    Mat22UI             bnds = tile.boundsIrcs;
+    uint                numCols = bnds[1] - bnds[0] + 1;    // Pixel corner samples per row
+    float               widf = float(img.width()),
+                        hgtf = float(img.height()),
+                        maxDiff = float(1 << (9-antiAliasBitDepth));
+    uint64              rayCount = numCols;
+    sampleLines.resize(numCols,2);
+    for (uint cc=0; cc<numCols; ++cc)
+        sampleLines.xy(cc,0) = 
+            sample(cornerPos(bnds[0]+cc,bnds[2],widf,hgtf));
+    for (uint row=bnds[2]; row<bnds[3]; ++row) {
+        uint            fbit = (row-bnds[2])%2,
+                        sbit = 1-fbit;
+        for (uint cc=0; cc<numCols; ++cc)
+            sampleLines.xy(cc,sbit) = 
+                sample(cornerPos(bnds[0]+cc,row+1,widf,hgtf));
+        rayCount += numCols;
+        for (uint col=bnds[0]; col<bnds[1]; ++col) {
+            uint            cc = col - bnds[0];
+            Mat22F          pixBounds = pixelBounds(col,row,widf,hgtf);
+            Vec2F           centrePos = centreOf(pixBounds);
+            ++rayCount;
+            SampleSquare    sq {
+                pixBounds,
+                Mat<RgbaF,2,2>(
+                    sampleLines.xy(cc,fbit),
+                    sampleLines.xy(cc+1,fbit),
+                    sampleLines.xy(cc,sbit),
+                    sampleLines.xy(cc+1,sbit)),
+                centreSample ? centreSample(centrePos,Vec2UI(col,row)) : sample(centrePos),
+            };
+            img.xy(col,row) = sampleRecurse(sample,sq,maxDiff,rayCount);
+        }
+    }
+    tile.rayCount = rayCount;
+}
+
+uint64
+cRayCount(SampleTileStatss const & tiles)
+{
+    uint64          ret = 0;
+    for (SampleTileStats const & tile : tiles)
+        ret += tile.rayCount;
     return ret;
 }
 
 ImgC4F
 sampleAdaptiveF(
-    Vec2UI           dims,
-    SampleFunc        sample,
-    uint                antiAliasBitDepth)
+    Vec2UI              dims,
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    SampleTileStats *   stats,
+    CentreSampleFunc const & centreSample)
 {
     ImgC4F          img(dims);
     FGASSERT(dims.cmpntsProduct() > 0);
     FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 16));
-    rayCount = (img.width()+1) * (img.height()+1);
-    float               widf = float(img.width()),
-                        hgtf = float(img.height());
-    ImgC4F          sampleLines(img.width()+1,2);
-    for (uint col=0; col<sampleLines.width(); ++col)
-        sampleLines.xy(col,0) = 
-            sample(Vec2F(float(col)/widf,0.0f));
-    for (uint row=0; row<img.height(); ++row) {
-        uint            fbit = row%2,
-                        sbit = 1-fbit;
-        for (uint col=0; col<sampleLines.width(); ++col)
-            sampleLines.xy(col,sbit) = 
-                sample(Vec2F(float(col)/widf,float(row+1)/hgtf));
-        for (uint col=0; col<img.width(); ++col) {
-            img.xy(col,row) =
-                sampleRecurse(
-                    sample,
-                    Mat22F(
-                        float(col)/widf,
-                        float(col+1)/widf,
-                        float(row)/hgtf,
-                        float(row+1)/hgtf),
-                    Mat<RgbaF,2,2>(
-                        sampleLines.xy(col,fbit),
-                        sampleLines.xy(col+1,fbit),
-                        sampleLines.xy(col,sbit),
-                        sampleLines.xy(col+1,sbit)),
-                    float(1 << (9-antiAliasBitDepth)));
-        }
-    }
-    //fgout << "Raycast count: " << rayCount;
+    SampleTileStats     tile {Mat22UI(0,dims[0],0,dims[1])};
+    ImgC4F              sampleLines;
+    sampleTile(sample,centreSample,antiAliasBitDepth,tile,sampleLines,img);
+    if (stats)
+        *stats = tile;
     return img;
 }
 
-ImgC4UC
-sampleAdaptive(
-    Vec2UI           dims,
-    SampleFunc        sample,
-    uint                antiAliasBitDepth)
+ImgC4F
+sampleAdaptiveTiledF(
+    Vec2UI              dims,
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    uint                numThreads,
+    uint                tileSize,
+    SampleTileStatss *  stats,
+    CentreSampleFunc const & centreSample)
 {
-    ImgC4UC         img(dims);
-    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 8));
-    ImgC4F          fimg = sampleAdaptiveF(img.dims(),sample,antiAliasBitDepth);
+    ImgC4F              img(dims);
+    FGASSERT(dims.cmpntsProduct() > 0);
+    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 16));
+    FGASSERT(tileSize > 0);
+    SampleTileStatss    tiles;
+    for (uint yy=0; yy<dims[1]; yy+=tileSize)
+        for (uint xx=0; xx<dims[0]; xx+=tileSize)
+            tiles.push_back(SampleTileStats{Mat22UI(
+                xx,cMin(xx+tileSize,dims[0]),
+                yy,cMin(yy+tileSize,dims[1]))});
+    // Tiles are handed out dynamically as they vary greatly in cost:
+    parallelFor(tiles.size(),[&](size_t tt)
+    {
+        ImgC4F          sampleLines;
+        sampleTile(sample,centreSample,antiAliasBitDepth,tiles[tt],sampleLines,img);
+    },numThreads);
+    if (stats)
+        *stats = tiles;
+    return img;
+}
+
+static
+void
+toUC_(ImgC4F const & fimg,ImgC4UC & img)
+{
+    img.resize(fimg.dims());
     for (Iter2UI it(img.dims()); it.valid(); it.next())
     {
         const RgbaF & fpix = fimg[it()];
@@ -142,9 +256,247 @@ sampleAdaptive(
                 uchar(clampBounds(fpix.blue(),0.0f,255.0f)),
                 uchar(clampBounds(fpix.alpha(),0.0f,255.0f)));
     }
+}
+
+static
+ImgC4UC
+toUC(ImgC4F const & fimg)
+{
+    ImgC4UC         img;
+    toUC_(fimg,img);
     return img;
 }
 
+ImgC4UC
+sampleAdaptive(
+    Vec2UI              dims,
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    SampleTileStats *   stats,
+    CentreSampleFunc const & centreSample)
+{
+    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 8));
+    return toUC(sampleAdaptiveF(dims,sample,antiAliasBitDepth,stats,centreSample));
+}
+
+ImgC4UC
+sampleAdaptiveTiled(
+    Vec2UI              dims,
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    uint                numThreads,
+    uint                tileSize,
+    SampleTileStatss *  stats,
+    CentreSampleFunc const & centreSample)
+{
+    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 8));
+    return toUC(sampleAdaptiveTiledF(dims,sample,antiAliasBitDepth,numThreads,tileSize,stats,centreSample));
+}
+
+void
+sampleAdaptive_(
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    uint                numThreads,
+    SampleBuffers &     buffers,
+    ImgC4UC &           img,
+    CentreSampleFunc const & centreSample)
+{
+    Vec2UI              dims = img.dims();
+    FGASSERT(dims.cmpntsProduct() > 0);
+    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 8));
+    buffers.img.resize(dims);
+    SampleTileStatss &  tiles = buffers.tiles;
+    if (numThreads == 1) {
+        tiles.resize(1);
+        tiles[0] = SampleTileStats{Mat22UI(0,dims[0],0,dims[1])};
+        buffers.lines.resize(1);
+        sampleTile(sample,centreSample,antiAliasBitDepth,tiles[0],buffers.lines[0],buffers.img);
+    }
+    else {
+        // Same tiling as 'sampleAdaptiveTiledF':
+        uint const          tileSize = 32;
+        Vec2UI              numTiles = (dims + Vec2UI(tileSize-1)) / tileSize;
+        tiles.resize(numTiles.cmpntsProduct());
+        buffers.lines.resize(tiles.size());
+        for (Iter2UI it(numTiles); it.valid(); it.next()) {
+            uint            xx = it()[0]*tileSize,
+                            yy = it()[1]*tileSize;
+            tiles[it()[1]*numTiles[0]+it()[0]] = SampleTileStats{Mat22UI(
+                xx,cMin(xx+tileSize,dims[0]),
+                yy,cMin(yy+tileSize,dims[1]))};
+        }
+        parallelFor(tiles.size(),[&](size_t tt)
+        {
+            sampleTile(sample,centreSample,antiAliasBitDepth,tiles[tt],buffers.lines[tt],buffers.img);
+        },numThreads);
+    }
+    toUC_(buffers.img,img);
+}
+
+ProgressiveSampler::ProgressiveSampler(
+    Vec2UI              dims,
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,
+    uint                numThreads,
+    CentreSampleFunc const & centreSample)
+    :
+    m_dims(dims),
+    m_sample(sample),
+    m_numThreads(numThreads),
+    m_cornerVals(dims+Vec2UI(1))
+{
+    FGASSERT(dims.cmpntsProduct() > 0);
+    FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 16));
+    float               widf = float(dims[0]),
+                        hgtf = float(dims[1]),
+                        maxDiff = float(1 << (9-antiAliasBitDepth));
+    m_nodes.resize(dims.cmpntsProduct());
+    parallelFor(dims[1],[&](size_t row)
+    {
+        for (uint col=0; col<dims[0]; ++col) {
+            Node &          node = m_nodes[row*dims[0]+col];
+            node.square.bounds = pixelBounds(col,uint(row),widf,hgtf);
+            Vec2F           centrePos = centreOf(node.square.bounds);
+            node.square.centre = centreSample ? centreSample(centrePos,Vec2UI(col,uint(row))) : sample(centrePos);
+            node.maxDiff = maxDiff;
+            node.weight = 1.0f;
+        }
+    },numThreads);
+    m_rayCount = m_nodes.size();
+}
+
+bool
+ProgressiveSampler::sampleCorners(uint64 maxRays)
+{
+    Vec2UI              cornerDims = m_cornerVals.dims();
+    size_t              total = cornerDims.cmpntsProduct(),
+                        num = cMin(total - m_numCorners,size_t(cornerDims[0])*16);    // Batches of rows
+    if (maxRays > 0) {
+        if (m_rayCount >= maxRays)
+            return false;
+        num = cMin(num,size_t(maxRays - m_rayCount));
+    }
+    float               widf = float(m_dims[0]),
+                        hgtf = float(m_dims[1]);
+    size_t              begin = m_numCorners;
+    parallelFor(num,[&](size_t ii)
+    {
+        size_t          idx = begin + ii;
+        uint            xx = uint(idx % cornerDims[0]),
+                        yy = uint(idx / cornerDims[0]);
+        m_cornerVals.m_data[idx] = m_sample(cornerPos(xx,yy,widf,hgtf));
+    },m_numThreads);
+    m_numCorners += num;
+    m_rayCount += num;
+    // Pixel rows whose lower corners are now all available can be queued for subdivision:
+    uint                numRows = uint(m_numCorners / cornerDims[0]);
+    numRows = (numRows > 0) ? numRows-1 : 0;
+    for (uint row=m_numRows; row<numRows; ++row) {
+        for (uint col=0; col<m_dims[0]; ++col) {
+            uint            idx = row*m_dims[0]+col;
+            Node &          node = m_nodes[idx];
+            node.square.corners = Mat<RgbaF,2,2>(
+                m_cornerVals.xy(col,row),
+                m_cornerVals.xy(col+1,row),
+                m_cornerVals.xy(col,row+1),
+                m_cornerVals.xy(col+1,row+1));
+            float           diff = cMaxDiff(node.square);
+            if (diff > node.maxDiff) {
+                m_heap.push_back({diff,idx});
+                push_heap(m_heap.begin(),m_heap.end());
+            }
+        }
+    }
+    m_numRows = numRows;
+    return (m_numCorners == total);
+}
+
+bool
+ProgressiveSampler::refine(uint64 maxRays,double maxSeconds)
+{
+    Timer               timer;
+    auto                inTime = [&](){return ((maxSeconds <= 0.0) || (timer.read() < maxSeconds)); };
+    while (!sampleCorners(maxRays)) {
+        if (!inTime() || ((maxRays > 0) && (m_rayCount >= maxRays)))
+            return false;
+    }
+    // Batches of subdivisions are done concurrently. The batch size is a trade-off between concurrency
+    // and how closely the largest differences are refined first:
+    size_t              batchSize = 64 * cNumThreads(m_numThreads);
+    Svec<uint>          batch;
+    Svec<Arr<Square,4> >    quadss;
+    while (!m_heap.empty() && inTime()) {
+        size_t              num = cMin(batchSize,m_heap.size());
+        if (maxRays > 0)
+            num = cMin(num,size_t((maxRays - cMin(maxRays,m_rayCount)) / 8));
+        if (num == 0)
+            break;
+        batch.resize(num);
+        for (size_t ii=0; ii<num; ++ii) {
+            pop_heap(m_heap.begin(),m_heap.end());
+            batch[ii] = m_heap.back().second;
+            m_heap.pop_back();
+        }
+        quadss.resize(num);
+        parallelFor(num,[&](size_t ii){subdivide(m_sample,m_nodes[batch[ii]].square,quadss[ii]); },m_numThreads);
+        m_rayCount += 8 * num;
+        for (size_t ii=0; ii<num; ++ii) {
+            uint            children = uint(m_nodes.size());
+            Node            parent = m_nodes[batch[ii]];
+            m_nodes[batch[ii]].children = children;
+            for (Square const & quad : quadss[ii]) {
+                Node            child;
+                child.square = quad;
+                child.maxDiff = parent.maxDiff * 2.0f;
+                child.weight = parent.weight * 0.25f;
+                float           diff = cMaxDiff(quad);
+                if (diff > child.maxDiff) {
+                    // Prioritize by the potential error in the pixel value:
+                    m_heap.push_back({diff*child.weight,uint(m_nodes.size())});
+                    push_heap(m_heap.begin(),m_heap.end());
+                }
+                m_nodes.push_back(child);
+            }
+        }
+    }
+    return converged();
+}
+
+bool
+ProgressiveSampler::converged() const
+{return ((m_numRows == m_dims[1]) && m_heap.empty()); }
+
+// Same arithmetic as 'sampleRecurse' so the converged result is identical:
+RgbaF
+ProgressiveSampler::nodeVal(uint idx) const
+{
+    Node const &        node = m_nodes[idx];
+    if (node.children == 0)
+        return leafVal(node.square);
+    Arr<RgbaF,4>        vals;
+    for (uint ii=0; ii<4; ++ii)
+        vals[ii] = nodeVal(node.children+ii);
+    return meanOf(vals);
+}
+
+ImgC4F
+ProgressiveSampler::imageF() const
+{
+    ImgC4F              ret(m_dims);
+    for (uint row=0; row<m_dims[1]; ++row) {
+        for (uint col=0; col<m_dims[0]; ++col) {
+            uint            idx = row*m_dims[0]+col;
+            ret.m_data[idx] = (row < m_numRows) ? nodeVal(idx) : m_nodes[idx].square.centre;
+        }
+    }
+    return ret;
+}
+
+ImgC4UC
+ProgressiveSampler::image() const
+{return toUC(imageF()); }
+
 static
 RgbaF
 halfMoon(Vec2F ics)
@@ -181,12 +533,54 @@ mandelbrot(Vec2F ics)
     return RgbaF(float(ii));
 }
 
+static
+double
+meanAbsDiff(ImgC4F const & img0,ImgC4F const & img1)
+{
+    double              acc = 0.0;
+    for (size_t ii=0; ii<img0.numPixels(); ++ii)
+        acc += fgSumElems(mapAbs(img0.m_data[ii].m_c - img1.m_data[ii].m_c));
+    return acc / double(img0.numPixels());
+}
+
+void
+testSampler(CLArgs const &)
+{
+    Vec2UI              dims(96,64);
+    for (uint aaDepth : {3U,5U}) {
+        SampleTileStats     stats;
+        ImgC4F              img = sampleAdaptiveF(dims,mandelbrot,aaDepth,&stats);
+        ProgressiveSampler  full(dims,mandelbrot,aaDepth);
+        FGASSERT(full.refine());
+        FGASSERT(full.imageF().m_data == img.m_data);
+        FGASSERT(full.rayCount() == stats.rayCount);
+        // A partial refinement should stay within budget and be closer than the initial image:
+        ProgressiveSampler  prog(dims,mandelbrot,aaDepth,1);
+        double              err0 = meanAbsDiff(prog.imageF(),img);
+        uint64              budget = stats.rayCount / 2;
+        FGASSERT(!prog.refine(budget));
+        FGASSERT(prog.rayCount() <= budget);
+        double              err1 = meanAbsDiff(prog.imageF(),img);
+        fgout << fgnl << "Progressive mean error at " << prog.rayCount() << " of " << stats.rayCount
+            << " rays: " << err1 << " (initial " << err0 << ")";
+        FGASSERT(err1 < err0);
+        FGASSERT(prog.refine());
+        FGASSERT(prog.imageF().m_data == img.m_data);
+    }
+}
+
 void
 fgSamplerMLTest(CLArgs const &)
 {
-    Timer         time;
-    ImgC4UC     img = sampleAdaptive(Vec2UI(1024),mandelbrot,3);
-    fgout << "Time: " << time.read() << "s";
+    Timer               time;
+    SampleTileStats     stats;
+    ImgC4UC             img = sampleAdaptive(Vec2UI(1024),mandelbrot,3,&stats);
+    fgout << fgnl << "Serial time: " << time.read() << "s rays: " << stats.rayCount;
+    time.start();
+    SampleTileStatss    tiles;
+    ImgC4UC             imgT = sampleAdaptiveTiled(Vec2UI(1024),mandelbrot,3,0,32,&tiles);
+    fgout << fgnl << "Tiled time: " << time.read() << "s rays: " << cRayCount(tiles);
+    FGASSERT(imgT.m_data == img.m_data);
     imgDisplay(img);
 }
 
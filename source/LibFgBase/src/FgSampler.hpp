@@ -15,17 +15,152 @@ namespace Fg {
 // Accepts a sample coordinate in IUCS and computes the image color at that point:
 typedef std::function<RgbaF(Vec2F)>  SampleFunc;
 
+// As above for the first sample of each pixel, which is at its centre, also given the pixel coordinates.
+// Allows per-pixel data to be recorded during sampling:
+typedef std::function<RgbaF(Vec2F,Vec2UI)>  CentreSampleFunc;
+
+// Sampling statistics for a rectangular block of pixels:
+struct  SampleTileStats
+{
+    Mat22UI             boundsIrcs;         // Pixel bounds of the tile, upper bounds exclusive
+    uint64              rayCount = 0;       // Number of calls made to the sample function
+
+    SampleTileStats() {}
+    explicit SampleTileStats(Mat22UI b) : boundsIrcs(b) {}
+};
+typedef Svec<SampleTileStats>   SampleTileStatss;
+
+uint64
+cRayCount(SampleTileStatss const &);
+
 ImgC4F
 sampleAdaptiveF(
     Vec2UI              dims,               // Must be non-zero
-    SampleFunc          sample,
-    uint                antiAliasBitDepth); // Must be in [1,16]
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,  // Must be in [1,16]
+    SampleTileStats *   stats=nullptr,      // If non-null, single tile statistics are RETURNED here
+    // If defined, used instead of 'sample' for pixel centres:
+    CentreSampleFunc const & centreSample=CentreSampleFunc());
+
+// As above but the image is split into square tiles which are sampled concurrently,
+// so 'sample' must be thread-safe. The result is identical to that of the serial version:
+ImgC4F
+sampleAdaptiveTiledF(
+    Vec2UI              dims,               // Must be non-zero
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,  // Must be in [1,16]
+    uint                numThreads=0,       // 0 - use all hardware threads
+    uint                tileSize=32,        // Width and height of tiles in pixels (edge tiles can be smaller)
+    SampleTileStatss *  stats=nullptr,      // If non-null, per-tile statistics are RETURNED here in raster order
+    CentreSampleFunc const & centreSample=CentreSampleFunc());  // Must also be thread-safe
 
 ImgC4UC
 sampleAdaptive(
     Vec2UI              dims,               // Must be non-zero
-    SampleFunc          sample,
-    uint                antiAliasBitDepth); // Must be in [1,8]
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,  // Must be in [1,8]
+    SampleTileStats *   stats=nullptr,
+    CentreSampleFunc const & centreSample=CentreSampleFunc());
+
+ImgC4UC
+sampleAdaptiveTiled(
+    Vec2UI              dims,               // Must be non-zero
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,  // Must be in [1,8]
+    uint                numThreads=0,       // 0 - use all hardware threads
+    uint                tileSize=32,
+    SampleTileStatss *  stats=nullptr,
+    CentreSampleFunc const & centreSample=CentreSampleFunc());
+
+// Working storage for 'sampleAdaptive_' which can be kept between calls:
+struct  SampleBuffers
+{
+    ImgC4F              img;
+    Svec<ImgC4F>        lines;              // By tile
+    SampleTileStatss    tiles;              // Statistics of the last use
+};
+
+// As 'sampleAdaptive' if 'numThreads' is 1, otherwise as 'sampleAdaptiveTiled' with 32 pixel tiles, but sampling
+// into 'img', whose dimensions must already be set. No heap allocation is done by the serial version once
+// 'buffers' has been used for the same image size:
+void
+sampleAdaptive_(
+    SampleFunc const &  sample,
+    uint                antiAliasBitDepth,  // Must be in [1,8]
+    uint                numThreads,         // 0 - use all hardware threads
+    SampleBuffers &     buffers,
+    ImgC4UC &           img,
+    CentreSampleFunc const & centreSample=CentreSampleFunc());
+
+// Progressive adaptive sampling for when the cost must be bounded. Construction takes one sample at the centre
+// of each pixel, after which 'refine' takes the remaining pixel corner samples then recursively subdivides
+// the pixel regions with the largest sample differences first, so it can be stopped at any point and
+// the current image retrieved. Once converged the image is identical to that of 'sampleAdaptiveF'.
+// Sample values are retained for refinement so memory use is about 100 bytes per pixel plus 400 bytes per
+// subdivision:
+class   ProgressiveSampler
+{
+public:
+    ProgressiveSampler(
+        Vec2UI              dims,               // Must be non-zero
+        SampleFunc const &  sample,             // Must be thread-safe if 'numThreads' is not 1
+        uint                antiAliasBitDepth,  // Must be in [1,16]
+        uint                numThreads=0,       // 0 - use all hardware threads
+        // If defined, used instead of 'sample' for pixel centres:
+        CentreSampleFunc const & centreSample=CentreSampleFunc());
+
+    // Refine until converged, or until another batch of samples would take the total ray count over 'maxRays',
+    // or 'maxSeconds' have elapsed in this call (0 - no limit for either). The total includes the pixel centre
+    // samples taken on construction, so nothing is refined if 'maxRays' is not larger. Returns true if converged:
+    bool
+    refine(uint64 maxRays=0,double maxSeconds=0.0);
+
+    bool
+    converged() const;
+
+    uint64
+    rayCount() const
+    {return m_rayCount; }
+
+    // Current estimate of the image. Pixels whose corner samples have not yet been taken use the centre sample:
+    ImgC4F
+    imageF() const;
+
+    ImgC4UC
+    image() const;
+
+    // Corners are in raster order, same as Mat22F, and shared between neighbouring squares:
+    struct  Square
+    {
+        Mat22F              bounds;
+        Mat<RgbaF,2,2>      corners;
+        RgbaF               centre;
+    };
+
+private:
+    struct  Node
+    {
+        Square              square;
+        float               maxDiff;        // Threshold for subdivision, doubled at each level
+        float               weight;         // Area relative to the pixel
+        uint                children = 0;   // Index of first of 4 consecutive children, 0 for a leaf
+    };
+    Vec2UI                  m_dims;
+    SampleFunc              m_sample;
+    uint                    m_numThreads;
+    uint64                  m_rayCount = 0;
+    ImgC4F                  m_cornerVals;   // Pixel corner samples, ('m_dims' + 1) in size
+    size_t                  m_numCorners = 0;   // Number taken so far in raster order
+    uint                    m_numRows = 0;  // Number of pixel rows whose corner samples have all been taken
+    Svec<Node>              m_nodes;        // Pixel roots first in raster order, then subdivisions
+    Svec<std::pair<float,uint> >    m_heap; // Priority and index of nodes awaiting subdivision
+
+    bool
+    sampleCorners(uint64 maxRays);
+
+    RgbaF
+    nodeVal(uint idx) const;
+};
 
 }
 
@@ -20,71 +20,95 @@
 #include "FgMain.hpp"
 #include "FgCommand.hpp"
 #include "FgImgDisplay.hpp"
+#include "FgParallel.hpp"
+#include "FgRasterizer.hpp"
+#include "Fg3dMeshOps.hpp"
+#include "FgImageIo.hpp"
+#include "FgSyntax.hpp"
+#include "FgSystemInfo.hpp"
+#include "FgBuild.hpp"
 
 using namespace std;
 using namespace std::placeholders;
 
 namespace Fg {
 
-ImgC4UC
-renderSoft(
-    Vec2UI                  pxSz,
-    Meshes const &          meshes,
-    SimilarityD             modelview,
-    AffineEw2D              itcsToIucs,
-    RenderOptions const &   options)
+static
+ProjectedSurfPoint
+projectSurfPoint(RayCaster const & rc,size_t mm,size_t ss,size_t ii)
 {
-    ImgC4UC             img;
-    VecF2               colorBounds = cBounds(options.backgroundColor.m_c.m);
-    FGASSERT((colorBounds[0] >= 0.0f) && (colorBounds[1] <= 255.0f));
-    RayCaster           rc(meshes,modelview,itcsToIucs,
-        options.lighting,options.backgroundColor,options.useMaps,options.allShiny);
-    // The 'cref' for the 'rc' arg is critical; otherwise 'rc' gets copied on every call:
-    img = sampleAdaptive(pxSz,bind(&RayCaster::cast,cref(rc),_1),options.antiAliasBitDepth);
-
-    // Calculate where the surface points land:
-    ProjectedSurfPoints    spps;
-    for (size_t mm=0; mm<meshes.size(); ++mm) {
-        Mesh const &        mesh = meshes[mm];
-        Vec3Fs const &      verts = rc.vertss[mm];
-        MeshNormals const & norms = rc.normss[mm];
-        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
-            Surf const &        surf = mesh.surfaces[ss];
-            for (size_t ii=0; ii<surf.surfPoints.size(); ++ii) {
-                SurfPoint const &   sp = surf.surfPoints[ii];
-                ProjectedSurfPoint     spp;
-                spp.label = sp.label;
-                Vec3F               spOecs = surf.surfPointPos(verts,ii),
-                                    spNorm = norms.facet[ss].triEquiv(sp.triEquivIdx);
-                spp.visible = (cDot(spOecs,spNorm) < 0);           // Point is camera-facing
-                Vec3F               spIucs = rc.oecsToIucs(spOecs);
-                spp.posIucs = Vec2F(spIucs[0],spIucs[1]);
-                if (spIucs[2] > 0) {                                // Point is in front of the camera
-                    BestN<float,RayCaster::Intersect,4>  intscts = rc.closestIntersects(Vec2F(spIucs[0],spIucs[1]));
-                    if (!intscts.empty()) {                         // Point is in view of camaera
-                        RayCaster::Intersect  intsct = intscts[0].second;     // First is closest
-                        if ((intsct.triInd.meshIdx != mm) ||
-                            (intsct.triInd.surfIdx != ss) ||
-                            (intsct.triInd.triIdx != sp.triEquivIdx)) {         // Point is occluded
-                            spp.visible = false;
-                        }
-                    }
-                    else
-                        spp.visible = false;
-                }
-                else
-                    spp.visible = false;
-                spps.push_back(spp);
+    Surf const &        surf = (*rc.rcMeshes->surfsPtrs[mm])[ss];
+    SurfPoint const &   sp = surf.surfPoints[ii];
+    ProjectedSurfPoint  spp;
+    spp.label = sp.label;
+    Vec3F               spOecs = surf.surfPointPos(rc.vertss[mm],ii),
+                        spNorm = rc.normss[mm].facet[ss].triEquiv(sp.triEquivIdx);
+    spp.visible = (cDot(spOecs,spNorm) < 0);           // Point is camera-facing
+    Vec3F               spIucs = rc.oecsToIucs(spOecs);
+    spp.posIucs = Vec2F(spIucs[0],spIucs[1]);
+    if (spIucs[2] > 0) {                                // Point is in front of the camera
+        RayCaster::Intersects   intscts = rc.closestIntersects(Vec2F(spIucs[0],spIucs[1]));
+        if (!intscts.empty()) {                         // Point is in view of camaera
+            RayCaster::Intersect  intsct = intscts[0].second;     // First is closest
+            if ((intsct.triInd.meshIdx != mm) ||
+                (intsct.triInd.surfIdx != ss) ||
+                (intsct.triInd.triIdx != sp.triEquivIdx)) {         // Point is occluded
+                spp.visible = false;
             }
         }
+        else
+            spp.visible = false;
     }
-    if (options.projSurfPoints)
-        *options.projSurfPoints = spps;
-    
-    // Paint surface points on image:
-    if (options.renderSurfPoints != RenderSurfPoints::never) {
+    else
+        spp.visible = false;
+    return spp;
+}
+
+// Uses the screen-space index already set up in 'rc' for rendering. 'spps' is overwritten, re-using its storage:
+static
+void
+projectSurfPoints_(RayCaster const & rc,uint numThreads,ProjectedSurfPoints & spps)
+{
+    Svec<Surfs const *> const & surfsPtrs = rc.rcMeshes->surfsPtrs;
+    size_t              num = 0;
+    for (Surfs const * surfs : surfsPtrs)
+        for (Surf const & surf : *surfs)
+            num += surf.surfPoints.size();
+    spps.resize(num);
+    // Each point costs only one ray cast so they are handed out in blocks, each of which walks the
+    // surfaces to find its range of points in mesh, surface, point order:
+    size_t const        blockSize = 64;
+    auto                projectBlock = [&](size_t bb)
+    {
+        size_t              lo = bb * blockSize,
+                            hi = cMin(lo+blockSize,num),
+                            base = 0;
+        for (size_t mm=0; mm<surfsPtrs.size(); ++mm) {
+            Surfs const &       surfs = *surfsPtrs[mm];
+            for (size_t ss=0; ss<surfs.size(); ++ss) {
+                size_t              sz = surfs[ss].surfPoints.size();
+                for (size_t ii=cMax(lo,base); ii<cMin(hi,base+sz); ++ii)
+                    spps[ii] = projectSurfPoint(rc,mm,ss,ii-base);
+                base += sz;
+            }
+        }
+    };
+    size_t              numBlocks = (num + blockSize - 1) / blockSize;
+    // Call directly when serial to avoid the 'std::function' allocation:
+    if ((numBlocks < 2) || (cNumThreads(numThreads) == 1))
+        for (size_t bb=0; bb<numBlocks; ++bb)
+            projectBlock(bb);
+    else
+        parallelFor(numBlocks,projectBlock,numThreads);
+}
+
+static
+void
+paintSurfPoints(ProjectedSurfPoints const & spps,RenderSurfPoints rsp,ImgC4UC & img)
+{
+    if (rsp != RenderSurfPoints::never) {
         for (const ProjectedSurfPoint & spp : spps) {
-            if (spp.visible || (options.renderSurfPoints == RenderSurfPoints::always)) {
+            if (spp.visible || (rsp == RenderSurfPoints::always)) {
                 Vec2F        p = spp.posIucs;
                 p[0] *= img.width();
                 p[1] *= img.height();
@@ -93,6 +117,246 @@ renderSoft(
             }
         }
     }
+}
+
+static
+RenderAuxImages
+initAuxImages(Vec2UI pxSz)
+{
+    RenderAuxImages     ret;
+    ret.invDepth.resize(pxSz,0.0f);
+    ret.normal.resize(pxSz,Vec3F(0));
+    ret.triInd.resize(pxSz);
+    ret.uv.resize(pxSz,Vec2F(0));
+    return ret;
+}
+
+// Pixels are each set by only one thread:
+static
+void
+setAuxPixel(RayCaster const & rc,Vec2UI px,RayCaster::Intersects const & best,RenderAuxImages & aux)
+{
+    if (best.empty())
+        return;
+    TriInd              ti = best[0].second.triInd;
+    Vec3F               bc(best[0].second.barycentric);
+    Tris const &        tris = rc.rcMeshes->trisss[ti.meshIdx][ti.surfIdx];
+    Vec3UI              vis = tris.posInds[ti.triIdx];
+    Vec3Fs const &      norms = rc.normss[ti.meshIdx].vert;
+    aux.invDepth[px] = best[0].first;
+    aux.normal[px] = normalize(bc[0]*norms[vis[0]] + bc[1]*norms[vis[1]] + bc[2]*norms[vis[2]]);
+    aux.triInd[px] = ti;
+    Vec2Fs const &      uvs = *rc.rcMeshes->uvsPtrs[ti.meshIdx];
+    if (!tris.uvInds.empty() && !uvs.empty()) {
+        Vec3UI              uvInds = tris.uvInds[ti.triIdx];
+        aux.uv[px] = bc[0]*uvs[uvInds[0]] + bc[1]*uvs[uvInds[1]] + bc[2]*uvs[uvInds[2]];
+    }
+}
+
+// Sample the image and project the surface points for an already set up ray caster.
+// The ray cast samplers write into 'img' and 'buffers' without reallocating once they have been used:
+static
+void
+renderFrame_(
+    RayCaster const &       rc,
+    RenderOptions const &   options,
+    uint                    numThreads,     // 1 - use the serial sampler
+    SampleBuffers &         buffers,        // Working storage. Per-tile statistics RETURNED in 'tiles'
+    ProjectedSurfPoints &   spps,           // RETURNED if requested or painted, otherwise cleared
+    RenderAuxImages *       aux,            // If non-null, RETURNED
+    ImgC4UC &               img)            // Dimensions must be set
+{
+    Vec2UI              pxSz = img.dims();
+    // A lambda capturing only a reference is stored within 'std::function' without a heap allocation,
+    // and avoids copying 'rc' on every call:
+    SampleFunc          sample = [&rc](Vec2F posIucs) {return rc.cast(posIucs); };
+    CentreSampleFunc    centreSample;
+    CentreIntersectsFunc centreIntersects;
+    if (aux) {
+        *aux = initAuxImages(pxSz);
+        centreSample = [&](Vec2F pos,Vec2UI px)
+        {
+            RayCaster::Intersects   best = rc.closestIntersects(pos);
+            setAuxPixel(rc,px,best,*aux);
+            return rc.shade(best);
+        };
+        centreIntersects = [&](Vec2UI px,RayCaster::Intersects const & best) {setAuxPixel(rc,px,best,*aux); };
+    }
+    if (options.backend == RenderBackend::raster)
+        img = rasterize(pxSz,rc,options.rasterSamplesDim,numThreads,&buffers.tiles,centreIntersects);
+    else if ((options.maxRays > 0) || (options.maxSeconds > 0.0)) {
+        ProgressiveSampler  sampler(pxSz,sample,options.antiAliasBitDepth,numThreads,centreSample);
+        sampler.refine(options.maxRays,options.maxSeconds);
+        img = sampler.image();
+        buffers.tiles = {SampleTileStats{Mat22UI(0,pxSz[0],0,pxSz[1])}};
+        buffers.tiles[0].rayCount = sampler.rayCount();
+    }
+    else
+        sampleAdaptive_(sample,options.antiAliasBitDepth,numThreads,buffers,img,centreSample);
+    if (options.projSurfPoints || (options.renderSurfPoints != RenderSurfPoints::never))
+        projectSurfPoints_(rc,numThreads,spps);
+    else
+        spps.clear();
+    paintSurfPoints(spps,options.renderSurfPoints,img);
+}
+
+static
+Vec2F
+cIucsPerPixel(Vec2UI pxSz)
+{return Vec2F(1.0f / float(pxSz[0]),1.0f / float(pxSz[1])); }
+
+static
+void
+checkOptions(RenderOptions const & options)
+{
+    VecF2               colorBounds = cBounds(options.backgroundColor.m_c.m);
+    FGASSERT((colorBounds[0] >= 0.0f) && (colorBounds[1] <= 255.0f));
+}
+
+ImgC4UC
+renderSoft(
+    Vec2UI                  pxSz,
+    Meshes const &          meshes,
+    SimilarityD             modelview,
+    AffineEw2D              itcsToIucs,
+    RenderOptions const &   options)
+{
+    RenderContext       context;
+    context.setMeshes(meshes,options.mipmap);
+    ImgC4UC             img(pxSz);
+    renderSoft_(context,modelview,itcsToIucs,options,img);
+    return img;
+}
+
+void
+RenderContext::setMeshes(Meshes const & meshes,bool mipmap)
+{
+    rcMeshes = make_shared<RayCastMeshes>(meshes,mipmap);
+    rayCaster.reset();
+}
+
+void
+renderSoft_(
+    RenderContext &         context,
+    SimilarityD             modelview,
+    AffineEw2D              itcsToIucs,
+    RenderOptions const &   options,
+    ImgC4UC &               img)
+{
+    checkOptions(options);
+    FGASSERT(context.rcMeshes);
+    FGASSERT(img.numPixels() > 0);
+    Sptr<RayCaster> &   rc = context.rayCaster;
+    if (rc) {
+        rc->lighting = options.lighting;
+        rc->background = options.backgroundColor;
+        rc->useMaps = options.useMaps;
+        rc->allShiny = options.allShiny;
+        rc->accel = options.rayCastAccel;
+        rc->setCamera(modelview,itcsToIucs);
+    }
+    else
+        rc = make_shared<RayCaster>(context.rcMeshes,modelview,itcsToIucs,
+            options.lighting,options.backgroundColor,options.useMaps,options.allShiny,options.rayCastAccel);
+    rc->iucsPerPixel = cIucsPerPixel(img.dims());
+    renderFrame_(*rc,options,options.numThreads,context.buffers,context.surfPoints,options.auxImages.get(),img);
+    if (options.projSurfPoints)
+        *options.projSurfPoints = context.surfPoints;
+    if (options.sampleStats)
+        *options.sampleStats = context.buffers.tiles;
+}
+
+ImgC4UCs
+renderSoft(
+    Vec2UI                  pxSz,
+    Meshes const &          meshes,
+    RenderXforms const &    xforms,
+    RenderOptions const &   options)
+{
+    checkOptions(options);
+    Sptr<RayCastMeshes const> rcMeshes = make_shared<RayCastMeshes>(meshes,options.mipmap);
+    size_t              numFrames = xforms.size();
+    uint                numThreads = cNumThreads(options.numThreads);
+    ImgC4UCs            imgs(numFrames);
+    Svec<ProjectedSurfPoints> sppss(numFrames);
+    SampleTileStatss    tiles;
+    // Parallelize over frames if there are enough of them, otherwise over the tiles of each frame:
+    bool                parallelFrames = (numFrames >= numThreads);
+    auto                render = [&](size_t ff)
+    {
+        RenderXform const & xf = xforms[ff];
+        RayCaster           rc(rcMeshes,xf.modelview,xf.itcsToIucs,
+            options.lighting,options.backgroundColor,options.useMaps,options.allShiny,options.rayCastAccel);
+        rc.iucsPerPixel = cIucsPerPixel(pxSz);
+        SampleBuffers       buffers;
+        bool                last = (ff+1 == numFrames);
+        imgs[ff].resize(pxSz);
+        renderFrame_(rc,options,parallelFrames ? 1 : numThreads,buffers,sppss[ff],
+            last ? options.auxImages.get() : nullptr,imgs[ff]);
+        if (last)
+            tiles = buffers.tiles;
+    };
+    if (parallelFrames)
+        parallelFor(numFrames,render,numThreads);
+    else
+        for (size_t ff=0; ff<numFrames; ++ff)
+            render(ff);
+    if (options.projSurfPoints && !sppss.empty())
+        *options.projSurfPoints = sppss.back();
+    if (options.sampleStats)
+        *options.sampleStats = tiles;
+    return imgs;
+}
+
+RenderVisibility
+renderVisibility(
+    Vec2UI                  pxSz,
+    Meshes const &          meshes,
+    SimilarityD             modelview,
+    AffineEw2D              itcsToIucs,
+    RenderOptions const &   options)
+{
+    checkOptions(options);
+    Sptr<RayCaster>     rc = make_shared<RayCaster>(make_shared<RayCastMeshes>(meshes,options.mipmap),
+        modelview,itcsToIucs,options.lighting,options.backgroundColor,options.useMaps,options.allShiny,
+        options.rayCastAccel);
+    rc->iucsPerPixel = cIucsPerPixel(pxSz);
+    RenderVisibility    ret;
+    ret.rayCaster = rc;
+    ret.buffer = rasterizeVisibility(pxSz,*rc,options.rasterSamplesDim,options.numThreads);
+    projectSurfPoints_(*rc,options.numThreads,ret.surfPoints);
+    if (options.auxImages) {
+        *options.auxImages = initAuxImages(pxSz);
+        forCentreIntersects(ret.buffer,[&](Vec2UI px,RayCaster::Intersects const & best)
+        {setAuxPixel(*rc,px,best,*options.auxImages); });
+    }
+    if (options.projSurfPoints)
+        *options.projSurfPoints = ret.surfPoints;
+    return ret;
+}
+
+ProjectedSurfPoints
+projectSurfPoints(
+    Meshes const &          meshes,
+    SimilarityD             modelview,
+    AffineEw2D              itcsToIucs,
+    uint                    numThreads)
+{
+    // Only the closest intersects are needed so the shading parameters are irrelevant and no mipmaps are built:
+    RayCaster           rc(make_shared<RayCastMeshes>(meshes,false),modelview,itcsToIucs,Lighting(),RgbaF(0));
+    ProjectedSurfPoints ret;
+    projectSurfPoints_(rc,numThreads,ret);
+    return ret;
+}
+
+ImgC4UC
+renderShade(RenderVisibility const & vis,RenderOptions const & options)
+{
+    checkOptions(options);
+    FGASSERT(vis.rayCaster);
+    ImgC4UC             img = shadeVisibility(vis.buffer,*vis.rayCaster,
+        options.lighting,options.backgroundColor,options.useMaps,options.allShiny,options.numThreads);
+    paintSurfPoints(vis.surfPoints,options.renderSurfPoints,img);
     return img;
 }
 
@@ -119,6 +383,7 @@ testSoftRender(CLArgs const &)
     SimilarityD     modelview;      // Default is identity
     AffineEw2D      itcsToIucs(Vec2D(0.5),Vec2D(0.5));
     RenderOptions   ro;
+    ro.mipmap = false;              // Regression images are of full resolution map sampling
 
     // Model a single triangle of equal width and height intersected by the optical axis in OECS at the barycentric centre:
     mesh.verts = { {-1,1.5,-4}, {-1,-1.5,-4}, {2,0,-4} };
@@ -158,8 +423,296 @@ testSoftRender(CLArgs const &)
     modelview = SimilarityD(Vec3D(0,0,-4)) * SimilarityD(cRotateY(1.0)) * SimilarityD(Vec3D(0,0,4));
     img = renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro);
     regressTestApprox<ImgC4UC>(img,"t2.png",bind(fgImgApproxEqual,_1,_2,2U));
+    // Tiled multithreaded sampling must give exactly the same image as serial:
+    ro.numThreads = 1;
+    ImgC4UC     imgSerial = renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro);
+    ro.numThreads = 4;
+    ro.sampleStats = make_shared<SampleTileStatss>();
+    FGASSERT(renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro).m_data == imgSerial.m_data);
+    FGASSERT(ro.sampleStats->size() == 64);
+    // A sufficient ray budget gives the same image progressively, otherwise the budget is respected:
+    ro.maxRays = 1 << 30;
+    FGASSERT(renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro).m_data == imgSerial.m_data);
+    uint64          numRays = cRayCount(*ro.sampleStats);
+    ro.maxRays = numRays / 2;
+    renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro);
+    FGASSERT(cRayCount(*ro.sampleStats) <= numRays/2);
+    ro.maxRays = 0;
+    // Batch rendering shares the camera-independent setup but must give the same images:
+    RenderXforms    xforms {
+        RenderXform{SimilarityD(),itcsToIucs},
+        RenderXform{modelview,itcsToIucs},
+    };
+    ImgC4UCs        imgs = renderSoft(Vec2UI(256),meshes,xforms,ro);
+    FGASSERT(imgs.size() == 2);
+    FGASSERT(imgs[1].m_data == imgSerial.m_data);
+    ro.numThreads = 1;
+    FGASSERT(renderSoft(Vec2UI(256),meshes,xforms,ro)[1].m_data == imgSerial.m_data);
+    ro.numThreads = 2;                      // Frames in parallel
+    FGASSERT(renderSoft(Vec2UI(256),meshes,xforms,ro)[1].m_data == imgSerial.m_data);
+    // A context re-used across views, accelerations and threading must give the same images as new renders:
+    RenderContext   context;
+    context.setMeshes(meshes,ro.mipmap);
+    for (RayCastAccel accel : {RayCastAccel::grid,RayCastAccel::bvh}) {
+        ro.rayCastAccel = accel;
+        for (uint nt : {1U,4U}) {
+            ro.numThreads = nt;
+            for (RenderXform const & xf : xforms) {
+                ImgC4UC         imgCtx(256,256);
+                renderSoft_(context,xf.modelview,xf.itcsToIucs,ro,imgCtx);
+                FGASSERT(imgCtx.m_data == renderSoft(Vec2UI(256),meshes,xf,ro).m_data);
+            }
+        }
+    }
+    ro.rayCastAccel = RayCastAccel::grid;
+    ro.numThreads = 1;
+    // Standalone concurrent projection of many surface points must match the serial projection of a render:
+    SurfPoints      surfPointsOrig = surf.surfPoints;
+    uint const      nn = 30;
+    for (uint tt=0; tt<2; ++tt)
+        for (uint aa=0; aa<=nn; ++aa)
+            for (uint bb=0; aa+bb<=nn; ++bb)
+                surf.surfPoints.emplace_back(tt,Vec3F(aa,bb,nn-aa-bb)/float(nn));
+    for (size_t ii=0; ii<surf.surfPoints.size(); ++ii)
+        surf.surfPoints[ii].label = toStr(ii);
+    ro.projSurfPoints = make_shared<ProjectedSurfPoints>();
+    for (RenderXform const & xf : xforms) {
+        renderSoft(Vec2UI(256),meshes,xf,ro);
+        ProjectedSurfPoints const & sppsRender = *ro.projSurfPoints;
+        ProjectedSurfPoints sppsStandalone = projectSurfPoints(meshes,xf.modelview,xf.itcsToIucs,4);
+        FGASSERT(sppsStandalone.size() == surf.surfPoints.size());
+        FGASSERT(sppsRender.size() == sppsStandalone.size());
+        size_t          numVisible = 0;
+        for (size_t ii=0; ii<sppsStandalone.size(); ++ii) {
+            ProjectedSurfPoint const & sr = sppsRender[ii],
+                                     & ss = sppsStandalone[ii];
+            FGASSERT(ss.label == surf.surfPoints[ii].label);
+            FGASSERT((sr.label == ss.label) && (sr.posIucs == ss.posIucs) && (sr.visible == ss.visible));
+            if (ss.visible)
+                ++numVisible;
+        }
+        FGASSERT(numVisible > sppsStandalone.size()/2);
+    }
+    ro.projSurfPoints.reset();
+    surf.surfPoints = surfPointsOrig;
+    // Rasterization uses the same shading so only the anti-aliasing of edges should differ:
+    ro.backend = RenderBackend::raster;
+    ro.rasterSamplesDim = 4;
+    for (uint nt : {1U,4U}) {
+        ro.numThreads = nt;
+        ImgC4UC         imgRaster = renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro);
+        FGASSERT(imgRaster.dims() == imgSerial.dims());
+        double          meanDiff = 0;
+        for (size_t ii=0; ii<imgRaster.numPixels(); ++ii)
+            meanDiff += cMag(Vec4D(imgRaster.m_data[ii].m_c) - Vec4D(imgSerial.m_data[ii].m_c));
+        meanDiff = sqrt(meanDiff / imgRaster.numPixels());
+        FGASSERT(meanDiff < 8.0);
+    }
+    // Shading a visibility buffer must give the same image as a raster render, including when re-shaded:
+    RenderVisibility vis = renderVisibility(Vec2UI(256),meshes,modelview,itcsToIucs,ro);
+    FGASSERT(renderShade(vis,ro).m_data == renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,ro).m_data);
+    RenderOptions   roRelit = ro;
+    roRelit.lighting = Lighting(Vec3F(0.1f),Light(Vec3F(0.5f,0.7f,0.9f),normalize(Vec3F(1,1,1))));
+    roRelit.backgroundColor = RgbaF(0,0,64,255);
+    roRelit.allShiny = true;
+    FGASSERT(renderShade(vis,roRelit).m_data == renderSoft(Vec2UI(256),meshes,modelview,itcsToIucs,roRelit).m_data);
+    // A finely checkered map minified to a few pixels per hundred texels should be filtered to a uniform
+    // grey by mipmapping rather than aliased, which should also reduce the adaptive sampling:
+    ro.backend = RenderBackend::rayCast;
+    ro.numThreads = 1;
+    ro.renderSurfPoints = RenderSurfPoints::never;
+    ImgC4UC         fine(512,512);
+    for (Iter2UI it(fine.dims()); it.valid(); it.next())
+        fine[it()] = ((it()[0] + it()[1]) & 1) ? RgbaUC(0,0,0,255) : RgbaUC(255,255,255,255);
+    surf.material.albedoMap = make_shared<ImgC4UC>(fine);
+    Mat22UI         interior(28,40,24,40);      // Pixels well within the square
+    Uints           ranges;
+    Svec<uint64>    rays;
+    for (bool mipmap : {false,true}) {
+        ro.mipmap = mipmap;
+        ImgC4UC         imgFine = renderSoft(Vec2UI(64),meshes,SimilarityD(),itcsToIucs,ro);
+        Uints           reds;
+        for (Iter2UI it(interior); it.valid(); it.next())
+            reds.push_back(imgFine[it()].red());
+        Mat<uint,1,2>   bounds = cBounds(reds);
+        ranges.push_back(bounds[1] - bounds[0]);
+        rays.push_back(cRayCount(*ro.sampleStats));
+    }
+    fgout << fgnl << "Fine map interior red range (rays): " << ranges[0] << " (" << rays[0] << ") aliased, "
+        << ranges[1] << " (" << rays[1] << ") mipmapped";
+    FGASSERT(ranges[1] <= 2);
+    FGASSERT(ranges[1] < ranges[0]);
+    FGASSERT(rays[1] < rays[0]);
+    // Auxiliary images are filled during sampling without changing the image. Check the values at a pixel
+    // within the square (flat on at depth 4) and one outside:
+    Vec2UI          px(36,32);
+    Vec2F           pxIucs = mapDiv(Vec2F(px)+Vec2F(0.5f),Vec2F(64)),
+                    uvExpected((pxIucs[0]*8.0f - 3.0f)/3.0f,(5.5f - pxIucs[1]*8.0f)/3.0f);
+    for (RenderBackend backend : {RenderBackend::rayCast,RenderBackend::raster}) {
+        ro.backend = backend;
+        ro.auxImages.reset();
+        ImgC4UC         imgNoAux = renderSoft(Vec2UI(64),meshes,SimilarityD(),itcsToIucs,ro);
+        ro.auxImages = make_shared<RenderAuxImages>();
+        FGASSERT(renderSoft(Vec2UI(64),meshes,SimilarityD(),itcsToIucs,ro).m_data == imgNoAux.m_data);
+        RenderAuxImages const & aux = *ro.auxImages;
+        FGASSERT(aux.invDepth.dims() == Vec2UI(64));
+        FGASSERT(abs(aux.invDepth[px] - 0.25f) < 1.0e-5f);
+        FGASSERT(cMag(aux.normal[px] - Vec3F(0,0,1)) < 1.0e-10);
+        FGASSERT((aux.triInd[px].meshIdx == 0) && (aux.triInd[px].surfIdx == 0));
+        FGASSERT(cMag(aux.uv[px] - uvExpected) < sqr(0.01f));
+        FGASSERT(aux.invDepth[Vec2UI(0)] == 0.0f);
+    }
+    // The visibility buffer gives the same auxiliary images as the raster backend:
+    RenderAuxImages auxRaster = *ro.auxImages;
+    renderVisibility(Vec2UI(64),meshes,SimilarityD(),itcsToIucs,ro);
+    FGASSERT(ro.auxImages->invDepth.m_data == auxRaster.invDepth.m_data);
+    FGASSERT(ro.auxImages->uv.m_data == auxRaster.uv.m_data);
+}
+
+struct  BenchScene
+{
+    String              name;
+    Meshes              meshes;
+    QuaternionD         pose;       // Object rotation for the default camera
+};
+
+// Scenes are in increasing order of complexity within each type so peak memory increases
+// where it cannot be reset:
+static
+Svec<BenchScene>
+benchScenes()
+{
+    Svec<BenchScene>    ret;
+    for (uint subdivs : {3U,5U,7U})
+        ret.push_back({"sphere"+toStr(subdivs),{cSphere(1.0f,subdivs)},QuaternionD()});
+    // Checkerboard textured grids viewed at an angle so the map is both magnified and minified:
+    ImgC4UC             map(1024,1024);
+    for (Iter2UI it(map.dims()); it.valid(); it.next())
+        map[it()] = ((it()[0] & 32) != (it()[1] & 32)) ? RgbaUC(0,0,0,255) : RgbaUC(255,255,255,255);
+    Sptr<ImgC4UC>       mapPtr = make_shared<ImgC4UC>(map);
+    for (uint sz : {16U,256U}) {
+        Mesh                grid {cGrid(sz)};
+        for (Vec3F const & vert : grid.verts)
+            grid.uvs.push_back(Vec2F(vert[0]+1.0f,vert[1]+1.0f) * 0.5f);
+        Surf &              surf = grid.surfaces[0];
+        surf.quads.uvInds = surf.quads.posInds;
+        surf.material.albedoMap = mapPtr;
+        ret.push_back({"grid"+toStr(sz),{grid},cRotateX(-1.2)});
+    }
+    Mesh                jane = loadTri(dataDir()+"base/Jane.tri");
+    loadImage_(dataDir()+"base/Jane.jpg",jane.surfaces[0].albedoMapRef());
+    ret.push_back({"jane",{jane},QuaternionD()});
+    // Glasses have a transparent texture:
+    Mesh                glasses = loadTri(dataDir()+"base/Glasses.tri");
+    loadImage_(dataDir()+"base/Glasses.tga",glasses.surfaces[0].albedoMapRef());
+    ret.push_back({"janeGlasses",{jane,glasses},cRotateY(0.5)});
+    return ret;
 }
 
+// The timer only has millisecond resolution so fast functions are repeated for at least 100ms:
+template<class Fn>
+static
+double
+minTimeMs(uint reps,Fn const & fn)
+{
+    double              ret = numeric_limits<double>::max();
+    for (uint ii=0; ii<reps; ++ii) {
+        Timer               timer;
+        uint                num = 0;
+        do {
+            fn();
+            ++num;
+        }
+        while (timer.readMs() < 100);
+        ret = cMin(ret,double(timer.readMs())/double(num));
+    }
+    return ret;
+}
+
+static
+void
+testmSoftRender(CLArgs const & args)
+{
+    Syntax              syntax(args,
+        "[-q] <results>.csv\n"
+        "    Benchmark 'renderSoft' on standard scenes and save the results in CSV format.\n"
+        "    -q     - Quick: fewer resolutions and sample settings, no repeats\n"
+        "OUTPUT COLUMNS:\n"
+        "    scene,tris,width,height,backend,samples,setupMs,renderMs,rays,raysPerSec,peakMB\n"
+        "    samples - 'antiAliasBitDepth' for 'rayCast', 'rasterSamplesDim' for 'raster'\n"
+        "    setupMs - Camera-independent and camera-dependent RayCaster setup\n"
+        "    renderMs - Total 'renderSoft' time including setup\n"
+        "    rays - Total rays cast by adaptive sampling (0 for 'raster')\n"
+        "    peakMB - Peak resident memory while rendering (process peak if it cannot be reset on this OS)\n"
+        "NOTES:\n"
+        "    Times are the minimum over repeats using all hardware threads."
+    );
+    bool                quick = false;
+    if (syntax.peekNext() == "-q") {
+        quick = true;
+        syntax.next();
+    }
+    String              csvFile = syntax.next();
+    Uints               resolutions = quick ? Uints{256} : Uints{256,512,1024},
+                        aaDepths = quick ? Uints{3} : Uints{1,3,5};
+    uint                reps = quick ? 1 : 3;
+    Ofstream            ofs(csvFile);
+    ofs << "scene,tris,width,height,backend,samples,setupMs,renderMs,rays,raysPerSec,peakMB\n";
+    fgout << fgnl << getCurrentBuildDescription() << ", " << cNumThreads(0) << " threads" << fgpush;
+    for (BenchScene const & scene : benchScenes()) {
+        size_t              numTris = 0;
+        for (Mesh const & mesh : scene.meshes)
+            numTris += mesh.numTriEquivs();
+        CameraParams        cps {Mat32D(cBounds(scene.meshes))};
+        cps.pose = scene.pose;
+        fgout << fgnl << scene.name << " (" << numTris << " tris):" << fgpush;
+        for (uint res : resolutions) {
+            Vec2UI              dims(res);
+            Camera              cam = cps.camera(dims);
+            double              setupMs = minTimeMs(reps,[&]()
+            {
+                RayCaster           rc {make_shared<RayCastMeshes>(scene.meshes,true),
+                    cam.modelview,cam.itcsToIucs,Lighting(),RgbaF(0)};
+            });
+            Svec<pair<RenderBackend,uint> >     configs;
+            for (uint aa : aaDepths)
+                configs.push_back({RenderBackend::rayCast,aa});
+            configs.push_back({RenderBackend::raster,3});
+            for (auto const & config : configs) {
+                RenderOptions       ro;
+                ro.backend = config.first;
+                ro.antiAliasBitDepth = config.second;
+                ro.rasterSamplesDim = config.second;
+                ro.sampleStats = make_shared<SampleTileStatss>();
+                resetPeakMemory();
+                double              renderMs = minTimeMs(reps,[&]()
+                {
+                    renderSoft(dims,scene.meshes,cam.modelview,cam.itcsToIucs,ro);
+                });
+                double              peakMB = double(getPeakMemory()) / double(1 << 20);
+                bool                rayCast = (config.first == RenderBackend::rayCast);
+                uint64              rays = rayCast ? cRayCount(*ro.sampleStats) : 0;
+                double              raysPerSec = double(rays) * 1000.0 / renderMs;
+                String              backend = rayCast ? "rayCast" : "raster";
+                ofs << scene.name << "," << numTris << "," << dims[0] << "," << dims[1] << "," << backend
+                    << "," << config.second << "," << setupMs << "," << renderMs << "," << rays << ","
+                    << raysPerSec << "," << peakMB << "\n";
+                fgout << fgnl << res << "px " << backend << " " << config.second << ": setup " << setupMs
+                    << "ms render " << renderMs << "ms";
+                if (rayCast)
+                    fgout << " " << raysPerSec / 1.0e6 << "M rays/s";
+                fgout << " peak " << peakMB << "MB";
+            }
+        }
+        fgout << fgpop;
+    }
+    fgout << fgpop;
+}
+
+Cmd
+testmSoftRenderInfo()
+{return Cmd(testmSoftRender,"renderBench","Benchmark renderSoft on standard scenes"); }
+
 Cmd
 testSoftRenderInfo()
 {return Cmd(testSoftRender,"rend","renderSoft function"); }
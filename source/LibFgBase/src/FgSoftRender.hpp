@@ -15,11 +15,18 @@
 #include "FgImage.hpp"
 #include "FgSimilarity.hpp"
 #include "Fg3dCamera.hpp"
+#include "FgSampler.hpp"
+#include "FgRayCaster.hpp"
+#include "FgRasterizer.hpp"
 
 namespace Fg {
 
 enum class RenderSurfPoints { never, whenVisible, always };
 
+// Ray casting is adaptively sampled so is efficient for large images of simple meshes.
+// Rasterization is uniformly multisampled so is efficient for dense meshes. Shading is identical:
+enum class RenderBackend { rayCast, raster };
+
 struct  ProjectedSurfPoint
 {
     String          label;
@@ -28,6 +35,15 @@ struct  ProjectedSurfPoint
 };
 typedef Svec<ProjectedSurfPoint>   ProjectedSurfPoints;
 
+// Per-pixel data of the closest surface at the pixel centre (raster backend: the sample nearest the centre):
+struct  RenderAuxImages
+{
+    ImgF                invDepth;       // Inverse FCCS depth. Zero where no surface is visible
+    Img3F               normal;         // Interpolated unit surface normal in OECS. Zero where none visible
+    Img<TriInd>         triInd;         // Mesh, surface and tri indices. Only valid where 'invDepth' > 0
+    Img2F               uv;             // Interpolated OTCS. Zero where none visible or no UVs
+};
+
 struct  RenderOptions
 {
     Lighting            lighting;   // In OECS (not transformed)
@@ -41,7 +57,30 @@ struct  RenderOptions
     Sptr<ProjectedSurfPoints> projSurfPoints;
     bool                useMaps = true;     // Turn off to see raw geometry
     bool                allShiny = false;
-
+    // Sampling is done in image tiles across this many threads (0 - all hardware threads).
+    // 1 selects the untiled serial sampler, which is the default so that callers already rendering
+    // concurrently don't oversubscribe the cores. The image is identical in all cases:
+    uint                numThreads = 1;
+    // If defined, place the per-tile sampling statistics here:
+    Sptr<SampleTileStatss> sampleStats;
+    RenderBackend       backend = RenderBackend::rayCast;
+    // Screen-space acceleration structure for ray casting. The image is the same for all:
+    RayCastAccel        rayCastAccel = RayCastAccel::grid;
+    // Raster backend samples per pixel along each axis in [1,8] ('antiAliasBitDepth' is not used):
+    uint                rasterSamplesDim = 3;
+    // Sample maps from trilinear filtered mipmaps to avoid aliasing (and excess adaptive sampling) where
+    // they are minified. Turn off to always sample maps at full resolution:
+    bool                mipmap = true;
+    // If defined, auxiliary images are RETURNED here, filled during the same sampling pass:
+    Sptr<RenderAuxImages> auxImages;
+    // If either is non-zero the ray cast backend samples progressively (see ProgressiveSampler). One ray per
+    // pixel is always cast first, so neither limit applies to that pass and the total ray count is at least
+    // the number of pixels. Refinement then stops before the total ray count exceeds 'maxRays' or once it
+    // has taken 'maxSeconds' (0 - no limit). The image is the same as without a budget if it is large enough:
+    uint64              maxRays = 0;
+    double              maxSeconds = 0.0;
+
+    // Only the original fields are serialized so existing XML option files still load:
     FG_SERIALIZE6(lighting,backgroundColor,antiAliasBitDepth,renderSurfPoints,useMaps,allShiny);
 };
 
@@ -82,6 +121,77 @@ renderSoft(
     RenderOptions const &   options=RenderOptions())
 {return renderSoft(pixelSize,meshes,transform.modelview,transform.itcsToIucs,options); }
 
+// State kept between renders of the same meshes (eg. interactive or server rendering) so that the
+// camera-independent setup is done once and the working storage of the previous render is re-used:
+struct  RenderContext
+{
+    Sptr<RayCastMeshes const> rcMeshes;
+    Sptr<RayCaster>         rayCaster;      // Created by the first render
+    SampleBuffers           buffers;
+    ProjectedSurfPoints     surfPoints;     // Of the last render, if requested or painted
+
+    // Pointers into the meshes are kept so they must remain valid:
+    void
+    setMeshes(Meshes const & meshes,bool mipmap=true);
+};
+
+// Render into 'img', whose dimensions must already be set. 'options.mipmap' is not used as this was
+// set by 'RenderContext::setMeshes'. Once the context has rendered a similar view at the same size,
+// the ray cast backend with 'numThreads' of 1 does no heap allocation unless surface points, sample
+// statistics or auxiliary images are requested. The image is the same as that of 'renderSoft':
+void
+renderSoft_(
+    RenderContext &         context,        // 'setMeshes' must have been called
+    SimilarityD             meshToOecs,
+    AffineEw2D              itcsToIucs,
+    RenderOptions const &   options,
+    ImgC4UC &               img);
+
+typedef Svec<RenderXform>   RenderXforms;
+
+// Render the same meshes from multiple views (eg. a turntable). The camera-independent setup is only
+// done once and the frames are rendered concurrently when 'options.numThreads' is not 1.
+// 'options.projSurfPoints', 'options.sampleStats' and 'options.auxImages' are filled in for the last frame:
+ImgC4UCs
+renderSoft(
+    Vec2UI                  pixelSize,
+    Meshes const &          meshes,
+    RenderXforms const &    transforms,
+    RenderOptions const &   options=RenderOptions());
+
+// The visibility computation of a render, kept so it can be shaded repeatedly (eg. under many lightings)
+// at a fraction of the cost of a full render. Pointers into the meshes are kept so they must remain valid:
+struct  RenderVisibility
+{
+    Sptr<RayCaster const>   rayCaster;
+    VisibilityBuffer        buffer;
+    ProjectedSurfPoints     surfPoints;
+};
+
+// Uses the samples of the raster backend regardless of 'options.backend', which also fill 'options.auxImages'
+// if defined. The shading options are not used:
+RenderVisibility
+renderVisibility(
+    Vec2UI                  pixelSize,
+    Meshes const &          meshes,
+    SimilarityD             meshToOecs,
+    AffineEw2D              itcsToIucs,
+    RenderOptions const &   options=RenderOptions());
+
+// Uses the 'lighting', 'backgroundColor', 'useMaps', 'allShiny', 'renderSurfPoints' and 'numThreads' options.
+// Gives the same image as 'renderSoft' with the raster backend and the same options:
+ImgC4UC
+renderShade(RenderVisibility const & visibility,RenderOptions const & options);
+
+// Project the surface points of the meshes and determine their visibility (as for 'options.projSurfPoints')
+// without rendering an image. Points are projected concurrently using 'numThreads' (0 - all hardware threads):
+ProjectedSurfPoints
+projectSurfPoints(
+    Meshes const &          meshes,
+    SimilarityD             meshToOecs,
+    AffineEw2D              itcsToIucs,
+    uint                    numThreads=1);
+
 // Render with default camera:
 ImgC4UC
 renderSoft(
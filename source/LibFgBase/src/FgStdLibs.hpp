@@ -12,12 +12,14 @@
 // name so we don't have to use the namespace prefix (or 'using namespace std') -
 // however it can be used to avoid conflicts:
 #include <cctype>
+#include <cerrno>
 #include <cfloat>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 
 // C++ standard libraries:
@@ -45,6 +45,37 @@ struct Traits<Svec<T> >
     typedef Svec<typename Traits<T>::Floating>      Floating;
 };
 
+// Read-only view of contiguous values owned elsewhere:
+template<typename T>
+struct  ArrayView
+{
+    T const *       ptr = nullptr;
+    size_t          num = 0;
+
+    ArrayView() {}
+    ArrayView(T const * p,size_t n) : ptr(p), num(n) {}
+
+    size_t
+    size() const
+    {return num; }
+
+    bool
+    empty() const
+    {return (num == 0); }
+
+    T const &
+    operator[](size_t idx) const
+    {return ptr[idx]; }
+
+    T const *
+    begin() const
+    {return ptr; }
+
+    T const *
+    end() const
+    {return ptr + num; }
+};
+
 template<class T>
 std::ostream &
 operator<<(std::ostream & ss,Svec<T> const & vv)
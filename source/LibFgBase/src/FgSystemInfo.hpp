@@ -25,6 +25,13 @@ Ustring     getDefaultGpuDescription();
 
 Ustring    fgComputerName();
 
+// Peak resident memory of this process in bytes, since start or the last successful 'resetPeakMemory'.
+// Returns 0 if not available:
+uint64      getPeakMemory();
+
+// Only currently implemented on Linux. Returns false if the peak could not be reset:
+bool        resetPeakMemory();
+
 }
 
 #endif
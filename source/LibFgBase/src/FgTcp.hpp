@@ -20,7 +20,9 @@ fgTcpClient(
     uint16              port,
     String const &      data,
     bool                getResponse,
-    String &            response);      // Ignored if 'getResponse' == false
+    String &            response,       // Ignored if 'getResponse' == false
+    // Time to wait for each part of the response, which must cover the server's handler time:
+    uint                timeoutSecs=5);
 
 inline
 bool
@@ -41,14 +43,25 @@ typedef std::function<bool        // Return false to terminate server
      String &)>                     // Data to be returned to client (ignored if server not supposed to respond)
      FgFuncTcpHandler;
 
+typedef std::function<void(uint16)>  FgFuncTcpListening;  // Argument is the port being listened on
+
 void
 fgTcpServer(
-    uint16              port,
+    uint16              port,           // 0 - a free port is assigned (see 'listening')
     // If true, don't disconnect client until handler returns, then respond. Hander must complete
     // before TCP timeout in this case:
     bool                respond,
     FgFuncTcpHandler    handler,
-    size_t              maxRecvBytes);  // Maximum number of bytes to receive in incomimg message
+    size_t              maxRecvBytes,   // Maximum number of bytes to receive in incomimg message
+    // Maximum number of clients handled at once, each on its own thread, so the handler must be
+    // thread-safe if this is more than 1, in which case each handler's 'fgout' output is captured and
+    // written once it returns. The server returns (or throws if unable to accept connections) once all
+    // handlers have completed:
+    uint                maxConcurrent=1,
+    // Only accept connections from this host (IPv4 loopback) rather than on all network interfaces:
+    bool                loopbackOnly=false,
+    // If defined, called with the port once the server is listening for connections:
+    FgFuncTcpListening const & listening=FgFuncTcpListening());
 
 }
 
@@ -0,0 +1,338 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgTextWriter.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include "FgTime.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+// Powers of ten exactly representable as doubles:
+static double const pow10Exact[] = {
+    1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+static uint64 const pow10Int[] = {1,10,100,1000,10000,100000,1000000,10000000,100000000};
+
+// Scaling the value so that its significant digits form an integer takes a single rounding (two if
+// fast math uses a reciprocal) so the digits are exact unless the scaled value is within that error
+// of a tie between two integers. The tolerance is orders of magnitude above that error for at most
+// 7 digits. The bits are examined directly since fast math does not preserve NaN comparisons:
+static
+bool
+appendNumberFast(String & str,double val,uint precision)
+{
+    uint                prec = cMax(precision,1U);      // As printf
+    if (prec > 7)
+        return false;
+    uint64              bits;
+    memcpy(&bits,&val,sizeof(bits));
+    int                 e2 = int((bits >> 52) & 0x7FF);
+    if ((e2 == 0) || (e2 == 0x7FF))                     // Zero, subnormal, infinite or NaN
+        return false;
+    e2 -= 1023;                                         // Magnitude is in [2^e2,2^(e2+1))
+    bool                negative = (bits >> 63) != 0;
+    double              mag = negative ? -val : val;
+    int                 e10 = int(floor(double(e2) * 0.30102999566398120));    // May be one too low
+    uint64              digits = 0;
+    for (uint attempt=0; ; ++attempt) {
+        if (attempt == 2)
+            return false;
+        int                 scale = int(prec) - 1 - e10;
+        if ((scale < -22) || (scale > 22))
+            return false;
+        double              scaled = (scale >= 0) ? mag * pow10Exact[scale] : mag / pow10Exact[-scale],
+                            whole = floor(scaled),
+                            frac = scaled - whole;
+        if ((frac > 0.5 - 1.0e-7) && (frac < 0.5 + 1.0e-7))
+            return false;
+        digits = uint64(whole) + ((frac > 0.5) ? 1 : 0);
+        if (digits >= pow10Int[prec])               // Includes rounding up to the next power of ten
+            ++e10;
+        else if (digits < pow10Int[prec-1])
+            --e10;
+        else
+            break;
+    }
+    char                buf[16];                    // Significant digits, most significant first
+    for (uint ii=prec; ii>0; --ii) {
+        buf[ii-1] = char('0' + digits % 10);
+        digits /= 10;
+    }
+    uint                numSig = prec;              // Without trailing zeros
+    while ((numSig > 1) && (buf[numSig-1] == '0'))
+        --numSig;
+    if (negative)
+        str.push_back('-');
+    if ((e10 < -4) || (e10 >= int(prec))) {         // Scientific
+        str.push_back(buf[0]);
+        if (numSig > 1) {
+            str.push_back('.');
+            str.append(buf+1,numSig-1);
+        }
+        str.push_back('e');
+        str.push_back((e10 < 0) ? '-' : '+');
+        uint                expMag = uint((e10 < 0) ? -e10 : e10);
+        if (expMag >= 100)
+            str.push_back(char('0' + expMag / 100));
+        str.push_back(char('0' + (expMag / 10) % 10));
+        str.push_back(char('0' + expMag % 10));
+    }
+    else if (e10 >= 0) {                            // Trailing zeros are only removed from the fraction
+        uint                numInt = uint(e10) + 1;
+        str.append(buf,numInt);
+        if (numSig > numInt) {
+            str.push_back('.');
+            str.append(buf+numInt,numSig-numInt);
+        }
+    }
+    else {
+        str.append("0.");
+        str.append(size_t(-e10-1),'0');
+        str.append(buf,numSig);
+    }
+    return true;
+}
+
+void
+appendNumber(String & str,double val,uint precision)
+{
+    if (appendNumberFast(str,val,precision))
+        return;
+    char                buf[512];                   // Enough for any double with any sensible precision
+    int                 len = snprintf(buf,sizeof(buf),"%.*g",int(cMin(precision,100U)),val);
+    FGASSERT((len > 0) && (size_t(len) < sizeof(buf)));
+    str.append(buf,size_t(len));
+}
+
+// The scaled value has a single rounding error relative to its magnitude so the tie tolerance
+// must grow with it:
+static
+bool
+appendFixedFast(String & str,double val,uint decimals)
+{
+    if (decimals > 7)
+        return false;
+    uint64              bits;
+    memcpy(&bits,&val,sizeof(bits));
+    int                 e2 = int((bits >> 52) & 0x7FF);
+    if ((e2 == 0) || (e2 == 0x7FF))                     // Zero, subnormal, infinite or NaN
+        return false;
+    bool                negative = (bits >> 63) != 0;
+    double              scaled = (negative ? -val : val) * pow10Exact[decimals];
+    if (scaled >= 1.0e15)
+        return false;
+    double              whole = floor(scaled),
+                        frac = scaled - whole,
+                        tol = 1.0e-7 + scaled * 1.0e-15;
+    if ((frac > 0.5 - tol) && (frac < 0.5 + tol))
+        return false;
+    uint64              digits = uint64(whole) + ((frac > 0.5) ? 1 : 0);
+    char                buf[32];
+    char *              ptr = buf + sizeof(buf);
+    for (uint ii=0; ii<decimals; ++ii) {
+        *--ptr = char('0' + digits % 10);
+        digits /= 10;
+    }
+    if (decimals > 0)
+        *--ptr = '.';
+    do {
+        *--ptr = char('0' + digits % 10);
+        digits /= 10;
+    } while (digits > 0);
+    if (negative)
+        *--ptr = '-';
+    str.append(ptr,buf+sizeof(buf));
+    return true;
+}
+
+void
+appendFixed(String & str,double val,uint decimals)
+{
+    if (appendFixedFast(str,val,decimals))
+        return;
+    char                buf[512];
+    int                 len = snprintf(buf,sizeof(buf),"%.*f",int(cMin(decimals,100U)),val);
+    if ((len > 0) && (size_t(len) < sizeof(buf)))
+        str.append(buf,size_t(len));
+    else {                                          // Too large for the buffer
+        ostringstream       oss;
+        oss << std::fixed;
+        oss.precision(decimals);
+        oss << val;
+        str.append(oss.str());
+    }
+}
+
+TextWriter::TextWriter(Ustring const & fname) : m_ofs(fname), m_toFile(true)
+{}
+
+TextWriter::~TextWriter()
+{
+    // Must not throw from a destructor; any error is visible through 'fail' if 'close' was called:
+    if (m_toFile && m_ofs.is_open() && !m_buf.empty())
+        m_ofs.write(m_buf.data(),m_buf.size());
+}
+
+void
+TextWriter::flush()
+{
+    if (m_toFile && !m_buf.empty()) {
+        m_ofs.write(m_buf.data(),m_buf.size());
+        m_buf.clear();
+    }
+}
+
+void
+TextWriter::close()
+{
+    if (m_toFile) {
+        flush();
+        m_ofs.close();
+    }
+}
+
+bool
+TextWriter::fail() const
+{return m_toFile && m_ofs.fail(); }
+
+TextWriter &
+TextWriter::appendInt(uint64 val,bool negative)
+{
+    char                buf[24];
+    char *              ptr = buf + sizeof(buf);
+    do {
+        *--ptr = char('0' + val % 10);
+        val /= 10;
+    } while (val > 0);
+    if (negative)
+        *--ptr = '-';
+    m_buf.append(ptr,buf+sizeof(buf));
+    return flushIfFull();
+}
+
+void
+testTextWriter(CLArgs const &)
+{
+    // Numbers must be formatted exactly as a stream would, including values near decimal ties,
+    // integers, powers of ten and the extremes of the fast path:
+    mt19937_64          rng(0x5EED);
+    auto                check = [](double val,uint prec)
+    {
+        ostringstream       oss;
+        oss.precision(prec);
+        oss << val;
+        String              str;
+        appendNumber(str,val,prec);
+        if (str != oss.str())
+            fgThrow("TextWriter number format differs from stream",oss.str()+" != "+str);
+    };
+    for (uint prec=0; prec<10; ++prec) {
+        for (size_t ii=0; ii<20000; ++ii) {
+            uint64              bits = rng();
+            double              dval;
+            memcpy(&dval,&bits,sizeof(dval));
+            float               fval = float(uniform_real_distribution<double>(-1.0,1.0)(rng)) *
+                                    pow(10.0f,float(int(rng() % 31) - 15));
+            int64               ival = int64(rng() % 20000000) - 10000000;
+            check(fval,prec);
+            check(double(ival),prec);
+            check(double(ival)*1.0e-6,prec);            // Decimal ties
+            if ((dval == dval) && (abs(dval) < 1.0e300))   // Skip NaNs whose sign is not portable
+                check(dval,prec);
+        }
+        for (int ee=-30; ee<=30; ++ee) {
+            check(pow(10.0,ee),prec);
+            check(-pow(10.0,ee)*0.99999999,prec);
+        }
+        for (double val : {0.0,-0.0,0.5,1.5,2.5,0.125,9.5,99999.95,9999999.5,1.0e-5,0.0001,123456789.0})
+            check(val,prec);
+    }
+    auto                checkFixed = [](double val,uint decimals)
+    {
+        ostringstream       oss;
+        oss << std::fixed;
+        oss.precision(decimals);
+        oss << val;
+        String              str;
+        appendFixed(str,val,decimals);
+        if (str != oss.str())
+            fgThrow("TextWriter fixed format differs from stream",oss.str()+" != "+str);
+    };
+    for (uint decimals=0; decimals<9; ++decimals) {
+        for (size_t ii=0; ii<20000; ++ii) {
+            float               fval = float(uniform_real_distribution<double>(-1.0,1.0)(rng)) *
+                                    pow(10.0f,float(int(rng() % 21) - 10));
+            int64               ival = int64(rng() % 20000000) - 10000000;
+            checkFixed(fval,decimals);
+            checkFixed(double(ival)*1.0e-7,decimals);   // Decimal ties
+            checkFixed(double(ival)*1.0e6,decimals);
+        }
+        for (double val : {0.0,-0.0,0.5,-0.5,2.5,1.0e-9,-1.0e-9,0.0625,1.0e14,1.0e20,1.0e300})
+            checkFixed(val,decimals);
+    }
+    // File and memory output must be the same, across the file buffer flush:
+    TestDir             td("textWriter");
+    TextWriter          mem;
+    ostringstream       oss;
+    {
+        TextWriter          file("test.txt");
+        for (TextWriter * tw : {&mem,&file})
+            tw->precision(7);
+        oss.precision(7);
+        for (size_t ii=0; ii<200000; ++ii) {
+            float               val = float(ii) * 0.37f - 1000.0f;
+            int                 ival = int(ii) - 1000;
+            size_t              sval = ii * 7919;
+            for (TextWriter * tw : {&mem,&file})
+                *tw << "v " << val << ' ' << ival << " " << sval << String("\n");
+            oss << "v " << val << ' ' << ival << " " << sval << String("\n");
+        }
+        file.close();
+        FGASSERT(!file.fail());
+    }
+    FGASSERT(mem.str() == oss.str());
+    FGASSERT(loadRawString("test.txt") == oss.str());
+    for (long long val : {numeric_limits<long long>::min(),numeric_limits<long long>::max(),0LL,-1LL}) {
+        TextWriter          tw;
+        ostringstream       os;
+        tw << val;
+        os << val;
+        FGASSERT(tw.str() == os.str());
+    }
+}
+
+void
+testmTextWriter(CLArgs const &)
+{
+    size_t const        num = 1 << 22;
+    Floats              vals(num);
+    mt19937             rng(42);
+    for (float & val : vals)
+        val = float(uniform_real_distribution<double>(-100.0,100.0)(rng));
+    Timer               timer;
+    ostringstream       oss;
+    oss.precision(7);
+    for (float val : vals)
+        oss << val << ' ';
+    uint64              streamMs = timer.readMs();
+    timer.start();
+    TextWriter          tw;
+    tw.precision(7);
+    for (float val : vals)
+        tw << val << ' ';
+    uint64              writerMs = timer.readMs();
+    FGASSERT(tw.str() == oss.str());
+    fgout << fgnl << num << " floats: stream " << streamMs << "ms, TextWriter " << writerMs << "ms";
+}
+
+}
+
+// */
@@ -0,0 +1,143 @@
+//
+// Coypright (c) 2020 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Buffered text output with fast number formatting for large text file exports
+//
+
+#ifndef FG_TEXTWRITER_HPP
+#define FG_TEXTWRITER_HPP
+
+#include "FgStdStream.hpp"
+
+namespace Fg {
+
+// Append 'val' formatted exactly as by a default-formatted 'std::ostream' with the given precision
+// (ie. printf '%.*g'). Most values are formatted directly, falling back to the C library when they
+// need more than 7 significant digits or are within rounding error of a decimal tie:
+void
+appendNumber(String & str,double val,uint precision);
+
+// As above but formatted as by 'std::fixed' (ie. printf '%.*f'):
+void
+appendFixed(String & str,double val,uint decimals);
+
+// Used in place of an 'std::ostream' by text exporters. Output is byte-identical to a default-formatted
+// stream with the same precision, but without the per-insertion stream sentry and locale overhead.
+// Output is accumulated in memory and, if writing to a file, written in large blocks:
+class   TextWriter
+{
+public:
+    // Output to memory, retrieved with 'str()':
+    TextWriter() {}
+
+    // Output to the given file, which is truncated. Throws if it cannot be opened:
+    explicit
+    TextWriter(Ustring const & fname);
+
+    // Writes any remaining output if writing to a file:
+    ~TextWriter();
+
+    // Significant digits of floating point values, as for 'std::ostream' (default 6):
+    void
+    precision(uint digits)
+    {m_precision = digits; }
+
+    uint
+    precision() const
+    {return m_precision; }
+
+    TextWriter &
+    operator<<(char c)
+    {m_buf.push_back(c); return flushIfFull(); }
+
+    TextWriter &
+    operator<<(signed char c)
+    {return operator<<(char(c)); }
+
+    TextWriter &
+    operator<<(unsigned char c)
+    {return operator<<(char(c)); }
+
+    TextWriter &
+    operator<<(char const * str)
+    {m_buf.append(str); return flushIfFull(); }
+
+    TextWriter &
+    operator<<(String const & str)
+    {m_buf.append(str); return flushIfFull(); }
+
+    TextWriter &
+    operator<<(Ustring const & str)
+    {m_buf.append(str.m_str); return flushIfFull(); }
+
+    TextWriter & operator<<(bool val)                   {return appendInt(uint64(val),false); }
+    TextWriter & operator<<(short val)                  {return appendSigned(val); }
+    TextWriter & operator<<(unsigned short val)         {return appendInt(val,false); }
+    TextWriter & operator<<(int val)                    {return appendSigned(val); }
+    TextWriter & operator<<(unsigned int val)           {return appendInt(val,false); }
+    TextWriter & operator<<(long val)                   {return appendSigned(val); }
+    TextWriter & operator<<(unsigned long val)          {return appendInt(val,false); }
+    TextWriter & operator<<(long long val)              {return appendSigned(val); }
+    TextWriter & operator<<(unsigned long long val)     {return appendInt(val,false); }
+
+    // As for 'std::ostream', floats are formatted as their exact double value:
+    TextWriter &
+    operator<<(float val)
+    {return operator<<(double(val)); }
+
+    TextWriter &
+    operator<<(double val)
+    {appendNumber(m_buf,val,m_precision); return flushIfFull(); }
+
+    // Output so far when writing to memory:
+    String const &
+    str() const
+    {return m_buf; }
+
+    void
+    flush();
+
+    // Flushes and closes the file, after which 'fail' reports any write error:
+    void
+    close();
+
+    bool
+    fail() const;
+
+    explicit
+    operator bool() const
+    {return !fail(); }
+
+private:
+    Ofstream            m_ofs;
+    bool                m_toFile = false;
+    String              m_buf;
+    uint                m_precision = 6;
+
+    TextWriter &
+    flushIfFull()
+    {
+        if (m_toFile && (m_buf.size() >= (1 << 20)))
+            flush();
+        return *this;
+    }
+
+    template<class T>
+    TextWriter &
+    appendSigned(T val)
+    {
+        // Negate as unsigned to handle the minimum value:
+        return (val < 0) ? appendInt(uint64(0) - uint64(val),true) : appendInt(uint64(val),false);
+    }
+
+    TextWriter &
+    appendInt(uint64 val,bool negative);
+};
+
+}
+
+#endif
+
+// */
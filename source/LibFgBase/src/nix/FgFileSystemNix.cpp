@@ -12,6 +12,8 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include "FgFileSystem.hpp"
 #include "FgException.hpp"
 #include "FgDiagnostics.hpp"
@@ -167,6 +169,35 @@ uint64
 getLastWriteTime(Ustring const & path)
 {return boost::filesystem::last_write_time(path.ns()); }
 
+MappedFile::MappedFile(Ustring const & fname)
+{
+    string          fn = fname.as_utf8_string();
+    int             fd = open(fn.c_str(),O_RDONLY);
+    if (fd < 0)
+        fgThrow("Unable to open file for reading",fname);
+    struct stat     st;
+    if ((fstat(fd,&st) != 0) || !S_ISREG(st.st_mode)) {
+        close(fd);
+        fgThrow("Unable to read file size",fname);
+    }
+    m_size = size_t(st.st_size);
+    if (m_size > 0) {                               // Zero length mappings are invalid
+        void *          ptr = mmap(nullptr,m_size,PROT_READ,MAP_SHARED,fd,0);
+        if (ptr == MAP_FAILED) {
+            close(fd);
+            fgThrow("Unable to memory map file",fname);
+        }
+        m_data = static_cast<uchar const *>(ptr);
+    }
+    close(fd);                                      // The mapping keeps its own reference
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<uchar *>(m_data),m_size);
+}
+
 #if defined(__APPLE__)
 
 #include <CoreFoundation/CFBundle.h>
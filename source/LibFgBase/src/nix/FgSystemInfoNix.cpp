@@ -8,6 +8,7 @@
 
 #include "FgSystemInfo.hpp"
 #include "FgPlatform.hpp"
+#include <sys/resource.h>
 
 using namespace std;
 
@@ -41,4 +42,39 @@ Ustring
 fgComputerName()
 {return Ustring("Unknown"); }
 
+uint64
+getPeakMemory()
+{
+#ifdef __linux__
+    // Unlike 'ru_maxrss', VmHWM is reset by 'resetPeakMemory':
+    ifstream            ifs("/proc/self/status");
+    string              line;
+    while (getline(ifs,line)) {
+        if (line.compare(0,6,"VmHWM:") == 0)
+            return uint64(strtoull(line.c_str()+6,nullptr,10)) * 1024;  // Value is in kB
+    }
+#endif
+    rusage              usage;
+    if (getrusage(RUSAGE_SELF,&usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return uint64(usage.ru_maxrss);                 // Bytes on MacOS
+#else
+    return uint64(usage.ru_maxrss) * 1024;          // kB elsewhere
+#endif
+}
+
+bool
+resetPeakMemory()
+{
+#ifdef __linux__
+    ofstream            ofs("/proc/self/clear_refs");
+    ofs << "5";                                     // Resets the peak resident set size (Linux 4.0+)
+    ofs.close();
+    return bool(ofs);
+#else
+    return false;
+#endif
+}
+
 }
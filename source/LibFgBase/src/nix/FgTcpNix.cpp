@@ -28,8 +28,14 @@
 #include "FgException.hpp"
 #include "FgDiagnostics.hpp"
 #include "FgStdString.hpp"
+#include "FgString.hpp"
 #include "FgScopeGuard.hpp"
 #include "FgOut.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <sstream>
 
 // Do NOT use std namespace to avoid collision with posix 'bind'
 
@@ -41,7 +47,8 @@ fgTcpClient(
     uint16              port,
     const std::string & data,
     bool                getResponse,
-    std::string &       response)
+    std::string &       response,
+    uint                timeoutSecs)
 {
     int     clientSock = socket(
                 AF_INET,            // IPv4 protocol family
@@ -51,7 +58,7 @@ fgTcpClient(
     ScopeGuard        closeSocket(std::bind(close,clientSock));
     // Set the timeout so the user doesn't have to wait forever if the connection fails:
     timeval         timeout;
-    timeout.tv_sec = 5;
+    timeout.tv_sec = timeoutSecs;
     timeout.tv_usec = 0;
     if (setsockopt(clientSock,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout)) == -1)
         FGASSERT_FALSE;
@@ -114,12 +121,92 @@ void *get_in_addr(struct sockaddr *sa)
     return &(((struct sockaddr_in6*)sa)->sin6_addr);
 }
 
+// Receive the message from a connected client, call the handler and respond if required.
+// Returns the handler return value (true if the handler was not called):
+static
+bool
+serveClient(
+    int                         dataSockFd,
+    std::string const &         ipAddr,
+    bool                        respond,
+    FgFuncTcpHandler const &    handler,
+    size_t                      maxRecvBytes,
+    std::mutex &                outMutex,   // Serializes console output from concurrent clients
+    bool                        captureOut) // Capture handler output and write it under 'outMutex'
+{
+    // Read incoming message:
+    std::string 	dataBuff;
+    int         	bytesRecvd;
+    {
+        std::lock_guard<std::mutex>     lock(outMutex);
+        fgout << fgnl << "> " << std::flush;
+    }
+    do {
+        char        buffer[1024];
+        // read() will return when either it has filled the buffer, copied over everything
+        // from the socket input buffer (only if non-empty), or when the the connection
+        // is closed by the client. Otherwise it will block (ie if input buffer empty).
+        bytesRecvd = read(dataSockFd,buffer,sizeof(buffer));
+        if (bytesRecvd > 0)
+            dataBuff += std::string(buffer,bytesRecvd);
+    }
+    while ((bytesRecvd > 0) && (dataBuff.size() <= maxRecvBytes));
+    if (bytesRecvd != 0) {
+        close(dataSockFd);
+        std::lock_guard<std::mutex>     lock(outMutex);
+        fgout << "RECEIVE ERROR: ";
+        if (bytesRecvd > 0)
+            fgout << "OVERSIZE MESSAGE IGNORED.";
+        if (bytesRecvd < 0)
+            fgout << "TCP READ ERROR: " << bytesRecvd;
+        fgout << std::flush;
+        return true;
+    }
+    if (!respond)   // Handler can take arbitrarily long in this case so must close immediately:
+        close(dataSockFd);
+    std::string         response,
+                        error;
+    bool                handlerRetval = true;
+    std::ostringstream  handlerOut;
+    try {
+        std::unique_ptr<FgOutCapture>   capture;
+        if (captureOut)
+            capture.reset(new FgOutCapture(handlerOut));
+        handlerRetval = handler(ipAddr,dataBuff,response);
+    }
+    catch(FgException const & e) {
+        error = "Handler exception (FG exception): " + e.no_tr_message();
+    }
+    catch(std::exception const & e) {
+        error = "Handler exception (std::exception): " + std::string(e.what());
+    }
+    catch(...) {
+        error = "Handler exception (unknown type)";
+    }
+    std::lock_guard<std::mutex>     lock(outMutex);
+    fgout.writeCaptured(handlerOut.str());
+    fgout << ": " << error;
+    if (respond) {
+        if (!response.empty()) {
+            int     bytesSent = write(dataSockFd,response.data(),response.size());
+            if (bytesSent != int(response.size()))
+                fgout << "TCP WRITE ERROR: " << bytesSent << " (of " << response.size() << "). ";
+        }
+        close(dataSockFd);
+    }
+    fgout << std::flush;
+    return handlerRetval;
+}
+
 void
 fgTcpServer(
     uint16              port,
     bool                respond,
     FgFuncTcpHandler    handler,
-    size_t              maxRecvBytes)
+    size_t              maxRecvBytes,
+    uint                maxConcurrent,
+    bool                loopbackOnly,
+    FgFuncTcpListening const & listening)
 {
     struct sockaddr_storage clientAddress;
     int                 listenSockFd = -1;  // Avoid uninitialized warning
@@ -132,8 +219,8 @@ fgTcpServer(
     // On most unix systems, AF_UNSPEC choice will listen for either IPv4 or IPv6 incoming connections:
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags = AI_PASSIVE; // use my IP
-    int rv = getaddrinfo(NULL,toStr(port).c_str(),&hints,&servinfo);
+    hints.ai_flags = AI_PASSIVE; // use my IP (ignored for loopback)
+    int rv = getaddrinfo(loopbackOnly ? "127.0.0.1" : NULL,toStr(port).c_str(),&hints,&servinfo);
     FGASSERT1(rv == 0,std::string(gai_strerror(rv)));
 
     // loop through all the results and bind to the first we can
@@ -157,30 +244,60 @@ fgTcpServer(
     // Set the socket to listen and queue up to 10 incoming connections:
     if (listen(listenSockFd,10) == -1)
         FGASSERT_FALSE;
+    if (listening) {
+        struct sockaddr_storage listenAddress;
+        socklen_t           sz = sizeof(listenAddress);
+        if (getsockname(listenSockFd,(struct sockaddr *)&listenAddress,&sz) == -1)
+            FGASSERT_FALSE1(toStr(errno));
+        if (listenAddress.ss_family == AF_INET)
+            listening(ntohs(((struct sockaddr_in *)&listenAddress)->sin_port));
+        else
+            listening(ntohs(((struct sockaddr_in6 *)&listenAddress)->sin6_port));
+    }
     sa.sa_handler = sigchld_handler; // reap all dead processes
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = SA_RESTART;
     if (sigaction(SIGCHLD, &sa, NULL) == -1)
         FGASSERT_FALSE;
 
+    // State shared with concurrent client threads:
+    std::mutex              outMutex,
+                            stateMutex;
+    std::condition_variable stateChanged;
+    uint                    numActive = 0;
+    bool                    stopping = false;
     // Listen for client:
     int         dataSockFd;
-    bool        handlerRetval;
+    bool        handlerRetval = true;
+    int         acceptErr = 0;          // Non-zero if 'accept' failed other than by shutdown
     do {
         socklen_t   sz = sizeof(clientAddress);
         // Get incoming message socketFd. Will block until a message arrives since the
         // listen socket does not have the O_NONBLOCK option set.
         // The data socket is unique to the client IP:PORT, so multiple TCP connections can
-        // take place simultaneously (not made use of here):
+        // take place simultaneously:
         dataSockFd = accept(listenSockFd,(struct sockaddr *)&clientAddress,&sz);
-        FGASSERT(dataSockFd >= 0);
+        if (dataSockFd < 0) {
+            int                             err = errno;
+            std::lock_guard<std::mutex>     lock(stateMutex);
+            if (stopping)                   // Listen socket was shut down by a client thread
+                break;
+            // Interrupted by a signal or the client disconnected before being accepted:
+            if ((err == EINTR) || (err == ECONNABORTED))
+                continue;
+            // Can't throw until client threads are done with the state above:
+            acceptErr = err;
+            break;
+        }
         // Set the timeout. Very important since the default is to never time out so in some
         // cases a broken connection causes 'recv' below to block forever:
         timeval         timeout;
         timeout.tv_sec = 5;
         timeout.tv_usec = 0;
-        if (setsockopt(dataSockFd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout)) == -1)
-            FGASSERT_FALSE;
+        if (setsockopt(dataSockFd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout)) == -1) {
+            close(dataSockFd);
+            continue;
+        }
         // Convert IP address to string:
         char                sbuf[INET6_ADDRSTRLEN];
         inet_ntop(
@@ -189,59 +306,39 @@ fgTcpServer(
             sbuf,
             sizeof sbuf);
         std::string  ipAddr = std::string(sbuf);
-        // Read incoming message:
-        std::string 	dataBuff;
-        int         	bytesRecvd;
-        fgout << fgnl << "> " << std::flush;
-        do {
-            char        buffer[1024];
-            // read() will return when either it has filled the buffer, copied over everything
-            // from the socket input buffer (only if non-empty), or when the the connection
-            // is closed by the client. Otherwise it will block (ie if input buffer empty).
-            bytesRecvd = read(dataSockFd,buffer,sizeof(buffer));
-            fgout << "." << std::flush;
-            if (bytesRecvd > 0)
-                dataBuff += std::string(buffer,bytesRecvd);
-        }
-        while ((bytesRecvd > 0) && (dataBuff.size() <= maxRecvBytes));
-        if (bytesRecvd != 0) {
-            fgout << "RECEIVE ERROR: ";
-            close(dataSockFd);
-            if (bytesRecvd > 0)
-                fgout << "OVERSIZE MESSAGE IGNORED.";
-            if (bytesRecvd < 0)
-                fgout << "TCP READ ERROR: " << bytesRecvd;
-            fgout << std::flush;
-            continue;
-        }
-        fgout << ": " << std::flush;
-        if (!respond)   // Handler can take arbitrarily long in this case so must close immediately:
-            close(dataSockFd);
-        std::string         response;
-        try {
-            handlerRetval = handler(ipAddr,dataBuff,response);
-        }
-        catch(FgException const & e) {
-            fgout << "Handler exception (FG exception): " << e.no_tr_message();
-        }
-        catch(std::exception const & e) {
-            fgout << "Handler exception (std::exception): " << e.what();
-        }
-        catch(...) {
-            fgout << "Handler exception (unknown type)";
-        }
-        if (respond) {
-            if (!response.empty()) {
-                int     bytesSent = write(dataSockFd,response.data(),response.size());
-                if (bytesSent != int(response.size()))
-                    fgout << "TCP WRITE ERROR: " << bytesSent << " (of " << response.size() << "). ";
+        if (maxConcurrent <= 1)
+            handlerRetval = serveClient(dataSockFd,ipAddr,respond,handler,maxRecvBytes,outMutex,false);
+        else {
+            std::unique_lock<std::mutex>    lock(stateMutex);
+            stateChanged.wait(lock,[&]{return (numActive < maxConcurrent) || stopping; });
+            if (stopping) {
+                close(dataSockFd);
+                break;
             }
-            close(dataSockFd);
+            ++numActive;
+            auto            serve = [&,dataSockFd,ipAddr]()
+            {
+                bool            ret = serveClient(dataSockFd,ipAddr,respond,handler,maxRecvBytes,outMutex,true);
+                std::lock_guard<std::mutex>     lock(stateMutex);
+                if (!ret && !stopping) {
+                    stopping = true;
+                    shutdown(listenSockFd,SHUT_RDWR);   // Wake the 'accept' call
+                }
+                --numActive;
+                stateChanged.notify_all();
+            };
+            std::thread(serve).detach();
         }
-        fgout << std::flush;
     } while (handlerRetval == true);
+    // Wait for client threads to finish since they reference the above state:
+    {
+        std::unique_lock<std::mutex>    lock(stateMutex);
+        stateChanged.wait(lock,[&]{return (numActive == 0); });
+    }
     if (listenSockFd >= 0)
         close(listenSockFd);
+    if (acceptErr != 0)
+        fgThrow("TCP server accept failed",toStr(acceptErr));
 }
 
 }
@@ -374,4 +374,47 @@ getLastWriteTime(Ustring const & fname)
     return time / 10000000;
 }
 
+MappedFile::MappedFile(Ustring const & fname)
+{
+    HANDLE          file =
+        CreateFileW(
+            fname.as_wstring().c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throwWindows("Unable to open file for reading",fname);
+    LARGE_INTEGER   size;
+    if (GetFileSizeEx(file,&size) == 0) {
+        CloseHandle(file);
+        throwWindows("Unable to read file size",fname);
+    }
+    m_size = size_t(size.QuadPart);
+    if (m_size > 0) {                               // Zero length mappings are invalid
+        HANDLE          mapping = CreateFileMappingW(file,NULL,PAGE_READONLY,0,0,NULL);
+        if (mapping == NULL) {
+            CloseHandle(file);
+            throwWindows("Unable to memory map file",fname);
+        }
+        void const *    ptr = MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+        // The view keeps its own references to the mapping and file:
+        CloseHandle(mapping);
+        if (ptr == NULL) {
+            CloseHandle(file);
+            throwWindows("Unable to memory map file",fname);
+        }
+        m_data = static_cast<uchar const *>(ptr);
+    }
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+}
+
 }
@@ -9,6 +9,9 @@
 
 #include "FgStdString.hpp"
 #include "FgString.hpp"
+#include <psapi.h>
+
+#pragma comment (lib,"Psapi.lib")
 
 using namespace std;
 
@@ -70,6 +73,19 @@ fgComputerName()
         return wstring(L"Unknown");
 }
 
+uint64
+getPeakMemory()
+{
+    PROCESS_MEMORY_COUNTERS     pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(),&pmc,sizeof(pmc)))
+        return 0;
+    return uint64(pmc.PeakWorkingSetSize);
+}
+
+bool
+resetPeakMemory()
+{return false; }
+
 }
 
 // */
@@ -11,6 +11,11 @@
 #include "FgStdString.hpp"
 #include "FgDiagnostics.hpp"
 #include "FgOut.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <sstream>
 
 // Tell compiler to link to these libs:
 #pragma comment (lib, "Ws2_32.lib")
@@ -53,7 +58,8 @@ fgTcpClient(
     uint16              port,
     String const &      data,
     bool                getResponse,
-    String &            response)
+    String &            response,
+    uint                timeoutSecs)
 {
     initWinsock();
     SOCKET              socketHandle;
@@ -91,7 +97,7 @@ fgTcpClient(
             FGASSERT_FALSE1(toStr(WSAGetLastError()));
         }
         // Set the timeout so the user isn't waiting for ages if the connection fails:
-        DWORD           timeout = 5000;     // 5 seconds
+        DWORD           timeout = timeoutSecs*1000;
         setsockopt(socketHandle,SOL_SOCKET,SO_RCVTIMEO,(const char*)&timeout,sizeof(timeout));
         // Try to connect to the server
         itmp = connect(socketHandle,ptr->ai_addr,(int)ptr->ai_addrlen);
@@ -139,12 +145,87 @@ fgTcpClient(
     return true;
 }
 
+// Receive the message from a connected client, call the handler and respond if required.
+// Returns the handler return value (true if the handler was not called):
+static
+bool
+serveClient(
+    SOCKET                      sockClient,
+    String const &              ipAddr,
+    bool                        respond,
+    FgFuncTcpHandler const &    handler,
+    size_t                      maxRecvBytes,
+    std::mutex &                outMutex,   // Serializes console output from concurrent clients
+    bool                        captureOut) // Capture handler output and write it under 'outMutex'
+{
+    String     dataBuff;
+    int retVal = 0;
+    do {
+        char    recvbuf[1024];
+        // recv() will return when either it has filled the buffer, copied over everthing
+        // from the socket input buffer (only if non-empty), or when the the read connection
+        // is closed by the client. Otherwise it will block (ie if input buffer empty):
+        retVal = recv(sockClient,recvbuf,sizeof(recvbuf),0);
+        if (retVal > 0)
+            dataBuff += String(recvbuf,retVal);
+    }
+    while ((retVal > 0) && (dataBuff.size() <= maxRecvBytes));
+    if (retVal != 0) {
+        closesocket(sockClient);
+        std::lock_guard<std::mutex>     lock(outMutex);
+        if (retVal < 0)
+            fgout << "TCP RECV ERROR: " << retVal;
+        else if (retVal > 0)
+            fgout << " OVERSIZE MESSAGE IGNORED.";
+        fgout << std::flush;
+        return true;
+    }
+    if (!respond)   // Avoid timeout errors on the data socket for long handlers that don't respond:
+        closesocket(sockClient);
+    String     response,
+               error;
+    bool       handlerRetval = true;
+    std::ostringstream  handlerOut;
+    try {
+        std::unique_ptr<FgOutCapture>   capture;
+        if (captureOut)
+            capture.reset(new FgOutCapture(handlerOut));
+        handlerRetval = handler(ipAddr,dataBuff,response);
+    }
+    catch(FgException const & e) {
+        error = "Handler exception (FG exception): " + e.no_tr_message();
+    }
+    catch(std::exception const & e) {
+        error = "Handler exception (std::exception): " + String(e.what());
+    }
+    catch(...) {
+        error = "Handler exception (unknown type)";
+    }
+    std::lock_guard<std::mutex>     lock(outMutex);
+    fgout.writeCaptured(handlerOut.str());
+    fgout << ": " << error;
+    if (respond) {
+        if (!response.empty()) {
+            int     bytesSent = send(sockClient,response.data(),int(response.size()),0);
+            shutdown(sockClient,SD_SEND);
+            if (bytesSent != int(response.size()))
+                fgout << "TCP SEND ERROR: " << bytesSent << " (of " << response.size() << ").";
+        }
+        closesocket(sockClient);
+    }
+    fgout << std::flush;
+    return handlerRetval;
+}
+
 void
 fgTcpServer(
     uint16              port,
     bool                respond,
     FgFuncTcpHandler    handler,
-    size_t              maxRecvBytes)
+    size_t              maxRecvBytes,
+    uint                maxConcurrent,
+    bool                loopbackOnly,
+    FgFuncTcpListening const & listening)
 {
     initWinsock();
     SOCKET      sockListen = INVALID_SOCKET;
@@ -157,7 +238,7 @@ fgTcpServer(
     hints.ai_protocol = IPPROTO_TCP;
     hints.ai_flags = AI_PASSIVE;
     struct addrinfo     *addrInfoPtr = NULL;
-    int itmp = getaddrinfo(NULL,toStr(port).c_str(),&hints,&addrInfoPtr);
+    int itmp = getaddrinfo(loopbackOnly ? "127.0.0.1" : NULL,toStr(port).c_str(),&hints,&addrInfoPtr);
     FGASSERT1(itmp == 0,toStr(itmp));
     sockListen = socket(addrInfoPtr->ai_family,addrInfoPtr->ai_socktype,addrInfoPtr->ai_protocol);
     if (sockListen == INVALID_SOCKET) {
@@ -177,19 +258,46 @@ fgTcpServer(
         FGASSERT_FALSE1(toStr(WSAGetLastError()));
     }
     freeaddrinfo(addrInfoPtr);
+    if (listening) {
+        sockaddr_in     listenAddress;
+        int             sz = sizeof(listenAddress);
+        if (getsockname(sockListen,(sockaddr*)(&listenAddress),&sz) == SOCKET_ERROR) {
+            closesocket(sockListen);
+            FGASSERT_FALSE1(toStr(WSAGetLastError()));
+        }
+        listening(ntohs(listenAddress.sin_port));
+    }
 
+    // State shared with concurrent client threads:
+    std::mutex              outMutex,
+                            stateMutex;
+    std::condition_variable stateChanged;
+    uint                    numActive = 0;
+    bool                    stopping = false;
     // Receive messages and respond until finished:
     SOCKET      sockClient;
     bool        handlerRetval = true;
+    int         acceptErr = 0;          // Non-zero if 'accept' failed other than by closing
     do {
-        fgout << fgnl << "> " << std::flush;
+        {
+            std::lock_guard<std::mutex>     lock(outMutex);
+            fgout << fgnl << "> " << std::flush;
+        }
         sockaddr_in     sa;
         sa.sin_family = AF_INET;
         socklen_t       sz = sizeof(sa);
         sockClient = accept(sockListen,(sockaddr*)(&sa),&sz);
         if (sockClient == INVALID_SOCKET) {
-            closesocket(sockListen);
-            FGASSERT_FALSE1(toStr(WSAGetLastError()));
+            int                             err = WSAGetLastError();
+            std::lock_guard<std::mutex>     lock(stateMutex);
+            if (stopping)                   // Listen socket was closed by a client thread
+                break;
+            // Interrupted or the client disconnected before being accepted:
+            if ((err == WSAEINTR) || (err == WSAECONNRESET))
+                continue;
+            // Can't throw until client threads are done with the state above:
+            acceptErr = err;
+            break;
         }
         // Set the timeout. Very important since the default is to never time out so in some
         // cases a broken connection causes 'recv' below to block forever:
@@ -198,57 +306,38 @@ fgTcpServer(
 		char * clientStringPtr = inet_ntoa(sa.sin_addr);
             FGASSERT(clientStringPtr != NULL);
         String     ipAddr = String(clientStringPtr);
-        //fgout << "receiving from " << ipAddr << " ... " << std::flush;
-        String     dataBuff;
-        int retVal = 0;
-        do {
-            char    recvbuf[1024];
-            // recv() will return when either it has filled the buffer, copied over everthing
-            // from the socket input buffer (only if non-empty), or when the the read connection
-            // is closed by the client. Otherwise it will block (ie if input buffer empty):
-            retVal = recv(sockClient,recvbuf,sizeof(recvbuf),0);
-            fgout << "." << std::flush;
-            if (retVal > 0)
-                dataBuff += String(recvbuf,retVal);
-        }
-        while ((retVal > 0) && (dataBuff.size() <= maxRecvBytes));
-        if (retVal != 0) {
-            closesocket(sockClient);
-            if (retVal < 0)
-                fgout << "TCP RECV ERROR: " << retVal;
-            else if (retVal > 0)
-                fgout << " OVERSIZE MESSAGE IGNORED.";
-            fgout << std::flush;
-            continue;
-        }
-        fgout << ": " << std::flush;
-        if (!respond)   // Avoid timeout errors on the data socket for long handlers that don't respond:
-            closesocket(sockClient);
-        String     response;
-        try {
-            handlerRetval = handler(ipAddr,dataBuff,response);
-        }
-        catch(FgException const & e) {
-            fgout << "Handler exception (FG exception): " << e.no_tr_message();
-        }
-        catch(std::exception const & e) {
-            fgout << "Handler exception (std::exception): " << e.what();
-        }
-        catch(...) {
-            fgout << "Handler exception (unknown type)";
-        }
-        if (respond) {
-            if (!response.empty()) {
-                int     bytesSent = send(sockClient,response.data(),int(response.size()),0);
-                shutdown(sockClient,SD_SEND);
-                if (bytesSent != int(response.size()))
-                    fgout << "TCP SEND ERROR: " << bytesSent << " (of " << response.size() << ").";
+        if (maxConcurrent <= 1)
+            handlerRetval = serveClient(sockClient,ipAddr,respond,handler,maxRecvBytes,outMutex,false);
+        else {
+            std::unique_lock<std::mutex>    lock(stateMutex);
+            stateChanged.wait(lock,[&]{return (numActive < maxConcurrent) || stopping; });
+            if (stopping) {
+                closesocket(sockClient);
+                break;
             }
-            closesocket(sockClient);
+            ++numActive;
+            auto            serve = [&,sockClient,ipAddr]()
+            {
+                bool            ret = serveClient(sockClient,ipAddr,respond,handler,maxRecvBytes,outMutex,true);
+                std::lock_guard<std::mutex>     lock(stateMutex);
+                if (!ret && !stopping) {
+                    stopping = true;
+                    closesocket(sockListen);        // Wake the 'accept' call
+                }
+                --numActive;
+                stateChanged.notify_all();
+            };
+            std::thread(serve).detach();
         }
-        fgout << std::flush;
     } while (handlerRetval == true);
-    closesocket(sockListen);
+    // Wait for client threads to finish since they reference the above state:
+    std::unique_lock<std::mutex>    lock(stateMutex);
+    stateChanged.wait(lock,[&]{return (numActive == 0); });
+    if (!stopping)
+        closesocket(sockListen);
+    lock.unlock();
+    if (acceptErr != 0)
+        fgThrow("TCP server accept failed",toStr(acceptErr));
 }
 
 }